@@ -2,15 +2,20 @@
 
 layout(location = 0) in vec4 vertPos;
 layout(location = 1) in vec2 texCoord;
+// Per-instance, occupies locations 2 through 5
+layout(location = 2) in mat4 instancePlacement;
 
-uniform mat4 perspective;
-uniform mat4 placement;
+// Per-frame camera data, shared by every program at binding point 0
+layout(std140) uniform Camera {
+  mat4 perspective;
+  mat4 placement;
+};
 
 out vec3 vert_col;
 out vec2 vert_texCoord;
 
 void main() {
-  gl_Position = perspective * placement * vertPos;
+  gl_Position = perspective * placement * instancePlacement * vertPos;
   vert_col = vec3(1.f, 0.f, 0.f);
   vert_texCoord = texCoord;
 }
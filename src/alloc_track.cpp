@@ -0,0 +1,427 @@
+#include "alloc_track.h"
+
+#ifdef ALLOC_TRACKING
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#  include <sys/resource.h>
+#endif
+
+#include <atomic>
+#include <new>
+
+struct AllocCounters {
+  uint64_t allocs;
+  uint64_t bytes;
+  uint64_t frees;
+  uint64_t liveAllocs; // Not freed yet
+  uint64_t liveBytes;
+  uint64_t endAllocs; // Live when the phase ended
+  uint64_t endBytes;
+};
+
+struct AllocPhase {
+  const char *name;
+  AllocCounters tags[ALLOC_TAGS];
+  uint64_t peakHeap; // Most bytes live at once (from any phase) during it
+  long peakResident; // Process high water mark in kB at its end, 0 unknown
+};
+
+// A live block
+struct AllocRecord {
+  uintptr_t address; // 0 for an empty slot
+  uint64_t size;
+  uint8_t tag;
+  uint8_t phase;
+};
+
+static const char *tagNames[ALLOC_TAGS] = {
+  "other", "archive", "image", "mesh", "shader", "texture"
+};
+
+// Everything below is guarded by lock. The hooks can run before main and
+// on any thread, so it is a spin lock that needs no construction.
+static std::atomic_flag lock = ATOMIC_FLAG_INIT;
+static AllocRecord *records = NULL; // Open addressing on the address
+static size_t capacity = 0; // Power of 2
+static size_t used = 0;
+static AllocPhase phases[ALLOC_MAX_PHASES] = {{"(no phase)"}};
+static int phaseCount = 1;
+static int currentPhase = 0;
+static uint64_t heapBytes = 0;
+static uint64_t totalAllocs = 0;
+static uint64_t totalBytes = 0;
+
+// Initial exec so reading it never calls into the allocator
+#if defined(__GNUC__)
+static thread_local AllocTag currentTag
+  __attribute__((tls_model("initial-exec"))) = ALLOC_OTHER;
+#else
+static thread_local AllocTag currentTag = ALLOC_OTHER;
+#endif
+
+// The table's own memory comes from the real allocator
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *p);
+}
+
+static void *rawCalloc(size_t count, size_t size) {
+  return __libc_calloc(count, size);
+}
+
+static void rawFree(void *p) {
+  __libc_free(p);
+}
+#else
+static void *rawCalloc(size_t count, size_t size) {
+  return calloc(count, size);
+}
+
+static void rawFree(void *p) {
+  free(p);
+}
+#endif
+
+static void lockAcquire() {
+  while(lock.test_and_set(std::memory_order_acquire)) {
+  }
+}
+
+static void lockRelease() {
+  lock.clear(std::memory_order_release);
+}
+
+static size_t slotOf(uintptr_t address) {
+  // Blocks are at least 16 byte aligned, mix the bits above that
+  return (size_t) (((uint64_t) (address >> 4) * 0x9E3779B97F4A7C15ull) >> 32) &
+    (capacity - 1);
+}
+
+// Double the table, returns false if there is no memory for it
+static bool grow() {
+  size_t newCapacity = capacity > 0 ? capacity * 2 : 4096;
+  AllocRecord *newRecords = (AllocRecord *) rawCalloc(newCapacity,
+    sizeof(AllocRecord));
+  if(newRecords == NULL) {
+    return false;
+  }
+  AllocRecord *oldRecords = records;
+  size_t oldCapacity = capacity;
+  records = newRecords;
+  capacity = newCapacity;
+  for(size_t i = 0; i < oldCapacity; i++) {
+    if(oldRecords[i].address != 0) {
+      size_t slot = slotOf(oldRecords[i].address);
+      while(records[slot].address != 0) {
+        slot = (slot + 1) & (capacity - 1);
+      }
+      records[slot] = oldRecords[i];
+    }
+  }
+  rawFree(oldRecords);
+  return true;
+}
+
+// Store record in the table, returns false if there is no room for it.
+// Called with lock held.
+static bool insert(const AllocRecord &record) {
+  if((used + 1) * 2 > capacity && !grow()) {
+    return false;
+  }
+  size_t slot = slotOf(record.address);
+  while(records[slot].address != 0) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  records[slot] = record;
+  used++;
+  return true;
+}
+
+static void track(void *p, size_t size) {
+  if(p == NULL) {
+    return;
+  }
+  AllocRecord record;
+  record.address = (uintptr_t) p;
+  record.size = size;
+  record.tag = (uint8_t) currentTag;
+  lockAcquire();
+  record.phase = (uint8_t) currentPhase;
+  if(insert(record)) {
+    AllocPhase *phase = &phases[currentPhase];
+    AllocCounters *counters = &phase->tags[record.tag];
+    counters->allocs++;
+    counters->bytes += size;
+    counters->liveAllocs++;
+    counters->liveBytes += size;
+    heapBytes += size;
+    if(heapBytes > phase->peakHeap) {
+      phase->peakHeap = heapBytes;
+    }
+    totalAllocs++;
+    totalBytes += size;
+  }
+  lockRelease();
+}
+
+// Forget p, counting it as freed. Returns its record, with address 0 if it
+// was never recorded.
+static AllocRecord untrack(void *p) {
+  AllocRecord removed = {0, 0, 0, 0};
+  if(p == NULL) {
+    return removed;
+  }
+  lockAcquire();
+  if(capacity > 0) {
+    size_t mask = capacity - 1;
+    size_t i = slotOf((uintptr_t) p);
+    while(records[i].address != 0 && records[i].address != (uintptr_t) p) {
+      i = (i + 1) & mask;
+    }
+    // Blocks from before the table had room, or from allocators that
+    // aren't hooked, were never recorded
+    if(records[i].address != 0) {
+      removed = records[i];
+      AllocCounters *counters =
+        &phases[records[i].phase].tags[records[i].tag];
+      counters->frees++;
+      counters->liveAllocs--;
+      counters->liveBytes -= records[i].size;
+      heapBytes -= records[i].size;
+      used--;
+
+      // Shift later records of the probe run back into the hole
+      size_t j = i;
+      for(;;) {
+        j = (j + 1) & mask;
+        if(records[j].address == 0) {
+          break;
+        }
+        size_t home = slotOf(records[j].address);
+        bool between = i <= j ? (home > i && home <= j) :
+          (home > i || home <= j);
+        if(!between) {
+          records[i] = records[j];
+          i = j;
+        }
+      }
+      records[i].address = 0;
+    }
+  }
+  lockRelease();
+  return removed;
+}
+
+// Put back a block untrack removed that turned out not to be freed, with
+// its original tag and phase
+static void retrack(const AllocRecord &record) {
+  if(record.address == 0) {
+    return;
+  }
+  lockAcquire();
+  if(insert(record)) {
+    AllocCounters *counters = &phases[record.phase].tags[record.tag];
+    counters->frees--;
+    counters->liveAllocs++;
+    counters->liveBytes += record.size;
+    heapBytes += record.size;
+    if(heapBytes > phases[currentPhase].peakHeap) {
+      phases[currentPhase].peakHeap = heapBytes;
+    }
+  }
+  lockRelease();
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void *malloc(size_t size) {
+  void *p = __libc_malloc(size);
+  track(p, size);
+  return p;
+}
+
+void *calloc(size_t count, size_t size) {
+  void *p = __libc_calloc(count, size);
+  track(p, count * size);
+  return p;
+}
+
+void *realloc(void *p, size_t size) {
+  // Forget p before it can be freed: once it is, another thread's malloc
+  // may get the same address and record it before we could untrack ours
+  AllocRecord old = untrack(p);
+  void *q = __libc_realloc(p, size);
+  // On failure p is untouched, realloc(p, 0) frees it
+  if(q != NULL || size == 0) {
+    track(q, size);
+  } else {
+    retrack(old);
+  }
+  return q;
+}
+
+void free(void *p) {
+  untrack(p);
+  __libc_free(p);
+}
+
+void *memalign(size_t alignment, size_t size) {
+  void *p = __libc_memalign(alignment, size);
+  track(p, size);
+  return p;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) {
+  if(alignment % sizeof(void *) != 0 ||
+    (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  void *p = memalign(alignment, size);
+  if(p == NULL) {
+    return ENOMEM;
+  }
+  *out = p;
+  return 0;
+}
+}
+#else
+void *operator new(size_t size) {
+  void *p = malloc(size > 0 ? size : 1);
+  if(p == NULL) {
+    throw std::bad_alloc();
+  }
+  track(p, size);
+  return p;
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+  untrack(p);
+  free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  operator delete(p);
+}
+#endif
+
+AllocTag allocTagPush(AllocTag tag) {
+  AllocTag previous = currentTag;
+  if(previous == ALLOC_OTHER) {
+    currentTag = tag;
+  }
+  return previous;
+}
+
+void allocTagPop(AllocTag previous) {
+  currentTag = previous;
+}
+
+// Process high water mark in kB, 0 where unknown
+static long peakResident() {
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#  ifdef __APPLE__
+  return usage.ru_maxrss / 1024; // Bytes there
+#  else
+  return usage.ru_maxrss;
+#  endif
+#endif
+}
+
+void allocPhaseBegin(const char *name) {
+  lockAcquire();
+  if(phaseCount < ALLOC_MAX_PHASES) {
+    memset(&phases[phaseCount], 0, sizeof(AllocPhase));
+    phases[phaseCount].name = name;
+    currentPhase = phaseCount++;
+  } else {
+    currentPhase = ALLOC_MAX_PHASES - 1;
+  }
+  if(heapBytes > phases[currentPhase].peakHeap) {
+    phases[currentPhase].peakHeap = heapBytes;
+  }
+  lockRelease();
+}
+
+void allocPhaseEnd() {
+  long resident = peakResident();
+  lockAcquire();
+  AllocPhase *phase = &phases[currentPhase];
+  for(int tag = 0; tag < ALLOC_TAGS; tag++) {
+    phase->tags[tag].endAllocs = phase->tags[tag].liveAllocs;
+    phase->tags[tag].endBytes = phase->tags[tag].liveBytes;
+  }
+  phase->peakResident = resident;
+  currentPhase = 0;
+  lockRelease();
+}
+
+void allocReport(FILE *fp) {
+  // Printing allocates, copy everything out first
+  static AllocPhase snapshot[ALLOC_MAX_PHASES];
+  lockAcquire();
+  int count = phaseCount;
+  memcpy(snapshot, phases, sizeof(phases));
+  uint64_t heap = heapBytes;
+  lockRelease();
+
+  fprintf(fp, "Heap allocations by phase (%.2f MB live now, peak resident "
+    "%.1f MB)\n", heap / 1e6, peakResident() / 1e3);
+  fprintf(fp, "%-20s %-8s %10s %12s %10s %10s %12s %10s %12s\n", "phase",
+    "tag", "allocs", "bytes", "frees", "end allocs", "end bytes",
+    "live", "live bytes");
+  for(int i = 0; i < count; i++) {
+    const AllocPhase *phase = &snapshot[i];
+    bool any = false;
+    for(int tag = 0; tag < ALLOC_TAGS; tag++) {
+      const AllocCounters *c = &phase->tags[tag];
+      if(c->allocs == 0) {
+        continue;
+      }
+      any = true;
+      // The row still open (no phase) has no end, show what is live now
+      bool ended = i > 0;
+      fprintf(fp, "%-20s %-8s %10llu %12llu %10llu %10llu %12llu %10llu "
+        "%12llu\n", phase->name, tagNames[tag],
+        (unsigned long long) c->allocs, (unsigned long long) c->bytes,
+        (unsigned long long) c->frees,
+        (unsigned long long) (ended ? c->endAllocs : c->liveAllocs),
+        (unsigned long long) (ended ? c->endBytes : c->liveBytes),
+        (unsigned long long) c->liveAllocs,
+        (unsigned long long) c->liveBytes);
+    }
+    if(any && i > 0) {
+      fprintf(fp, "%-20s peak heap %.2f MB, peak resident %.1f MB\n", "",
+        phase->peakHeap / 1e6, phase->peakResident / 1e3);
+    }
+  }
+}
+
+void allocTotals(uint64_t *count, uint64_t *bytes) {
+  lockAcquire();
+  *count = totalAllocs;
+  *bytes = totalBytes;
+  lockRelease();
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef ALLOC_TRACK_H
+#define ALLOC_TRACK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Heap allocation accounting by subsystem and loading phase, built in with
+// -DTRACK_ALLOCS=ON (which defines ALLOC_TRACKING). malloc, calloc, realloc,
+// the aligned allocators and free are replaced with versions that record
+// every block's size, tag and phase (on glibc; elsewhere only operator new
+// and delete are covered), so the report can say what each phase allocated,
+// what it still held when it ended and what is still live.
+//
+// Without ALLOC_TRACKING the tags and phases compile to nothing.
+
+// Subsystem an allocation is charged to. The outermost tagged function on
+// the stack wins: the file buffer imageLoad reads through the archive counts
+// as ALLOC_IMAGE.
+enum AllocTag {
+  ALLOC_OTHER,
+  ALLOC_ARCHIVE, // Asset archive and loose file reads
+  ALLOC_IMAGE, // bmp decoding
+  ALLOC_MESH, // OBJ parsing, resizeMesh, the mesh pool
+  ALLOC_SHADER, // Shader sources, compiling and linking (driver included)
+  ALLOC_TEXTURE, // GL textures and software mip chains
+  ALLOC_TAGS
+};
+
+// Phases past this many are counted with the last one
+#define ALLOC_MAX_PHASES 32
+
+#ifdef ALLOC_TRACKING
+
+// Charge allocations on this thread to tag until allocTagPop, unless an
+// outer tag is already set. Returns what allocTagPop restores.
+AllocTag allocTagPush(AllocTag tag);
+void allocTagPop(AllocTag previous);
+
+// Count allocations (from any thread) to the named phase until
+// allocPhaseEnd. Phases don't nest; allocations outside them go to a
+// "(no phase)" row.
+void allocPhaseBegin(const char *name);
+void allocPhaseEnd();
+
+// Print each phase's allocations per tag: how many and how large, how many
+// of them were freed, what was still live when the phase ended and what is
+// live now, with the peak heap during the phase and the process's resident
+// high water mark at its end. Whatever is live at exit is a leak.
+void allocReport(FILE *fp);
+
+// Allocations and bytes allocated since the program started
+void allocTotals(uint64_t *count, uint64_t *bytes);
+
+// Tags the rest of the enclosing block
+struct AllocTagScope {
+  AllocTag previous;
+  AllocTagScope(AllocTag tag) { previous = allocTagPush(tag); }
+  ~AllocTagScope() { allocTagPop(previous); }
+};
+
+#define ALLOC_CONCAT2(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT2(a, b)
+#define ALLOC_TAG(tag) AllocTagScope ALLOC_CONCAT(allocTagScope, __LINE__)(tag)
+
+#else
+
+#define ALLOC_TAG(tag)
+
+inline void allocPhaseBegin(const char *) {}
+inline void allocPhaseEnd() {}
+inline void allocReport(FILE *) {}
+
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define ARENA_ALIGN 16
+
+struct ArenaBlock {
+  ArenaBlock *next;
+  size_t size; // Bytes of data after the header
+};
+
+// First data byte, ARENA_ALIGN aligned
+static char *blockData(ArenaBlock *block) {
+  return (char *) (((uintptr_t) (block + 1) + ARENA_ALIGN - 1) &
+    ~(uintptr_t) (ARENA_ALIGN - 1));
+}
+
+void arenaInit(Arena *arena, size_t blockSize) {
+  arena->blocks = NULL;
+  arena->cursor = NULL;
+  arena->end = NULL;
+  arena->blockSize = blockSize;
+  arena->allocated = 0;
+}
+
+// Start a new block with room for at least size bytes
+static bool arenaGrow(Arena *arena, size_t size) {
+  // Oversized blocks are rounded up too, so end stays aligned and the next
+  // aligned start can't land past it
+  size_t dataSize = size > arena->blockSize ?
+    (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1) : arena->blockSize;
+  ArenaBlock *block = (ArenaBlock *) malloc(sizeof(ArenaBlock) +
+    ARENA_ALIGN - 1 + dataSize);
+  if(block == NULL) {
+    return false;
+  }
+  block->next = arena->blocks;
+  block->size = dataSize;
+  if(arena->blockSize < ARENA_MAX_BLOCK_SIZE) {
+    arena->blockSize *= 2;
+  }
+  arena->blocks = block;
+  arena->cursor = blockData(block);
+  arena->end = arena->cursor + dataSize;
+  return true;
+}
+
+void *arenaAlloc(Arena *arena, size_t size, size_t align) {
+  uintptr_t start = ((uintptr_t) arena->cursor + align - 1) &
+    ~(uintptr_t) (align - 1);
+  // Padding can still take start past end; the difference would wrap
+  if(arena->cursor == NULL || start > (uintptr_t) arena->end ||
+    size > (size_t) (arena->end - (char *) start)) {
+    // Fresh blocks are ARENA_ALIGN aligned
+    if(!arenaGrow(arena, size)) {
+      return NULL;
+    }
+    start = (uintptr_t) arena->cursor;
+  }
+  arena->cursor = (char *) start + size;
+  arena->allocated += size;
+  return (void *) start;
+}
+
+void arenaFree(Arena *arena, void *p, size_t size) {
+  if(p != NULL && (char *) p + size == arena->cursor) {
+    arena->cursor = (char *) p;
+    arena->allocated -= size;
+  }
+}
+
+void arenaDestroy(Arena *arena) {
+  ArenaBlock *block = arena->blocks;
+  while(block != NULL) {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  arena->blocks = NULL;
+  arena->cursor = NULL;
+  arena->end = NULL;
+  arena->allocated = 0;
+}
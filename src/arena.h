@@ -0,0 +1,86 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#include <new>
+
+// Blocks double in size up to this, so small loads stay small and large
+// ones make few blocks
+#define ARENA_MAX_BLOCK_SIZE (4 << 20)
+
+// Bump allocator for short lived data that all dies together, like the
+// parse structures of one file load. Allocations are carved out of large
+// blocks front to back; there is no per allocation free (arenaFree only
+// takes back the latest one), everything goes at once with arenaDestroy.
+
+struct ArenaBlock;
+
+struct Arena {
+  ArenaBlock *blocks; // Newest first
+  char *cursor; // Next free byte in the newest block
+  char *end;
+  size_t blockSize; // Bytes in the next block, larger allocations get their own
+  size_t allocated; // Bytes handed out
+};
+
+// blockSize is the first block's size
+void arenaInit(Arena *arena, size_t blockSize);
+
+// size bytes aligned to align (a power of 2 up to 16), NULL if out of memory
+void *arenaAlloc(Arena *arena, size_t size, size_t align);
+
+// Return the block at p if it is the latest allocation (a vector growing
+// with nothing allocated after it), otherwise do nothing
+void arenaFree(Arena *arena, void *p, size_t size);
+
+void arenaDestroy(Arena *arena);
+
+// std allocator over an arena, for containers that only live as long as it
+// does: std::vector<int, ArenaAllocator<int> > list(ArenaAllocator<int>(&a))
+template <typename T>
+struct ArenaAllocator {
+  typedef T value_type;
+  template <typename U> struct rebind { typedef ArenaAllocator<U> other; };
+
+  Arena *arena;
+
+  explicit ArenaAllocator(Arena *arena) : arena(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t count) {
+    void *p = arenaAlloc(arena, count * sizeof(T),
+      alignof(T) < 16 ? alignof(T) : 16);
+    if(p == NULL) {
+      throw std::bad_alloc();
+    }
+    return (T *) p;
+  }
+
+  void deallocate(T *p, size_t count) {
+    arenaFree(arena, p, count * sizeof(T));
+  }
+};
+
+// Arena for the rest of the enclosing block. Declare it before the
+// containers using it so they are destroyed first.
+struct ArenaScope {
+  Arena arena;
+  explicit ArenaScope(size_t blockSize) { arenaInit(&arena, blockSize); }
+  ~ArenaScope() { arenaDestroy(&arena); }
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T> &a,
+  const ArenaAllocator<U> &b) {
+  return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T> &a,
+  const ArenaAllocator<U> &b) {
+  return a.arena != b.arena;
+}
+
+#endif
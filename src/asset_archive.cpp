@@ -0,0 +1,281 @@
+#include "asset_archive.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#include "alloc_track.h"
+
+// Map the whole file read only
+static bool mapFile(AssetArchive *archive, const char *path) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  HANDLE mapping = NULL;
+  const void *view = NULL;
+  if(GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  }
+  if(mapping != NULL) {
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  }
+  if(view == NULL) {
+    if(mapping != NULL) {
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    return false;
+  }
+  archive->file = file;
+  archive->mapping = mapping;
+  archive->base = (const char *) view;
+  archive->length = (size_t) size.QuadPart;
+  return true;
+#else
+  int fd = open(path, O_RDONLY);
+  if(fd < 0) {
+    return false;
+  }
+  struct stat info;
+  void *view = MAP_FAILED;
+  if(fstat(fd, &info) == 0 && info.st_size > 0) {
+    view = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  // The mapping keeps the file alive
+  close(fd);
+  if(view == MAP_FAILED) {
+    return false;
+  }
+  // Everything in it is about to be read, so start reading ahead in large
+  // sequential chunks instead of faulting pages in one by one
+  madvise(view, info.st_size, MADV_WILLNEED);
+  archive->base = (const char *) view;
+  archive->length = info.st_size;
+  return true;
+#endif
+}
+
+static void unmapFile(AssetArchive *archive) {
+#ifdef _WIN32
+  UnmapViewOfFile(archive->base);
+  CloseHandle(archive->mapping);
+  CloseHandle(archive->file);
+  archive->file = archive->mapping = NULL;
+#else
+  munmap((void *) archive->base, archive->length);
+#endif
+  archive->base = NULL;
+  archive->length = 0;
+}
+
+// Whether every entry lies inside the archive, and the names are sorted
+static bool checkEntries(const AssetArchive *archive) {
+  for(uint32_t i = 0; i < archive->count; i++) {
+    const ArchiveEntry *entry = &archive->entries[i];
+    if(memchr(entry->name, '\0', ARCHIVE_NAME_MAX) == NULL ||
+      entry->offset > archive->length ||
+      entry->storedSize > archive->length - entry->offset) {
+      return false;
+    }
+    if(!(entry->flags & ARCHIVE_LZ4) && entry->storedSize != entry->size) {
+      return false;
+    }
+    if(i > 0 && strcmp(archive->entries[i - 1].name, entry->name) >= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool archiveOpen(AssetArchive *archive, const char *path) {
+  ALLOC_TAG(ALLOC_ARCHIVE);
+  archive->base = NULL;
+  archive->length = 0;
+  archive->entries = NULL;
+  archive->count = 0;
+  archive->root.clear();
+#ifdef _WIN32
+  archive->file = archive->mapping = NULL;
+#endif
+
+  if(!mapFile(archive, path)) {
+    return false;
+  }
+
+  const ArchiveHeader *header = (const ArchiveHeader *) archive->base;
+  bool ok = archive->length >= sizeof(ArchiveHeader) &&
+    header->magic == ARCHIVE_MAGIC && header->version == ARCHIVE_VERSION &&
+    header->count <= (archive->length - sizeof(ArchiveHeader)) /
+      sizeof(ArchiveEntry);
+  if(ok) {
+    archive->entries = (const ArchiveEntry *) (header + 1);
+    archive->count = header->count;
+    ok = checkEntries(archive);
+  }
+  if(!ok) {
+    fprintf(stderr, "%s is not a valid asset archive\n", path);
+    unmapFile(archive);
+    archive->entries = NULL;
+    archive->count = 0;
+    return false;
+  }
+
+  const char *slash = strrchr(path, '/');
+#ifdef _WIN32
+  const char *backslash = strrchr(path, '\\');
+  if(backslash != NULL && (slash == NULL || backslash > slash)) {
+    slash = backslash;
+  }
+#endif
+  if(slash != NULL) {
+    archive->root.assign(path, slash + 1);
+  }
+  return true;
+}
+
+const ArchiveEntry *archiveFind(const AssetArchive *archive, const char *name) {
+  // Binary search, the table is sorted by name
+  uint32_t low = 0, high = archive->count;
+  while(low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    int order = strcmp(archive->entries[middle].name, name);
+    if(order == 0) {
+      return &archive->entries[middle];
+    }
+    if(order < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return NULL;
+}
+
+void archiveClose(AssetArchive *archive) {
+  if(archive->base != NULL) {
+    unmapFile(archive);
+  }
+  archive->entries = NULL;
+  archive->count = 0;
+  archive->root.clear();
+}
+
+// Hand out the entry's bytes, decompressing them if needed
+static bool readEntry(const AssetArchive *archive, const ArchiveEntry *entry,
+  VirtualFile *file) {
+  const char *stored = archive->base + entry->offset;
+  if(!(entry->flags & ARCHIVE_LZ4)) {
+    file->data = stored;
+    file->size = entry->size;
+    return true;
+  }
+#ifdef USE_LZ4
+  file->owned = (char *) malloc(entry->size > 0 ? entry->size : 1);
+  int size = -1;
+  if(file->owned != NULL) {
+    size = LZ4_decompress_safe(stored, file->owned, (int) entry->storedSize,
+      (int) entry->size);
+  }
+  if(size < 0 || (uint64_t) size != entry->size) {
+    fprintf(stderr, "Error decompressing %s\n", entry->name);
+    free(file->owned);
+    file->owned = NULL;
+    return false;
+  }
+  file->data = file->owned;
+  file->size = entry->size;
+  return true;
+#else
+  fprintf(stderr, "%s is LZ4 compressed, build with USE_LZ4 to read it\n",
+    entry->name);
+  return false;
+#endif
+}
+
+// Read a loose file into an owned buffer
+static bool readDisk(const char *path, VirtualFile *file) {
+  FILE *fp = fopen(path, "rb");
+  if(fp == NULL) {
+    return false;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  rewind(fp);
+  if(size < 0) {
+    fclose(fp);
+    return false;
+  }
+  file->owned = (char *) malloc(size > 0 ? size : 1);
+  if(file->owned == NULL ||
+    (size > 0 && fread(file->owned, size, 1, fp) != 1)) {
+    free(file->owned);
+    file->owned = NULL;
+    fclose(fp);
+    return false;
+  }
+  fclose(fp);
+  file->data = file->owned;
+  file->size = size;
+  return true;
+}
+
+bool virtualFileOpen(const AssetArchive *archive, const char *path,
+  VirtualFile *file) {
+  ALLOC_TAG(ALLOC_ARCHIVE);
+  file->data = NULL;
+  file->size = 0;
+  file->owned = NULL;
+
+  if(archive != NULL && archive->base != NULL &&
+    strncmp(path, archive->root.c_str(), archive->root.size()) == 0) {
+    const ArchiveEntry *entry = archiveFind(archive,
+      path + archive->root.size());
+    if(entry != NULL) {
+      return readEntry(archive, entry, file);
+    }
+  }
+  return readDisk(path, file);
+}
+
+void virtualFileClose(VirtualFile *file) {
+  free(file->owned);
+  file->data = NULL;
+  file->size = 0;
+  file->owned = NULL;
+}
+
+char *textfileRead(const AssetArchive *archive, const char *fn) {
+  ALLOC_TAG(ALLOC_SHADER);
+  VirtualFile file;
+  char *content = NULL;
+  if(fn != NULL) {
+    if(virtualFileOpen(archive, fn, &file)) {
+      if(file.size > 0) {
+        content = (char *) malloc(sizeof(char) * (file.size + 1));
+        memcpy(content, file.data, file.size);
+        content[file.size] = '\0';
+      }
+      virtualFileClose(&file);
+    } else {
+      printf("error loading %s\n", fn);
+    }
+  }
+  return content;
+}
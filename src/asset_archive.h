@@ -0,0 +1,84 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+// Assets packed into one file so loading is a single mapping read mostly
+// front to back instead of an open, seek and read per file. Built by
+// tools/asset_pack.cpp.
+//
+// Layout: an ArchiveHeader, the table of contents (count ArchiveEntry sorted
+// by name), then each entry's data starting on an ARCHIVE_ALIGN boundary.
+// Names are paths relative to the directory holding the archive.
+
+#define ARCHIVE_MAGIC 0x31524154 // "TAR1"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_ALIGN 4096
+#define ARCHIVE_NAME_MAX 96
+
+// Entry flags
+#define ARCHIVE_LZ4 1 // Stored as one LZ4 block, needs USE_LZ4 to read
+
+struct ArchiveHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t count;
+  uint32_t pad;
+};
+
+struct ArchiveEntry {
+  char name[ARCHIVE_NAME_MAX]; // Zero terminated
+  uint64_t offset; // From the start of the archive
+  uint64_t storedSize; // Bytes in the archive
+  uint64_t size; // Bytes once decompressed
+  uint32_t flags;
+  uint32_t pad;
+};
+
+struct AssetArchive {
+  const char *base; // Whole archive mapped read only, NULL when not open
+  size_t length;
+  const ArchiveEntry *entries;
+  uint32_t count;
+  std::string root; // Directory of the archive, with the trailing slash
+#ifdef _WIN32
+  void *file, *mapping;
+#endif
+};
+
+// A file's contents, from the archive or from disk. data points into the
+// mapping when the entry is stored uncompressed; otherwise it is owned and
+// freed by virtualFileClose.
+struct VirtualFile {
+  const char *data;
+  size_t size;
+  char *owned;
+};
+
+// Map the archive at path and check its table of contents. Returns false,
+// leaving the archive closed, if it is missing or malformed.
+bool archiveOpen(AssetArchive *archive, const char *path);
+
+// Entry named name (relative to archive->root), NULL if there is none
+const ArchiveEntry *archiveFind(const AssetArchive *archive, const char *name);
+
+void archiveClose(AssetArchive *archive);
+
+// Read the file at path. Paths under the root of an open archive come from
+// the archive when it has them; everything else (or archive may be NULL) is
+// read from disk. Returns false if neither has it. A missing or unreadable
+// file is not reported here, since some lookups are optional (an OBJ's
+// material library); the caller says what failed.
+bool virtualFileOpen(const AssetArchive *archive, const char *path,
+  VirtualFile *file);
+
+void virtualFileClose(VirtualFile *file);
+
+// The whole file at path as a malloced, zero terminated string (shader
+// sources), NULL if it can't be read. The caller frees it.
+char *textfileRead(const AssetArchive *archive, const char *fn);
+
+#endif
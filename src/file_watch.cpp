@@ -0,0 +1,77 @@
+#include "file_watch.h"
+
+#ifdef __linux__
+
+#include <stdio.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+bool fileWatchInit(FileWatch *watch, const char *dir) {
+  watch->wd = -1;
+  watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if(watch->fd < 0) {
+    perror("inotify_init1");
+    return false;
+  }
+  // Closing a file opened for writing, or a rename into the directory
+  watch->wd = inotify_add_watch(watch->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+  if(watch->wd < 0) {
+    fprintf(stderr, "Can't watch %s\n", dir);
+    close(watch->fd);
+    watch->fd = -1;
+    return false;
+  }
+  return true;
+}
+
+void fileWatchPoll(FileWatch *watch, std::vector<std::string> *changed) {
+  if(watch->fd < 0) {
+    return;
+  }
+  // Aligned as the kernel writes struct inotify_event into it
+  char buffer[4096]
+    __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  for(;;) {
+    ssize_t length = read(watch->fd, buffer, sizeof(buffer));
+    // EAGAIN once the queue is empty
+    if(length <= 0) {
+      return;
+    }
+    for(char *p = buffer; p < buffer + length; ) {
+      const struct inotify_event *event = (const struct inotify_event *) p;
+      if(event->len > 0 && !(event->mask & IN_ISDIR)) {
+        changed->push_back(event->name);
+      }
+      p += sizeof(struct inotify_event) + event->len;
+    }
+  }
+}
+
+void fileWatchDestroy(FileWatch *watch) {
+  if(watch->fd >= 0) {
+    close(watch->fd);
+  }
+  watch->fd = -1;
+  watch->wd = -1;
+}
+
+#else
+
+bool fileWatchInit(FileWatch *watch, const char *dir) {
+  (void) dir;
+  watch->fd = -1;
+  watch->wd = -1;
+  return false;
+}
+
+void fileWatchPoll(FileWatch *watch, std::vector<std::string> *changed) {
+  (void) watch;
+  (void) changed;
+}
+
+void fileWatchDestroy(FileWatch *watch) {
+  watch->fd = -1;
+  watch->wd = -1;
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef FILE_WATCH_H
+#define FILE_WATCH_H
+
+#include <string>
+#include <vector>
+
+// Reports files in a directory that finished being written. Uses inotify on
+// Linux, where the whole directory is watched so editors that save through a
+// temporary file and a rename are caught as well. Elsewhere nothing is ever
+// reported.
+struct FileWatch {
+  int fd; // -1 when watching is unavailable
+  int wd;
+};
+
+// Start watching dir. Returns false (and the watch stays inert) if it can't.
+bool fileWatchInit(FileWatch *watch, const char *dir);
+
+// Append the names (relative to the directory) of files written since the
+// last call. Never blocks; the same name may show up more than once.
+void fileWatchPoll(FileWatch *watch, std::vector<std::string> *changed);
+
+void fileWatchDestroy(FileWatch *watch);
+
+#endif
@@ -0,0 +1,173 @@
+#include "frustum_cull.h"
+
+#include <stdlib.h>
+
+// Build with -mavx (USE_AVX in CMake) to test 8 boxes at a time, otherwise
+// SSE tests 4
+#if defined(__AVX__)
+#  include <immintrin.h>
+#  define CULL_WIDTH 8
+#elif defined(__SSE__) || defined(_M_X64)
+#  include <xmmintrin.h>
+#  define CULL_WIDTH 4
+#else
+#  define CULL_WIDTH 1
+#endif
+
+// Alignment of each SoA array
+#define AABB_ALIGN 32
+
+static float *allocFloats(size_t count) {
+#if CULL_WIDTH > 1
+  return (float *) _mm_malloc(count * sizeof(float), AABB_ALIGN);
+#else
+  return (float *) malloc(count * sizeof(float));
+#endif
+}
+
+static void freeFloats(float *data) {
+#if CULL_WIDTH > 1
+  _mm_free(data);
+#else
+  free(data);
+#endif
+}
+
+void aabbListResize(AABBList *boxes, size_t count) {
+  if(count > boxes->capacity || boxes->minX == NULL) {
+    aabbListFree(boxes);
+    // Round up so the vector loop never has to special case the capacity
+    size_t capacity = (count + 7) / 8 * 8;
+    if(capacity == 0) {
+      capacity = 8;
+    }
+    boxes->minX = allocFloats(capacity);
+    boxes->minY = allocFloats(capacity);
+    boxes->minZ = allocFloats(capacity);
+    boxes->maxX = allocFloats(capacity);
+    boxes->maxY = allocFloats(capacity);
+    boxes->maxZ = allocFloats(capacity);
+    boxes->capacity = capacity;
+  }
+  boxes->count = count;
+}
+
+void aabbListSet(AABBList *boxes, size_t i, const glm::vec3 &min,
+  const glm::vec3 &max) {
+  boxes->minX[i] = min.x;
+  boxes->minY[i] = min.y;
+  boxes->minZ[i] = min.z;
+  boxes->maxX[i] = max.x;
+  boxes->maxY[i] = max.y;
+  boxes->maxZ[i] = max.z;
+}
+
+void aabbListFree(AABBList *boxes) {
+  if(boxes->minX != NULL) {
+    freeFloats(boxes->minX);
+    freeFloats(boxes->minY);
+    freeFloats(boxes->minZ);
+    freeFloats(boxes->maxX);
+    freeFloats(boxes->maxY);
+    freeFloats(boxes->maxZ);
+  }
+  boxes->minX = boxes->minY = boxes->minZ = NULL;
+  boxes->maxX = boxes->maxY = boxes->maxZ = NULL;
+  boxes->count = boxes->capacity = 0;
+}
+
+void frustumFromMatrix(Frustum *frustum, const glm::mat4 &viewProj) {
+  // Gribb/Hartmann: each plane is the last row of the matrix plus or minus
+  // one of the others. glm is column major, so row r is m[0..3][r].
+  for(int i = 0; i < 3; i++) {
+    for(int c = 0; c < 4; c++) {
+      frustum->planes[2 * i][c] = viewProj[c][3] + viewProj[c][i];
+      frustum->planes[2 * i + 1][c] = viewProj[c][3] - viewProj[c][i];
+    }
+  }
+}
+
+// Whether box i is entirely behind any plane
+static bool boxOutside(const Frustum *frustum, const AABBList *boxes,
+  size_t i) {
+  for(int p = 0; p < 6; p++) {
+    const float *plane = frustum->planes[p];
+    // Corner furthest along the plane normal
+    float x = plane[0] > 0.f ? boxes->maxX[i] : boxes->minX[i];
+    float y = plane[1] > 0.f ? boxes->maxY[i] : boxes->minY[i];
+    float z = plane[2] > 0.f ? boxes->maxZ[i] : boxes->minZ[i];
+    if(plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.f) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t frustumCull(const Frustum *frustum, const AABBList *boxes,
+  unsigned *visible, CullStats *stats) {
+  size_t numVisible = 0;
+  size_t i = 0;
+
+  // The corner to test against a plane only depends on the signs of the
+  // plane normal, so pick the min or max array once per plane and test a
+  // whole vector of boxes against it
+#if CULL_WIDTH == 8
+  for(; i + 8 <= boxes->count; i += 8) {
+    __m256 outside = _mm256_setzero_ps();
+    for(int p = 0; p < 6; p++) {
+      const float *plane = frustum->planes[p];
+      __m256 x = _mm256_load_ps((plane[0] > 0.f ? boxes->maxX : boxes->minX) + i);
+      __m256 y = _mm256_load_ps((plane[1] > 0.f ? boxes->maxY : boxes->minY) + i);
+      __m256 z = _mm256_load_ps((plane[2] > 0.f ? boxes->maxZ : boxes->minZ) + i);
+      __m256 d = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane[0])),
+          _mm256_mul_ps(y, _mm256_set1_ps(plane[1]))),
+        _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane[2])),
+          _mm256_set1_ps(plane[3])));
+      outside = _mm256_or_ps(outside,
+        _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ));
+    }
+    int mask = _mm256_movemask_ps(outside);
+    for(int b = 0; b < 8; b++) {
+      if(!(mask & (1 << b))) {
+        visible[numVisible++] = (unsigned) (i + b);
+      }
+    }
+  }
+#elif CULL_WIDTH == 4
+  for(; i + 4 <= boxes->count; i += 4) {
+    __m128 outside = _mm_setzero_ps();
+    for(int p = 0; p < 6; p++) {
+      const float *plane = frustum->planes[p];
+      __m128 x = _mm_load_ps((plane[0] > 0.f ? boxes->maxX : boxes->minX) + i);
+      __m128 y = _mm_load_ps((plane[1] > 0.f ? boxes->maxY : boxes->minY) + i);
+      __m128 z = _mm_load_ps((plane[2] > 0.f ? boxes->maxZ : boxes->minZ) + i);
+      __m128 d = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[0])),
+          _mm_mul_ps(y, _mm_set1_ps(plane[1]))),
+        _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane[2])),
+          _mm_set1_ps(plane[3])));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(d, _mm_setzero_ps()));
+    }
+    int mask = _mm_movemask_ps(outside);
+    for(int b = 0; b < 4; b++) {
+      if(!(mask & (1 << b))) {
+        visible[numVisible++] = (unsigned) (i + b);
+      }
+    }
+  }
+#endif
+
+  // Leftover boxes past the last full vector
+  for(; i < boxes->count; i++) {
+    if(!boxOutside(frustum, boxes, i)) {
+      visible[numVisible++] = (unsigned) i;
+    }
+  }
+
+  if(stats != NULL) {
+    stats->visible = (unsigned) numVisible;
+    stats->culled = (unsigned) (boxes->count - numVisible);
+  }
+  return numVisible;
+}
@@ -0,0 +1,47 @@
+#ifndef FRUSTUM_CULL_H
+#define FRUSTUM_CULL_H
+
+#include <stddef.h>
+
+#include <glm/glm.hpp>
+
+// World space bounding boxes stored as structure of arrays, each array
+// 32 byte aligned so the culling loop can use aligned SSE/AVX loads
+struct AABBList {
+  float *minX, *minY, *minZ;
+  float *maxX, *maxY, *maxZ;
+  size_t count;
+  size_t capacity;
+};
+
+// Six planes (a, b, c, d) with normals pointing into the frustum, so a
+// point p is inside when a*p.x + b*p.y + c*p.z + d >= 0 for all of them
+struct Frustum {
+  float planes[6][4];
+};
+
+// Running totals from the last frustumCull call
+struct CullStats {
+  unsigned visible;
+  unsigned culled;
+};
+
+// Make room for count boxes, discarding the old contents if it grows
+void aabbListResize(AABBList *boxes, size_t count);
+
+// Store box i
+void aabbListSet(AABBList *boxes, size_t i, const glm::vec3 &min,
+  const glm::vec3 &max);
+
+void aabbListFree(AABBList *boxes);
+
+// Extract the frustum planes of a projection * view matrix
+void frustumFromMatrix(Frustum *frustum, const glm::mat4 &viewProj);
+
+// Write the index of every box at least partially inside the frustum to
+// visible, in increasing order. visible must hold boxes->count entries.
+// Returns the number of visible boxes.
+size_t frustumCull(const Frustum *frustum, const AABBList *boxes,
+  unsigned *visible, CullStats *stats);
+
+#endif
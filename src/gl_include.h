@@ -0,0 +1,9 @@
+#ifndef GL_INCLUDE_H
+#define GL_INCLUDE_H
+
+// Every file that calls OpenGL includes this instead of glew.h so that the
+// GLEE wrappers (enabled with -DUSE_GLEE=ON) cover the whole program.
+#include <GL/glew.h>
+#include "glee.hpp"
+
+#endif
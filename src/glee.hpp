@@ -18,9 +18,9 @@
 ///
 ///     GLEE is best used with a debugger, as assert(false) calls will halt the
 /// the debugger right at the error point and allow you to see where you are in
-/// the stack trace. Additionally, with a network connection and GLEE_NETWORKING
-/// defined, you can also get some handy info from the web brought directly to
-/// std::err about the nature of the OpenGL failure.
+/// the stack trace. Additionally, the error descriptions from the OpenGL
+/// reference pages for the failing function are brought directly to std::err
+/// from an offline copy embedded in glee_error_docs.hpp.
 ///
 ///     GLEE compiles with GNU C++ (##__VA_ARGS__ is the culprit). So just about
 /// every compiler supports it, and any warnings you get about GNU should be
@@ -55,6 +55,16 @@
 ///     o  GLEE_OVERWRITE_GL_FUNCTIONS
 ///         *  GLEE_CHECK_UNIFORM_LOCATIONS
 ///         *  GLEE_NETWORKING
+///         *  GLEE_DEFERRED_ERROR_CHECKS
+///             -  GLEE_DEFERRED_CHECK_INTERVAL
+///             -  GLEE_DEFERRED_HISTORY_LENGTH
+///         *  GLEE_TRACE_CALLS
+///             -  GLEE_TRACE_FILE_NAME
+///         *  GLEE_CALL_STATISTICS
+///             -  GLEE_STATISTICS_FRAME_INTERVAL
+///             -  GLEE_STATISTICS_TOP_N
+///         *  GLEE_PERF_LINT
+///             -  GLEE_LINT_FRAMES_IN_FLIGHT
 ///     o  GLEE_GL_HEADER_PATH
 ///
 ////////////////////////////////////////////////////////////////////////////////
@@ -63,8 +73,9 @@
 ///     1. Customization
 ///     2. Includes
 ///     3. Error Checking Mechanisms
-///     4. Networking
-///     5. OpenGL Redifinitions
+///     4. Call Tracing, Statistics and Perf Lint
+///     5. Networking
+///     6. OpenGL Redifinitions
 ///
 
 #ifndef glee_hpp
@@ -100,9 +111,11 @@
 ///
 /// DISCUSSION
 ///
-///     Define this macro to enable OpenGL error checking to additionally
-/// try and find the web page for the failing function and report in more
-/// detail the nature of the failure directly in the commandline.
+///     Define this macro to make RequestOpenGLAPIErrorInfoForFunction fetch
+/// and parse the reference page for a function from the web. Failures no
+/// longer go through the network (they use the offline copy in
+/// glee_error_docs.hpp), so this is only needed to regenerate that file with
+/// the glee_docgen tool.
 ///
 /// NOTES
 ///
@@ -113,6 +126,163 @@
 
 //#define GLEE_NETWORKING
 
+/// macro: GLEE_DEFERRED_ERROR_CHECKS
+///
+/// DISCUSSION
+///
+///     By default every wrapped call is surrounded by two glGetError calls,
+/// and each one forces the driver to synchronize with the application. Under
+/// load that makes debug builds unusably slow. Define this macro to instead
+/// have wrapped calls only record where they were made (OpenGL function,
+/// calling function, file and line) into a fixed size ring buffer, and poll
+/// glGetError once every GLEE_DEFERRED_CHECK_INTERVAL calls and whenever
+/// GLEE_CheckDeferredErrors() is invoked (typically once per frame). When an
+/// error is found, the recorded call history is printed so the offending call
+/// can still be narrowed down.
+///
+/// NOTES
+///
+///     The reported history ends at the poll that found the error, so the
+/// culprit is one of the listed calls but not necessarily the last one.
+/// Networked documentation lookups are skipped in this mode since the
+/// failing function is not known.
+
+//#define GLEE_DEFERRED_ERROR_CHECKS
+
+/// macro: GLEE_DEFERRED_CHECK_INTERVAL
+///
+/// DISCUSSION
+///
+///     The number of wrapped calls between automatic glGetError polls in
+/// GLEE_DEFERRED_ERROR_CHECKS mode. Set it to 0 to only poll from
+/// GLEE_CheckDeferredErrors().
+
+#ifndef GLEE_DEFERRED_CHECK_INTERVAL
+# define GLEE_DEFERRED_CHECK_INTERVAL (1024)
+#endif // GLEE_DEFERRED_CHECK_INTERVAL
+
+/// macro: GLEE_DEFERRED_HISTORY_LENGTH
+///
+/// DISCUSSION
+///
+///     The number of most recent call sites kept, and reported on failure, in
+/// GLEE_DEFERRED_ERROR_CHECKS mode.
+
+#ifndef GLEE_DEFERRED_HISTORY_LENGTH
+# define GLEE_DEFERRED_HISTORY_LENGTH (64)
+#endif // GLEE_DEFERRED_HISTORY_LENGTH
+
+/// macro: GLEE_TRACE_CALLS
+///
+/// DISCUSSION
+///
+///     Define this macro to have every wrapped call written to a binary trace
+/// file along with its arguments and the client memory it reads (buffer and
+/// texture uploads, shader sources, uniform arrays, ...). GLEE_EndFrame()
+/// marks frame boundaries. The trace can be re-issued without the app, and
+/// timed, with the glee_replay tool.
+///
+/// NOTES
+///
+///     Data written through buffers mapped with glMapBufferRange is read back
+/// from the mapping and written to the trace when the range is flushed or
+/// unmapped. Persistent maps are compared against a copy before every draw,
+/// fence and GLEE_EndFrame(), and the blocks that changed are written, which
+/// costs a pass over each persistently mapped range per draw. Maps made
+/// with glMapBuffer are not followed.
+
+//#define GLEE_TRACE_CALLS
+
+/// macro: GLEE_TRACE_FILE_NAME
+///
+/// DISCUSSION
+///
+///     The file GLEE_TRACE_CALLS writes to. The GLEE_TRACE_FILE environment
+/// variable takes precedence when set.
+
+#ifndef GLEE_TRACE_FILE_NAME
+# define GLEE_TRACE_FILE_NAME "glee_trace.bin"
+#endif // GLEE_TRACE_FILE_NAME
+
+/// macro: GLEE_CALL_STATISTICS
+///
+/// DISCUSSION
+///
+///     Define this macro to count the calls to, and the wall-clock time spent
+/// in, every wrapped function, both per OpenGL entry point and per call site.
+/// GLEE_EndFrame() keeps a per-frame tally of calls, binds, uniform uploads
+/// and bytes uploaded through buffer and texture updates, and a report of the
+/// hottest entry points and call sites is printed when the program exits.
+/// Without this macro none of the bookkeeping is compiled in.
+///
+/// NOTES
+///
+///     The time measured is how long the call took to return, which for most
+/// calls is driver overhead and not GPU time. Combine with
+/// GLEE_DEFERRED_ERROR_CHECKS, or the glGetError calls around every call are
+/// part of what is being measured.
+
+//#define GLEE_CALL_STATISTICS
+
+/// macro: GLEE_STATISTICS_FRAME_INTERVAL
+///
+/// DISCUSSION
+///
+///     The number of frames between the per-frame summaries printed in
+/// GLEE_CALL_STATISTICS mode. Each summary holds the averages over those
+/// frames. Set it to 0 to only print the report at exit.
+
+#ifndef GLEE_STATISTICS_FRAME_INTERVAL
+# define GLEE_STATISTICS_FRAME_INTERVAL (300)
+#endif // GLEE_STATISTICS_FRAME_INTERVAL
+
+/// macro: GLEE_STATISTICS_TOP_N
+///
+/// DISCUSSION
+///
+///     The number of entry points and of call sites listed in the report
+/// printed at exit in GLEE_CALL_STATISTICS mode.
+
+#ifndef GLEE_STATISTICS_TOP_N
+# define GLEE_STATISTICS_TOP_N (10)
+#endif // GLEE_STATISTICS_TOP_N
+
+/// macro: GLEE_PERF_LINT
+///
+/// DISCUSSION
+///
+///     Define this macro to have the wrappers keep a shadow copy of the
+/// OpenGL state and report calls that are correct but slow: binds and state
+/// changes that set what is already current, uniform uploads of the value
+/// already set, buffer updates that have to wait for a recent draw reading
+/// the buffer, location lookups inside the frame loop, and state queries
+/// inside the frame loop that make the CPU wait for the GPU. Each pattern is
+/// printed with its call site the first time it is seen, and a report with
+/// the number of occurrences per call site is printed when the program
+/// exits. GLEE_EndFrame() marks where the frame loop starts; calls before
+/// the first one are treated as setup.
+///
+/// NOTES
+///
+///     The shadow state starts out unknown and is forgotten whenever a
+/// bindable object is deleted, so the lint never reports a call it cannot
+/// prove redundant, but misses some. State changed behind the wrappers'
+/// back (by a library, or a wrapped function the lint doesn't model) can
+/// cause false reports.
+
+//#define GLEE_PERF_LINT
+
+/// macro: GLEE_LINT_FRAMES_IN_FLIGHT
+///
+/// DISCUSSION
+///
+///     How many frames, counting the current one, a buffer read by a draw is
+/// considered in use by the GPU in GLEE_PERF_LINT mode.
+
+#ifndef GLEE_LINT_FRAMES_IN_FLIGHT
+# define GLEE_LINT_FRAMES_IN_FLIGHT (2)
+#endif // GLEE_LINT_FRAMES_IN_FLIGHT
+
 /// include: GL.h
 ///
 /// DISCUSSION
@@ -158,6 +328,8 @@ using namespace GL_include;
 #include <string>
 #include <vector>
 #include <map>
+#include <cstring>
+#include <stdint.h>
 
 //////
 
@@ -177,6 +349,33 @@ using namespace GL_include;
 
 #endif // GLEE_NETWORKING
 
+#ifdef GLEE_TRACE_CALLS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#endif // GLEE_TRACE_CALLS
+
+#ifdef GLEE_CALL_STATISTICS
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+#endif // GLEE_CALL_STATISTICS
+
+#ifdef GLEE_PERF_LINT
+
+#include <stdlib.h>
+#include <algorithm>
+#include <iomanip>
+
+#endif // GLEE_PERF_LINT
+
 #if defined(GLEE_CHECK_UNIFORM_LOCATIONS)
 # define GLEE_DO_CHECK_UNIFORMS (1)
 #else // !defined(GLEE_CHECK_UNIFORM_LOCATIONS)
@@ -233,7 +432,7 @@ struct glee_api {
             
             if (oglFuncName.length() > 0) {
                 std::string causeMessages = "";
-                OpenGLAdditionalErrorInfo additionalInfo = RequestOpenGLAPIErrorInfoForFunction(oglFuncName);
+                OpenGLAdditionalErrorInfo additionalInfo = LookupOpenGLAPIErrorInfoForFunction(oglFuncName);
                 for (std::vector<OpenGLEnumInfo>::iterator itr  = stateErrors.rawErrors.begin();
                     itr != stateErrors.rawErrors.end(); itr++) {
                     
@@ -262,6 +461,98 @@ struct glee_api {
             assert(false);
         }
     }
+
+    /// Where a wrapped OpenGL call was made from. All of the strings are
+    /// literals (#ogl_func, __FUNCTION__ and __FILE__), so only the pointers
+    /// are stored.
+    struct DeferredCallSite {
+        const char * oglFuncName;
+        const char * functionName;
+        const char * fileName;
+        int lineNumber;
+    };
+
+    /// The most recent GLEE_DEFERRED_HISTORY_LENGTH call sites, oldest first
+    /// starting at `count % GLEE_DEFERRED_HISTORY_LENGTH` once it wraps.
+    struct DeferredCallHistory {
+        DeferredCallSite calls[GLEE_DEFERRED_HISTORY_LENGTH];
+        unsigned long long count;
+    };
+
+    /// The single history shared by every translation unit.
+    static DeferredCallHistory &
+    deferredCallHistory()
+    {
+        static DeferredCallHistory __history;
+        return __history;
+    }
+
+    /// DESCRIPTION
+    ///
+    ///     Records that `oglFuncName` was just called from `functionName` at
+    /// `fileName`:`lineNumber`, and every GLEE_DEFERRED_CHECK_INTERVAL calls
+    /// polls for OpenGL errors. This replaces the AssertNoOpenGLErrors pair
+    /// around each call when GLEE_DEFERRED_ERROR_CHECKS is defined.
+    static inline void
+    RecordDeferredCall(
+        const char * oglFuncName,
+        const char * functionName,
+        const char * fileName,
+        const int lineNumber)
+    {
+        DeferredCallHistory & history = deferredCallHistory();
+        DeferredCallSite & site = history.calls[history.count % GLEE_DEFERRED_HISTORY_LENGTH];
+        site.oglFuncName = oglFuncName;
+        site.functionName = functionName;
+        site.fileName = fileName;
+        site.lineNumber = lineNumber;
+        history.count++;
+        
+        if (GLEE_DEFERRED_CHECK_INTERVAL > 0
+         && history.count % GLEE_DEFERRED_CHECK_INTERVAL == 0) {
+            CheckDeferredOpenGLErrors("periodic check", functionName, fileName, lineNumber);
+        }
+    }
+
+    /// DESCRIPTION
+    ///
+    ///     Polls glGetError once, and if an error has been raised since the
+    /// last poll prints the general error description followed by the
+    /// recorded call history, then crashes like AssertNoOpenGLErrors.
+    /// `functionName`, `fileName` and `lineNumber` describe where the poll
+    /// itself was made.
+    static void
+    CheckDeferredOpenGLErrors(
+        const std::string & message,
+        const std::string & functionName,
+        const std::string & fileName,
+        const int lineNumber)
+    {
+        OpenGLStateErrorInfo stateErrors = GetOpenGLStateErrors();
+        if (!stateErrors.encounteredError) {
+            return;
+        }
+
+        DeferredCallHistory & history = deferredCallHistory();
+        unsigned long long recorded = history.count < GLEE_DEFERRED_HISTORY_LENGTH
+         ? history.count : GLEE_DEFERRED_HISTORY_LENGTH;
+        
+        std::cerr << "{" << fileName << ":" << lineNumber
+         << " (" << functionName << ")} deferred opengl assertion failure: "
+         << message << std::endl << std::endl;
+        std::cerr << "General Information: " << stateErrors.description << std::endl << std::endl;
+        std::cerr << "The error was raised by one of the last " << recorded
+         << " of " << history.count << " wrapped calls (most recent last):" << std::endl;
+        
+        for (unsigned long long i = history.count - recorded; i < history.count; i++) {
+            const DeferredCallSite & site = history.calls[i % GLEE_DEFERRED_HISTORY_LENGTH];
+            std::cerr << "    " << site.oglFuncName << "  {" << site.fileName
+             << ":" << site.lineNumber << " (" << site.functionName << ")}" << std::endl;
+        }
+        std::cerr << std::endl;
+        
+        assert(false);
+    }
     
     ///
     static inline std::string
@@ -556,140 +847,1875 @@ struct glee_api {
             
             return result;
         }
-        
-        /// Returns all of error messages congealed together into a single string.
-        std::string
-        description() const
-        {
-            return invalidEnumDescription()
-             + " " + invalidValueDescription()
-             + " " + invalidOperationDescription()
-             + " " + invalidFramebufferOperationDescription()
-             + " " + outOfMemoryDescription()
-             + " " + joinStringsWithSeperator(errorNotes, " ");
+        
+        /// Returns all of error messages congealed together into a single string.
+        std::string
+        description() const
+        {
+            return invalidEnumDescription()
+             + " " + invalidValueDescription()
+             + " " + invalidOperationDescription()
+             + " " + invalidFramebufferOperationDescription()
+             + " " + outOfMemoryDescription()
+             + " " + joinStringsWithSeperator(errorNotes, " ");
+        }
+    };
+
+    /// Returns whether an OpenGL error has occurred, and a general error description
+    /// for all of the errors found, as well as all of the error enums in an array.
+    /// After this function is called the caller is guaranteed that
+    /// glGetError() == GL_NO_ERROR (basically this function clears the error state
+    /// for OpenGL)
+    static OpenGLStateErrorInfo
+    GetOpenGLStateErrors()
+    {
+        std::string toRet = "";
+        GLenum error = glGetError();
+        std::vector<OpenGLEnumInfo> rawErrors;
+        bool foundError = false;
+        
+        if (error != GLenum(GL_NO_ERROR)) {
+            foundError = true;
+        }
+        
+        while (error != GLenum(GL_NO_ERROR)) {
+            OpenGLEnumInfo info = OpenGLEnumInfo(error);
+            toRet += info.generalErrorDescription();
+            rawErrors.push_back(info);
+            
+            error = glGetError();
+        }
+        
+        OpenGLStateErrorInfo toReturn;
+        
+        toReturn.encounteredError = foundError;
+        toReturn.description = toRet;
+        toReturn.rawErrors = rawErrors;
+        
+        return toReturn;
+    }
+    
+    /// One reference page's worth of error descriptions, as stored in
+    /// glee_error_docs.hpp. Each error string holds every description for that
+    /// error, separated by '\n', and is empty when the page lists none.
+    struct OpenGLErrorDoc {
+        const char * functionName;
+        const char * url;
+        const char * invalidEnum;
+        const char * invalidValue;
+        const char * invalidOperation;
+        const char * invalidFramebufferOperation;
+        const char * outOfMemory;
+        const char * errorNotes;
+    };
+
+    /// 32-bit FNV-1a hash of `name`. Usable in constant expressions, which lets
+    /// glee_error_docs.hpp switch directly on the hash of a function name (a
+    /// collision between two pages is a duplicate case label, so it is caught
+    /// at compile time).
+    static constexpr unsigned
+    ErrorDocHash(
+        const char * name,
+        unsigned hash = 2166136261u)
+    {
+        return *name == '\0' ? hash
+         : ErrorDocHash(name + 1, (hash ^ (unsigned char)*name) * 16777619u);
+    }
+
+    /// Defines ErrorDocCount(), ErrorDocs() and ErrorDocIndex(hash).
+    #include "glee_error_docs.hpp"
+
+    /// Splits one of the '\n' separated OpenGLErrorDoc strings.
+    static std::vector<std::string>
+    splitErrorDocString(const char * descriptions)
+    {
+        std::vector<std::string> result;
+        std::string current = "";
+        for (const char * c = descriptions; *c != '\0'; c++) {
+            if (*c == '\n') {
+                result.push_back(current);
+                current = "";
+            }
+            else {
+                current.push_back(*c);
+            }
+        }
+        if (current.length() > 0) {
+            result.push_back(current);
+        }
+        return result;
+    }
+
+    /// Looks up the documentation for `function` in the embedded copy of the
+    /// reference pages. Like the network lookup, progressively shorter
+    /// prefixes of the name are tried so that e.g. glUniform1i finds the
+    /// glUniform page. Each attempt is a single switch on a hash, so no
+    /// network access or parsing happens at the moment of failure.
+    static OpenGLAdditionalErrorInfo
+    LookupOpenGLAPIErrorInfoForFunction(
+        const std::string & function)
+    {
+        for (std::string::size_type length = function.length(); length > 0; length--) {
+            std::string prefix = function.substr(0, length);
+            int index = ErrorDocIndex(ErrorDocHash(prefix.c_str()));
+            if (index < 0 || prefix != ErrorDocs()[index].functionName) {
+                continue;
+            }
+            
+            const OpenGLErrorDoc & doc = ErrorDocs()[index];
+            return OpenGLAdditionalErrorInfo(function, doc.url,
+             splitErrorDocString(doc.invalidEnum),
+             splitErrorDocString(doc.invalidValue),
+             splitErrorDocString(doc.invalidOperation),
+             splitErrorDocString(doc.invalidFramebufferOperation),
+             splitErrorDocString(doc.outOfMemory),
+             splitErrorDocString(doc.errorNotes));
+        }
+        
+        std::vector<std::string> none;
+        return OpenGLAdditionalErrorInfo(function, "", none, none, none, none, none, none);
+    }
+    
+    /// Tries to query the OpenGL website https://www.opengl.org for the
+    /// documentation of `function`.
+    static OpenGLAdditionalErrorInfo
+    RequestOpenGLAPIErrorInfoForFunction(
+        const std::string & function)
+    {
+        std::vector<std::string> invalidEnum, invalidValue, invalidOperation, invalidFramebufferOperation, outOfMemory, errorNotes;
+        std::string url;
+        
+#ifdef GLEE_NETWORKING
+        URL_FILE * urlDataStream = NULL;
+        int subStringLen = (int) function.length();
+        std::string functionGroupName;
+        
+        while (urlDataStream == NULL && subStringLen > 0) {
+            functionGroupName = function.substr(0, (std::string::size_type)subStringLen);
+            url = "https://www.opengl.org/sdk/docs/man/html/" + functionGroupName + ".xhtml";
+            
+            urlDataStream = url_fopen(url.c_str(), "r");
+            if (urlDataStream == NULL) {
+                subStringLen--;
+            }
+        }
+        
+        if (urlDataStream != NULL) {
+            std::string urlData = "";
+            xmlChar buffer[256] = {'\0'};
+            while (url_fread(buffer, sizeof(buffer), sizeof(char), urlDataStream) > 0) {
+                for (int i = 0; i < 256; i++) {
+                    /// We intentionally skip over all of the non-ASCII characters
+                    if (buffer[i] > 0 && buffer[i] < 128) {
+                        urlData.push_back((char)buffer[i]);
+                    }
+                }
+            }
+            htmlDocPtr doc = htmlReadDoc((xmlChar*)urlData.c_str(), NULL, NULL,
+             HTML_PARSE_RECOVER | HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING);
+            xmlNodePtr root = xmlDocGetRootElement(doc);
+            std::vector<xmlNodePtr> errorSearch
+             = findXMLNodeChildrenForXPath("//div[@id='errors']/p", root);
+            for (std::vector<xmlNodePtr>::iterator itr = errorSearch.begin();
+                itr != errorSearch.end(); itr++) {
+                
+                std::string content = unannotedXMLNodeContent(*itr);
+                if (content.find("GL_INVALID_ENUM") != std::string::npos) {
+                    invalidEnum.push_back(content);
+                }
+                else if (content.find("GL_INVALID_VALUE") != std::string::npos) {
+                    invalidValue.push_back(content);
+                }
+                else if (content.find("GL_INVALID_OPERATION") != std::string::npos) {
+                    invalidOperation.push_back(content);
+                }
+                else if (content.find("GL_INVALID_FRAMEBUFFER_OPERATION") != std::string::npos) {
+                    invalidFramebufferOperation.push_back(content);
+                }
+                else if (content.find("GL_OUT_OF_MEMORY") != std::string::npos) {
+                    outOfMemory.push_back(content);
+                }
+                else {
+                    errorNotes.push_back(content);
+                }
+            }
+            
+            xmlFreeDoc(doc);
+            url_fclose(urlDataStream);
+        }
+        else {
+            std::cerr << "{" << __FILE__ << ":" << __LINE__
+             << " (" << __FUNCTION__ << ")} "
+             << "Could not find documentation for function " << function
+             << std::endl;
+        }
+#endif // GLEE_NETWORKING
+        
+        return OpenGLAdditionalErrorInfo(function, url, invalidEnum,
+         invalidValue, invalidOperation, invalidFramebufferOperation,
+         outOfMemory, errorNotes);
+    }
+    
+#endif // GLEE_OVERWRITE_GL_FUNCTIONS
+
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// 4. Call Tracing, Statistics and Perf Lint
+///
+
+#if defined(GLEE_OVERWRITE_GL_FUNCTIONS)
+
+    /// Bytes per pixel of client image data in `format` and `type`.
+    static size_t
+    pixelSize(GLenum format, GLenum type)
+    {
+        int components = 4;
+        switch (format) {
+            case GL_RED: case GL_DEPTH_COMPONENT: case GL_RED_INTEGER: components = 1; break;
+            case GL_RG: case GL_DEPTH_STENCIL: case GL_RG_INTEGER: components = 2; break;
+            case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+            default: components = 4; break;
+        }
+        int componentSize = 1;
+        switch (type) {
+            case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: componentSize = 2; break;
+            case GL_INT: case GL_UNSIGNED_INT: case GL_FLOAT: componentSize = 4; break;
+            default: componentSize = 1; break;
+        }
+        return (size_t)(components * componentSize);
+    }
+
+    /// Bytes per element for the glUniform* functions, e.g. 12 for
+    /// glUniform3fv and 64 for glUniformMatrix4fv.
+    static int
+    uniformElementSize(const std::string & name)
+    {
+        std::string::size_type pos = std::string("glUniform").length();
+        bool matrix = name.compare(pos, 6, "Matrix") == 0;
+        if (matrix) {
+            pos += 6;
+        }
+        int columns = name[pos] - '0';
+        int rows = columns;
+        if (matrix && name[pos + 1] == 'x') {
+            rows = name[pos + 2] - '0';
+        }
+        int components = matrix ? columns * rows : columns;
+        char type = name[name.length() - 1] == 'v'
+         ? name[name.length() - 2] : name[name.length() - 1];
+        return components * (type == 'd' ? 8 : 4);
+    }
+
+    /// Appends the raw bytes of `value`.
+    template <typename T>
+    static inline void
+    appendBytes(std::vector<char> & out, const T & value)
+    {
+        const char * bytes = (const char *)&value;
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    /// Arguments are stored at their declared size; pointers always take
+    /// eight bytes so traces are portable between 32 and 64 bit builds.
+    template <typename T>
+    static inline void
+    serializeArgument(std::vector<char> & out, T value)
+    {
+        appendBytes(out, value);
+    }
+
+    template <typename T>
+    static inline void
+    serializeArgument(std::vector<char> & out, T * value)
+    {
+        appendBytes(out, (uint64_t)(uintptr_t)value);
+    }
+
+    /// DESCRIPTION
+    ///
+    ///     Replaces `out` with the bytes of `args`, each converted to the
+    /// parameter type of `func` first so the stored sizes match the signature
+    /// regardless of what the caller passed (a literal 0 for a GLintptr, a
+    /// size_t for a GLsizei, ...).
+    template <typename R, typename... Params, typename... Args>
+    static inline void
+    SerializeArguments(std::vector<char> & out, R (GLAPIENTRY * func)(Params...), Args... args)
+    {
+        (void)func;
+        out.clear();
+        int expand[] = { 0, (serializeArgument(out, (Params)args), 0)... };
+        (void)expand;
+    }
+
+    /// Reads back an argument stored at `offset` by SerializeArguments.
+    template <typename T>
+    static inline T
+    argumentAt(const std::vector<char> & args, size_t offset)
+    {
+        T value;
+        memcpy(&value, &args[offset], sizeof(T));
+        return value;
+    }
+
+    static inline const char *
+    pointerArgumentAt(const std::vector<char> & args, size_t offset)
+    {
+        return (const char *)(uintptr_t)argumentAt<uint64_t>(args, offset);
+    }
+
+#endif // defined(GLEE_OVERWRITE_GL_FUNCTIONS)
+
+#if defined(GLEE_OVERWRITE_GL_FUNCTIONS) && defined(GLEE_TRACE_CALLS)
+
+    /// The kinds of records in a trace file. Every record starts with its
+    /// kind as one byte; all integers are little endian.
+    enum TraceRecordKind {
+        /// u16 function id, u16 name length, name bytes. Emitted the first
+        /// time a function is called.
+        kTraceFunctionName = 0,
+        /// u16 function id, u16 argument bytes, u32 payload bytes, the
+        /// arguments, then the payload.
+        kTraceCall = 1,
+        /// No body. Emitted by GLEE_EndFrame().
+        kTraceFrameEnd = 2,
+        /// u32 buffer, u64 offset, u32 size, the bytes. Data written through
+        /// a mapped pointer into `buffer` at `offset`, emitted ahead of the
+        /// call that hands it to the GPU.
+        kTraceBufferData = 3
+    };
+
+    /// Memory a call reads through one of its pointer arguments that has to
+    /// be copied into the trace for the call to be replayable. Chosen once
+    /// per function from its name.
+    enum TracePayloadKind {
+        kTracePayloadNone,
+        kTracePayloadBufferData,        /// (target, size, data, ...)
+        kTracePayloadBufferSubData,     /// (target, offset, size, data)
+        kTracePayloadTexImage2D,        /// (target, ..., format, type, pixels)
+        kTracePayloadShaderSource,      /// (shader, count, string, length)
+        kTracePayloadName,              /// (program, name)
+        kTracePayloadObjectNames,       /// (n, names)
+        kTracePayloadUniformVector,     /// (location, count, value)
+        kTracePayloadUniformMatrix,     /// (location, count, transpose, value)
+        kTracePayloadMultiDrawBaseVertex, /// (mode, count, type, indices, drawcount, basevertex)
+        kTracePayloadPixelStore,        /// (pname, param), tracked not copied
+        kTracePayloadBindBuffer,        /// (target, buffer), tracked not copied
+        kTracePayloadBindBufferIndexed, /// (target, index, buffer, ...), tracked not copied
+        kTracePayloadMapBufferRange,    /// (target, offset, length, access) -> pointer, tracked not copied
+        kTracePayloadProgramBinary      /// (program, binaryFormat, binary, length)
+    };
+
+    /// What a function means for the buffers mapped for writing. Handled
+    /// before the call is made, while the mapped memory is still there.
+    enum TraceMappingEvent {
+        kTraceMappingNone,
+        kTraceMappingFlush,     /// (target, offset, length)
+        kTraceMappingUnmap,     /// (target)
+        kTraceMappingDelete,    /// (n, buffers)
+        kTraceMappingGpuRead    /// draws and fences, which see persistent maps
+    };
+
+    /// A function seen by the tracer.
+    struct TraceFunction {
+        std::string name;
+        TracePayloadKind payload;
+        TraceMappingEvent mapping;
+        /// Bytes per element of a uniform vector or matrix upload.
+        int elementSize;
+    };
+
+    /// A buffer range mapped for writing.
+    struct TraceMapping {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr length;
+        GLbitfield access;
+        const char * data;
+        /// For persistent maps, the bytes last written to the trace, so only
+        /// what changed since is written again.
+        std::vector<char> shadow;
+    };
+
+    /// The state of the trace file being written.
+    struct TraceWriter {
+        FILE * file;
+        std::vector<TraceFunction> functions;
+        std::map<std::string, unsigned short> functionIds;
+        std::vector<char> args;
+        std::vector<char> payload;
+        /// Tracked from glPixelStorei so texture uploads copy whole rows.
+        int unpackAlignment;
+        /// Tracked from glBindBuffer*, by target. Texture data is not copied
+        /// while a pixel unpack buffer is bound since `pixels` is then an
+        /// offset, and maps, flushes and unmaps name their buffer by target.
+        std::map<GLenum, GLuint> boundBuffers;
+        std::vector<TraceMapping> mappings;
+    };
+
+    static void
+    closeTrace()
+    {
+        TraceWriter & writer = traceWriter();
+        if (writer.file != NULL) {
+            fclose(writer.file);
+            writer.file = NULL;
+        }
+    }
+
+    /// The single trace shared by every translation unit. The file is named
+    /// by the GLEE_TRACE_FILE environment variable, or GLEE_TRACE_FILE_NAME.
+    static TraceWriter &
+    traceWriter()
+    {
+        static TraceWriter __writer;
+        static bool __opened = false;
+        if (!__opened) {
+            __opened = true;
+            __writer.unpackAlignment = 4;
+            const char * path = getenv("GLEE_TRACE_FILE");
+            __writer.file = fopen(path != NULL ? path : GLEE_TRACE_FILE_NAME, "wb");
+            if (__writer.file == NULL) {
+                std::cerr << "{" << __FILE__ << ":" << __LINE__
+                 << " (" << __FUNCTION__ << ")} "
+                 << "Could not open trace file, tracing is disabled" << std::endl;
+            }
+            else {
+                fwrite("GLEETRC1", 1, 8, __writer.file);
+                atexit(closeTrace);
+            }
+        }
+        return __writer;
+    }
+
+    /// Returns the id of `name`, assigning one and writing its name record
+    /// the first time it is seen. Call sites cache the result.
+    static unsigned short
+    TraceFunctionId(const char * name)
+    {
+        TraceWriter & writer = traceWriter();
+        std::string n = name;
+        std::map<std::string, unsigned short>::iterator found = writer.functionIds.find(n);
+        if (found != writer.functionIds.end()) {
+            return found->second;
+        }
+        
+        TraceFunction function;
+        function.name = n;
+        function.elementSize = 0;
+        function.payload = kTracePayloadNone;
+        function.mapping = kTraceMappingNone;
+        
+        if (n == "glBufferData" || n == "glBufferStorage") {
+            function.payload = kTracePayloadBufferData;
+        }
+        else if (n == "glBufferSubData") {
+            function.payload = kTracePayloadBufferSubData;
+        }
+        else if (n == "glTexImage2D") {
+            function.payload = kTracePayloadTexImage2D;
+        }
+        else if (n == "glShaderSource") {
+            function.payload = kTracePayloadShaderSource;
+        }
+        else if (n == "glGetUniformLocation" || n == "glGetAttribLocation"
+         || n == "glGetUniformBlockIndex") {
+            function.payload = kTracePayloadName;
+        }
+        else if (n.compare(0, 5, "glGen") == 0 || n.compare(0, 8, "glDelete") == 0) {
+            // glDeleteShader/Program/Sync take a single name by value
+            if (n != "glDeleteShader" && n != "glDeleteProgram" && n != "glDeleteSync"
+             && n != "glGenerateMipmap") {
+                function.payload = kTracePayloadObjectNames;
+            }
+        }
+        else if (n.compare(0, 15, "glUniformMatrix") == 0) {
+            function.payload = kTracePayloadUniformMatrix;
+            function.elementSize = uniformElementSize(n);
+        }
+        else if (n.compare(0, 9, "glUniform") == 0 && n[n.length() - 1] == 'v') {
+            function.payload = kTracePayloadUniformVector;
+            function.elementSize = uniformElementSize(n);
+        }
+        else if (n == "glMultiDrawElementsBaseVertex") {
+            function.payload = kTracePayloadMultiDrawBaseVertex;
+        }
+        else if (n == "glPixelStorei") {
+            function.payload = kTracePayloadPixelStore;
+        }
+        else if (n == "glBindBuffer") {
+            function.payload = kTracePayloadBindBuffer;
+        }
+        else if (n == "glBindBufferBase" || n == "glBindBufferRange") {
+            function.payload = kTracePayloadBindBufferIndexed;
+        }
+        else if (n == "glMapBufferRange") {
+            function.payload = kTracePayloadMapBufferRange;
+        }
+        else if (n == "glProgramBinary") {
+            function.payload = kTracePayloadProgramBinary;
+        }
+        
+        if (n == "glFlushMappedBufferRange") {
+            function.mapping = kTraceMappingFlush;
+        }
+        else if (n == "glUnmapBuffer") {
+            function.mapping = kTraceMappingUnmap;
+        }
+        else if (n == "glDeleteBuffers") {
+            function.mapping = kTraceMappingDelete;
+        }
+        else if (n.compare(0, 6, "glDraw") == 0 || n.compare(0, 11, "glMultiDraw") == 0
+         || n.compare(0, 17, "glDispatchCompute") == 0 || n == "glFenceSync") {
+            function.mapping = kTraceMappingGpuRead;
+        }
+        
+        unsigned short id = (unsigned short)writer.functions.size();
+        writer.functions.push_back(function);
+        writer.functionIds[n] = id;
+        
+        if (writer.file != NULL) {
+            unsigned char kind = kTraceFunctionName;
+            unsigned short length = (unsigned short)n.length();
+            fwrite(&kind, 1, 1, writer.file);
+            fwrite(&id, 2, 1, writer.file);
+            fwrite(&length, 2, 1, writer.file);
+            fwrite(n.c_str(), 1, length, writer.file);
+        }
+        return id;
+    }
+
+    static GLuint
+    traceBoundBuffer(const TraceWriter & writer, GLenum target)
+    {
+        std::map<GLenum, GLuint>::const_iterator found = writer.boundBuffers.find(target);
+        return found != writer.boundBuffers.end() ? found->second : 0;
+    }
+
+    static std::vector<TraceMapping>::iterator
+    traceFindMapping(TraceWriter & writer, GLuint buffer)
+    {
+        std::vector<TraceMapping>::iterator i = writer.mappings.begin();
+        while (i != writer.mappings.end() && i->buffer != buffer) {
+            i++;
+        }
+        return i;
+    }
+
+    /// Starts watching `mapping`. A persistent map is compared against what
+    /// it held when it was mapped.
+    static void
+    traceAddMapping(TraceWriter & writer, TraceMapping & mapping)
+    {
+        std::vector<TraceMapping>::iterator old = traceFindMapping(writer, mapping.buffer);
+        if (old != writer.mappings.end()) {
+            writer.mappings.erase(old);
+        }
+        if ((mapping.access & GL_MAP_PERSISTENT_BIT) != 0) {
+            mapping.shadow.assign(mapping.data, mapping.data + mapping.length);
+        }
+        writer.mappings.push_back(mapping);
+    }
+
+    /// Writes a buffer data record of `size` bytes at `offset` in `buffer`.
+    static void
+    traceWriteBufferData(TraceWriter & writer, GLuint buffer, GLintptr offset, const char * data, size_t size)
+    {
+        if (size == 0) {
+            return;
+        }
+        unsigned char kind = kTraceBufferData;
+        uint32_t name = buffer;
+        uint64_t start = (uint64_t)offset;
+        uint32_t bytes = (uint32_t)size;
+        fwrite(&kind, 1, 1, writer.file);
+        fwrite(&name, 4, 1, writer.file);
+        fwrite(&start, 8, 1, writer.file);
+        fwrite(&bytes, 4, 1, writer.file);
+        fwrite(data, 1, size, writer.file);
+    }
+
+    /// Writes what changed in the persistent map `mapping` since the last
+    /// time, in runs of whole 64 byte blocks.
+    static void
+    traceSyncPersistent(TraceWriter & writer, TraceMapping & mapping)
+    {
+        const size_t block = 64;
+        size_t length = (size_t)mapping.length;
+        size_t start = 0;
+        while (start < length) {
+            size_t size = length - start < block ? length - start : block;
+            if (memcmp(&mapping.shadow[start], mapping.data + start, size) == 0) {
+                start += size;
+                continue;
+            }
+            size_t end = start + size;
+            while (end < length) {
+                size = length - end < block ? length - end : block;
+                if (memcmp(&mapping.shadow[end], mapping.data + end, size) == 0) {
+                    break;
+                }
+                end += size;
+            }
+            /// Written from the copy, which can't change under us
+            memcpy(&mapping.shadow[start], mapping.data + start, end - start);
+            traceWriteBufferData(writer, mapping.buffer, mapping.offset + (GLintptr)start,
+                &mapping.shadow[start], end - start);
+            start = end;
+        }
+    }
+
+    static void
+    traceSyncAllPersistent(TraceWriter & writer)
+    {
+        for (size_t i = 0; i < writer.mappings.size(); i++) {
+            TraceMapping & mapping = writer.mappings[i];
+            if ((mapping.access & GL_MAP_PERSISTENT_BIT) != 0
+             && (mapping.access & GL_MAP_FLUSH_EXPLICIT_BIT) == 0) {
+                traceSyncPersistent(writer, mapping);
+            }
+        }
+    }
+
+    /// Writes the mapped data the call held in `writer.args` is about to
+    /// hand to the GPU, and stops watching the ranges it unmaps.
+    static void
+    traceMappingEvent(TraceWriter & writer, const TraceFunction & function)
+    {
+        const std::vector<char> & args = writer.args;
+        switch (function.mapping) {
+            case kTraceMappingNone:
+                break;
+            case kTraceMappingFlush: {
+                std::vector<TraceMapping>::iterator mapping =
+                    traceFindMapping(writer, traceBoundBuffer(writer, argumentAt<GLenum>(args, 0)));
+                GLintptr offset = argumentAt<GLintptr>(args, 4);
+                GLsizeiptr length = argumentAt<GLsizeiptr>(args, 4 + sizeof(GLintptr));
+                if (mapping == writer.mappings.end() || offset < 0 || length <= 0
+                 || offset + length > mapping->length) {
+                    break;
+                }
+                if (!mapping->shadow.empty()) {
+                    memcpy(&mapping->shadow[offset], mapping->data + offset, length);
+                }
+                traceWriteBufferData(writer, mapping->buffer, mapping->offset + offset,
+                    mapping->data + offset, (size_t)length);
+                break;
+            }
+            case kTraceMappingUnmap: {
+                std::vector<TraceMapping>::iterator mapping =
+                    traceFindMapping(writer, traceBoundBuffer(writer, argumentAt<GLenum>(args, 0)));
+                if (mapping == writer.mappings.end()) {
+                    break;
+                }
+                /// Explicitly flushed ranges were written at each flush
+                if ((mapping->access & GL_MAP_FLUSH_EXPLICIT_BIT) == 0) {
+                    if (!mapping->shadow.empty()) {
+                        traceSyncPersistent(writer, *mapping);
+                    }
+                    else {
+                        traceWriteBufferData(writer, mapping->buffer, mapping->offset,
+                            mapping->data, (size_t)mapping->length);
+                    }
+                }
+                writer.mappings.erase(mapping);
+                break;
+            }
+            case kTraceMappingDelete: {
+                /// Deleting a buffer unmaps it
+                GLsizei n = argumentAt<GLsizei>(args, 0);
+                const GLuint * buffers = (const GLuint *)pointerArgumentAt(args, 4);
+                for (GLsizei i = 0; buffers != NULL && i < n; i++) {
+                    std::vector<TraceMapping>::iterator mapping = traceFindMapping(writer, buffers[i]);
+                    if (mapping != writer.mappings.end()) {
+                        writer.mappings.erase(mapping);
+                    }
+                }
+                break;
+            }
+            case kTraceMappingGpuRead:
+                traceSyncAllPersistent(writer);
+                break;
+        }
+    }
+
+    /// Copies the client memory the call just read into `writer.payload`.
+    static void
+    traceCapturePayload(TraceWriter & writer, const TraceFunction & function)
+    {
+        const std::vector<char> & args = writer.args;
+        std::vector<char> & payload = writer.payload;
+        const char * data = NULL;
+        size_t size = 0;
+        
+        switch (function.payload) {
+            case kTracePayloadNone:
+                break;
+            case kTracePayloadBufferData:
+                size = (size_t)argumentAt<GLsizeiptr>(args, 4);
+                data = pointerArgumentAt(args, 4 + sizeof(GLsizeiptr));
+                break;
+            case kTracePayloadBufferSubData:
+                size = (size_t)argumentAt<GLsizeiptr>(args, 4 + sizeof(GLintptr));
+                data = pointerArgumentAt(args, 4 + sizeof(GLintptr) + sizeof(GLsizeiptr));
+                break;
+            case kTracePayloadTexImage2D: {
+                /// (target, level, internalformat, width, height, border, format, type, pixels)
+                if (traceBoundBuffer(writer, GL_PIXEL_UNPACK_BUFFER) != 0) {
+                    break;
+                }
+                GLsizei width = argumentAt<GLsizei>(args, 12);
+                GLsizei height = argumentAt<GLsizei>(args, 16);
+                GLenum format = argumentAt<GLenum>(args, 24);
+                GLenum type = argumentAt<GLenum>(args, 28);
+                size_t alignment = (size_t)writer.unpackAlignment;
+                size_t row = (size_t)width * pixelSize(format, type);
+                row = (row + alignment - 1) / alignment * alignment;
+                size = row * (size_t)height;
+                data = pointerArgumentAt(args, 32);
+                break;
+            }
+            case kTracePayloadShaderSource: {
+                /// Each string is stored NUL terminated
+                GLsizei count = argumentAt<GLsizei>(args, 4);
+                const GLchar * const * strings = (const GLchar * const *)pointerArgumentAt(args, 8);
+                const GLint * lengths = (const GLint *)pointerArgumentAt(args, 16);
+                for (GLsizei i = 0; i < count; i++) {
+                    size_t length = (lengths != NULL && lengths[i] >= 0)
+                     ? (size_t)lengths[i] : strlen(strings[i]);
+                    payload.insert(payload.end(), strings[i], strings[i] + length);
+                    payload.push_back('\0');
+                }
+                break;
+            }
+            case kTracePayloadName:
+                data = pointerArgumentAt(args, 4);
+                size = data != NULL ? strlen(data) + 1 : 0;
+                break;
+            case kTracePayloadObjectNames:
+                size = (size_t)argumentAt<GLsizei>(args, 0) * sizeof(GLuint);
+                data = pointerArgumentAt(args, 4);
+                break;
+            case kTracePayloadUniformVector:
+                size = (size_t)argumentAt<GLsizei>(args, 4) * function.elementSize;
+                data = pointerArgumentAt(args, 8);
+                break;
+            case kTracePayloadUniformMatrix:
+                size = (size_t)argumentAt<GLsizei>(args, 4) * function.elementSize;
+                data = pointerArgumentAt(args, 4 + sizeof(GLsizei) + sizeof(GLboolean));
+                break;
+            case kTracePayloadMultiDrawBaseVertex: {
+                /// Stored as drawcount counts, then offsets, then base vertices
+                GLsizei drawCount = argumentAt<GLsizei>(args, 24);
+                const GLsizei * counts = (const GLsizei *)pointerArgumentAt(args, 4);
+                const void * const * indices = (const void * const *)pointerArgumentAt(args, 16);
+                const GLint * baseVertices = (const GLint *)pointerArgumentAt(args, 28);
+                for (GLsizei i = 0; i < drawCount; i++) {
+                    appendBytes(payload, counts[i]);
+                }
+                for (GLsizei i = 0; i < drawCount; i++) {
+                    appendBytes(payload, (uint64_t)(uintptr_t)indices[i]);
+                }
+                for (GLsizei i = 0; i < drawCount; i++) {
+                    appendBytes(payload, baseVertices[i]);
+                }
+                break;
+            }
+            case kTracePayloadPixelStore:
+                if (argumentAt<GLenum>(args, 0) == GLenum(GL_UNPACK_ALIGNMENT)) {
+                    writer.unpackAlignment = argumentAt<GLint>(args, 4);
+                }
+                break;
+            case kTracePayloadBindBuffer:
+                writer.boundBuffers[argumentAt<GLenum>(args, 0)] = argumentAt<GLuint>(args, 4);
+                break;
+            case kTracePayloadBindBufferIndexed:
+                /// Binding an indexed target also binds its generic one
+                writer.boundBuffers[argumentAt<GLenum>(args, 0)] = argumentAt<GLuint>(args, 8);
+                break;
+            case kTracePayloadMapBufferRange: {
+                /// The mapped pointer was stored after the arguments
+                size_t access = 4 + sizeof(GLintptr) + sizeof(GLsizeiptr);
+                TraceMapping mapping;
+                mapping.buffer = traceBoundBuffer(writer, argumentAt<GLenum>(args, 0));
+                mapping.offset = argumentAt<GLintptr>(args, 4);
+                mapping.length = argumentAt<GLsizeiptr>(args, 4 + sizeof(GLintptr));
+                mapping.access = argumentAt<GLbitfield>(args, access);
+                mapping.data = pointerArgumentAt(args, access + sizeof(GLbitfield));
+                if (mapping.data != NULL && (mapping.access & GL_MAP_WRITE_BIT) != 0) {
+                    traceAddMapping(writer, mapping);
+                }
+                break;
+            }
+            case kTracePayloadProgramBinary:
+                size = (size_t)argumentAt<GLsizei>(args, 16);
+                data = pointerArgumentAt(args, 8);
+                break;
+        }
+        
+        if (data != NULL && size > 0) {
+            payload.insert(payload.end(), data, data + size);
+        }
+    }
+
+    /// Writes the call record held in `writer.args`.
+    static void
+    traceWriteCall(TraceWriter & writer, unsigned short id)
+    {
+        writer.payload.clear();
+        traceCapturePayload(writer, writer.functions[id]);
+        
+        unsigned char kind = kTraceCall;
+        unsigned short argBytes = (unsigned short)writer.args.size();
+        uint32_t payloadBytes = (uint32_t)writer.payload.size();
+        fwrite(&kind, 1, 1, writer.file);
+        fwrite(&id, 2, 1, writer.file);
+        fwrite(&argBytes, 2, 1, writer.file);
+        fwrite(&payloadBytes, 4, 1, writer.file);
+        if (argBytes > 0) {
+            fwrite(&writer.args[0], 1, argBytes, writer.file);
+        }
+        if (payloadBytes > 0) {
+            fwrite(&writer.payload[0], 1, payloadBytes, writer.file);
+        }
+    }
+
+    /// DESCRIPTION
+    ///
+    ///     Records a call of the function `id`, which is `func`, with `args`.
+    template <typename R, typename... Params, typename... Args>
+    static void
+    TraceCall(unsigned short id, R (GLAPIENTRY * func)(Params...), Args... args)
+    {
+        TraceWriter & writer = traceWriter();
+        if (writer.file == NULL) {
+            return;
+        }
+        SerializeArguments(writer.args, func, args...);
+        traceWriteCall(writer, id);
+    }
+
+    /// DESCRIPTION
+    ///
+    ///     Called before the function `id`, which is `func`, is made with
+    /// `args`. Writes the data the app put in mapped buffers that the call
+    /// flushes, unmaps or lets the GPU read, while it is still mapped.
+    template <typename R, typename... Params, typename... Args>
+    static void
+    TraceBeforeCall(unsigned short id, R (GLAPIENTRY * func)(Params...), Args... args)
+    {
+        TraceWriter & writer = traceWriter();
+        if (writer.file == NULL || writer.mappings.empty()
+         || writer.functions[id].mapping == kTraceMappingNone) {
+            return;
+        }
+        SerializeArguments(writer.args, func, args...);
+        traceMappingEvent(writer, writer.functions[id]);
+    }
+
+    /// Same as TraceCall, with the function's return value stored after the
+    /// arguments so replays can map the objects it names.
+    template <typename R, typename... Params, typename Result, typename... Args>
+    static void
+    TraceCallWithResult(unsigned short id, R (GLAPIENTRY * func)(Params...), Result result, Args... args)
+    {
+        TraceWriter & writer = traceWriter();
+        if (writer.file == NULL) {
+            return;
+        }
+        SerializeArguments(writer.args, func, args...);
+        serializeArgument(writer.args, (R)result);
+        traceWriteCall(writer, id);
+    }
+
+    /// Marks the end of a frame and flushes the trace, after writing what
+    /// changed in persistent maps.
+    static void
+    TraceFrameEnd()
+    {
+        TraceWriter & writer = traceWriter();
+        if (writer.file != NULL) {
+            traceSyncAllPersistent(writer);
+            unsigned char kind = kTraceFrameEnd;
+            fwrite(&kind, 1, 1, writer.file);
+            fflush(writer.file);
+        }
+    }
+
+#endif // defined(GLEE_OVERWRITE_GL_FUNCTIONS) && defined(GLEE_TRACE_CALLS)
+
+#if defined(GLEE_OVERWRITE_GL_FUNCTIONS) && defined(GLEE_CALL_STATISTICS)
+
+    /// What a wrapped function does, for the per-frame summary.
+    enum StatisticsCategory {
+        kStatisticsOther,
+        kStatisticsBind,
+        kStatisticsUniform,
+        kStatisticsBufferData,      /// (target, size, ...)
+        kStatisticsBufferSubData,   /// (target, offset, size, data)
+        kStatisticsTexImage2D,      /// (target, level, internalformat, width, height, border, format, type, pixels)
+        kStatisticsTexSubImage2D    /// (target, level, xoffset, yoffset, width, height, format, type, pixels)
+    };
+
+    /// Totals for one OpenGL entry point.
+    struct StatisticsFunction {
+        std::string name;
+        StatisticsCategory category;
+        unsigned long long calls;
+        double seconds;
+    };
+
+    /// Totals for one place a wrapped call is made from. The strings are
+    /// literals, as in DeferredCallSite.
+    struct StatisticsSite {
+        unsigned function;
+        const char * functionName;
+        const char * fileName;
+        int lineNumber;
+        unsigned long long calls;
+        double seconds;
+    };
+
+    /// Counters summed over one or more frames.
+    struct StatisticsFrame {
+        unsigned long long calls;
+        unsigned long long binds;
+        unsigned long long uniformUploads;
+        unsigned long long bytesUploaded;
+        double seconds;
+    };
+
+    /// Everything recorded so far.
+    struct CallStatistics {
+        std::vector<StatisticsFunction> functions;
+        std::map<std::string, unsigned> functionIds;
+        std::vector<StatisticsSite> sites;
+        /// The frame in progress, and the frames since the last summary.
+        StatisticsFrame frame;
+        StatisticsFrame interval;
+        unsigned long long frames;
+        unsigned long long intervalFrames;
+    };
+
+    typedef std::chrono::high_resolution_clock StatisticsClock;
+
+    /// The statistics shared by every translation unit. The report is
+    /// printed when the program exits.
+    static CallStatistics &
+    callStatistics()
+    {
+        static CallStatistics __statistics;
+        static bool __registered = false;
+        if (!__registered) {
+            __registered = true;
+            memset(&__statistics.frame, 0, sizeof(StatisticsFrame));
+            memset(&__statistics.interval, 0, sizeof(StatisticsFrame));
+            __statistics.frames = 0;
+            __statistics.intervalFrames = 0;
+            atexit(PrintCallStatistics);
+        }
+        return __statistics;
+    }
+
+    /// Returns the id of the call site `functionName`, `fileName`:`lineNumber`
+    /// of `oglFuncName`. Called once per site; the macros cache the result.
+    static unsigned
+    StatisticsCallSite(
+        const char * oglFuncName,
+        const char * functionName,
+        const char * fileName,
+        const int lineNumber)
+    {
+        CallStatistics & statistics = callStatistics();
+        std::string name = oglFuncName;
+        
+        unsigned function;
+        std::map<std::string, unsigned>::iterator found = statistics.functionIds.find(name);
+        if (found != statistics.functionIds.end()) {
+            function = found->second;
+        }
+        else {
+            StatisticsFunction entry;
+            entry.name = name;
+            entry.calls = 0;
+            entry.seconds = 0.0;
+            entry.category = kStatisticsOther;
+            if (name.compare(0, 6, "glBind") == 0) {
+                entry.category = kStatisticsBind;
+            }
+            else if (name.compare(0, 9, "glUniform") == 0
+             && name.compare(0, 14, "glUniformBlock") != 0
+             && name.compare(0, 19, "glUniformSubroutine") != 0) {
+                entry.category = kStatisticsUniform;
+            }
+            else if (name == "glBufferData" || name == "glBufferStorage") {
+                entry.category = kStatisticsBufferData;
+            }
+            else if (name == "glBufferSubData") {
+                entry.category = kStatisticsBufferSubData;
+            }
+            else if (name == "glTexImage2D") {
+                entry.category = kStatisticsTexImage2D;
+            }
+            else if (name == "glTexSubImage2D") {
+                entry.category = kStatisticsTexSubImage2D;
+            }
+            function = (unsigned)statistics.functions.size();
+            statistics.functions.push_back(entry);
+            statistics.functionIds[name] = function;
+        }
+        
+        StatisticsSite site;
+        site.function = function;
+        site.functionName = functionName;
+        site.fileName = fileName;
+        site.lineNumber = lineNumber;
+        site.calls = 0;
+        site.seconds = 0.0;
+        statistics.sites.push_back(site);
+        return (unsigned)(statistics.sites.size() - 1);
+    }
+
+    /// Arguments as integers, for reading sizes back out of them.
+    template <typename T>
+    static inline unsigned long long
+    statisticsValue(T value)
+    {
+        return (unsigned long long)value;
+    }
+
+    template <typename T>
+    static inline unsigned long long
+    statisticsValue(T * value)
+    {
+        (void)value;
+        return 0;
+    }
+
+    /// DESCRIPTION
+    ///
+    ///     Adds a call made at `site` that started at `start` and has just
+    /// returned. `args` are the arguments it was called with, used to count
+    /// the bytes uploaded by buffer and texture updates.
+    template <typename... Args>
+    static void
+    RecordCallStatistics(unsigned site, StatisticsClock::time_point start, Args... args)
+    {
+        double seconds = std::chrono::duration<double>(StatisticsClock::now() - start).count();
+        CallStatistics & statistics = callStatistics();
+        StatisticsSite & callSite = statistics.sites[site];
+        StatisticsFunction & function = statistics.functions[callSite.function];
+        callSite.calls++;
+        callSite.seconds += seconds;
+        function.calls++;
+        function.seconds += seconds;
+        
+        StatisticsFrame & frame = statistics.frame;
+        frame.calls++;
+        frame.seconds += seconds;
+        
+        /// Offset by one so calls without arguments still compile
+        unsigned long long values[] = { 0, statisticsValue(args)... };
+        const size_t count = sizeof(values) / sizeof(values[0]);
+        switch (function.category) {
+            case kStatisticsOther:
+                break;
+            case kStatisticsBind:
+                frame.binds++;
+                break;
+            case kStatisticsUniform:
+                frame.uniformUploads++;
+                break;
+            case kStatisticsBufferData:
+                if (count > 2) {
+                    frame.bytesUploaded += values[2];
+                }
+                break;
+            case kStatisticsBufferSubData:
+                if (count > 3) {
+                    frame.bytesUploaded += values[3];
+                }
+                break;
+            case kStatisticsTexImage2D:
+                if (count > 8) {
+                    frame.bytesUploaded += values[4] * values[5]
+                     * pixelSize((GLenum)values[7], (GLenum)values[8]);
+                }
+                break;
+            case kStatisticsTexSubImage2D:
+                if (count > 8) {
+                    frame.bytesUploaded += values[5] * values[6]
+                     * pixelSize((GLenum)values[7], (GLenum)values[8]);
+                }
+                break;
+        }
+    }
+
+    /// Ends the frame in progress, and every GLEE_STATISTICS_FRAME_INTERVAL
+    /// frames prints the per-frame averages since the last summary.
+    static void
+    StatisticsFrameEnd()
+    {
+        CallStatistics & statistics = callStatistics();
+        StatisticsFrame & frame = statistics.frame;
+        StatisticsFrame & interval = statistics.interval;
+        interval.calls += frame.calls;
+        interval.binds += frame.binds;
+        interval.uniformUploads += frame.uniformUploads;
+        interval.bytesUploaded += frame.bytesUploaded;
+        interval.seconds += frame.seconds;
+        memset(&frame, 0, sizeof(StatisticsFrame));
+        statistics.frames++;
+        statistics.intervalFrames++;
+        
+        if (GLEE_STATISTICS_FRAME_INTERVAL > 0
+         && statistics.intervalFrames >= GLEE_STATISTICS_FRAME_INTERVAL) {
+            double frames = (double)statistics.intervalFrames;
+            std::ios::fmtflags flags = std::cerr.flags();
+            std::cerr << std::fixed << std::setprecision(1);
+            std::cerr << "[GLEE] frames " << statistics.frames - statistics.intervalFrames
+             << "-" << statistics.frames - 1 << ", per frame: "
+             << interval.calls / frames << " calls, "
+             << interval.binds / frames << " binds, "
+             << interval.uniformUploads / frames << " uniform uploads, "
+             << interval.bytesUploaded / frames << " bytes uploaded, "
+             << std::setprecision(3) << interval.seconds * 1e3 / frames
+             << " ms in GL" << std::endl;
+            std::cerr.flags(flags);
+            memset(&interval, 0, sizeof(StatisticsFrame));
+            statistics.intervalFrames = 0;
+        }
+    }
+
+    static bool
+    statisticsFunctionSlower(const StatisticsFunction & a, const StatisticsFunction & b)
+    {
+        return a.seconds > b.seconds;
+    }
+
+    static bool
+    statisticsSiteSlower(const StatisticsSite & a, const StatisticsSite & b)
+    {
+        return a.seconds > b.seconds;
+    }
+
+    /// Prints the GLEE_STATISTICS_TOP_N entry points and call sites that
+    /// spent the most time in OpenGL. Registered with atexit.
+    static void
+    PrintCallStatistics()
+    {
+        CallStatistics & statistics = callStatistics();
+        std::vector<StatisticsFunction> functions = statistics.functions;
+        std::vector<StatisticsSite> sites = statistics.sites;
+        std::sort(functions.begin(), functions.end(), statisticsFunctionSlower);
+        std::sort(sites.begin(), sites.end(), statisticsSiteSlower);
+        
+        unsigned long long calls = 0;
+        double seconds = 0.0;
+        for (size_t i = 0; i < functions.size(); i++) {
+            calls += functions[i].calls;
+            seconds += functions[i].seconds;
+        }
+        
+        std::ios::fmtflags flags = std::cerr.flags();
+        std::cerr << std::fixed << std::setprecision(3);
+        std::cerr << std::endl << "[GLEE] " << calls << " wrapped calls over "
+         << statistics.frames << " frames, " << seconds * 1e3 << " ms in GL" << std::endl;
+        
+        std::cerr << std::endl << "Hottest entry points:" << std::endl;
+        std::cerr << std::setw(12) << "calls" << std::setw(12) << "total ms"
+         << std::setw(12) << "avg us" << "  function" << std::endl;
+        for (size_t i = 0; i < functions.size() && i < GLEE_STATISTICS_TOP_N; i++) {
+            const StatisticsFunction & function = functions[i];
+            std::cerr << std::setw(12) << function.calls
+             << std::setw(12) << function.seconds * 1e3
+             << std::setw(12) << function.seconds * 1e6 / function.calls
+             << "  " << function.name << std::endl;
+        }
+        
+        std::cerr << std::endl << "Hottest call sites:" << std::endl;
+        std::cerr << std::setw(12) << "calls" << std::setw(12) << "total ms"
+         << std::setw(12) << "avg us" << "  call" << std::endl;
+        for (size_t i = 0; i < sites.size() && i < GLEE_STATISTICS_TOP_N; i++) {
+            const StatisticsSite & site = sites[i];
+            if (site.calls == 0) {
+                break;
+            }
+            std::cerr << std::setw(12) << site.calls
+             << std::setw(12) << site.seconds * 1e3
+             << std::setw(12) << site.seconds * 1e6 / site.calls
+             << "  " << statistics.functions[site.function].name
+             << " {" << site.fileName << ":" << site.lineNumber
+             << " (" << site.functionName << ")}" << std::endl;
+        }
+        std::cerr.flags(flags);
+    }
+
+#endif // defined(GLEE_OVERWRITE_GL_FUNCTIONS) && defined(GLEE_CALL_STATISTICS)
+
+#if defined(GLEE_OVERWRITE_GL_FUNCTIONS) && defined(GLEE_PERF_LINT)
+
+    /// The patterns the perf lint reports.
+    enum LintIssue {
+        kLintRedundantState,
+        kLintRedundantUniform,
+        kLintBufferInFlight,
+        kLintLocationQueryInFrame,
+        kLintSyncQueryInFrame,
+        kLintIssueCount
+    };
+
+    /// What a wrapped function means to the shadow state. Argument offsets
+    /// are into the bytes written by SerializeArguments.
+    enum LintCheck {
+        kLintCheckNone,
+        kLintCheckState,            /// a setter, see LintFunction::keyBytes
+        kLintCheckBindTexture,      /// (target, texture), keyed by the active unit
+        kLintCheckBindBuffer,       /// (target, buffer)
+        kLintCheckBindIndexedBuffer,/// (target, index, buffer, ...)
+        kLintCheckBindVertexArray,  /// (array)
+        kLintCheckUseProgram,       /// (program)
+        kLintCheckLinkProgram,      /// (program)
+        kLintCheckDelete,           /// glDelete* of bindable objects, (n, names)
+        kLintCheckUniform,          /// (location, v0, ...)
+        kLintCheckUniformVector,    /// (location, count, value)
+        kLintCheckUniformMatrix,    /// (location, count, transpose, value)
+        kLintCheckVertexAttribPointer,
+        kLintCheckBufferData,       /// (target, size, data, ...)
+        kLintCheckBufferSubData,    /// (target, offset, size, data)
+        kLintCheckDraw,
+        kLintCheckLocationQuery,
+        kLintCheckObjectQuery,      /// glGet{Program,Shader}iv, (object, pname, params)
+        kLintCheckSyncQuery
+    };
+
+    /// A function seen by the lint.
+    struct LintFunction {
+        LintCheck check;
+        /// For kLintCheckState, how many leading argument bytes select the
+        /// piece of state (e.g. the capability of glEnable); the rest is the
+        /// value being set.
+        size_t keyBytes;
+        int elementSize;
+    };
+
+    /// A place a wrapped call is made from, with how many times each issue
+    /// was seen there. The strings are literals, as in DeferredCallSite.
+    struct LintSite {
+        const char * oglFuncName;
+        const char * functionName;
+        const char * fileName;
+        int lineNumber;
+        LintFunction function;
+        unsigned long long issues[kLintIssueCount];
+    };
+
+    /// The shadow copy of the OpenGL state the lint compares against.
+    struct PerfLint {
+        std::map<std::string, LintFunction> functions;
+        std::vector<LintSite> sites;
+        std::vector<char> args;
+        /// Setter name and key bytes to the value last set.
+        std::map<std::string, std::vector<char> > state;
+        /// (program, location) to the bytes last uploaded.
+        std::map<std::pair<GLuint, GLint>, std::vector<char> > uniforms;
+        GLuint program;
+        GLenum activeTexture;
+        GLuint vertexArray;
+        std::map<GLenum, GLuint> buffers;
+        std::map<std::pair<GLenum, GLuint>, GLuint> indexedBuffers;
+        /// Buffers each vertex array reads from, and its element buffer.
+        std::map<GLuint, std::vector<GLuint> > vertexArrayBuffers;
+        std::map<GLuint, GLuint> vertexArrayElements;
+        /// The frame each buffer was last read by a draw in.
+        std::map<GLuint, unsigned long long> bufferLastDrawn;
+        unsigned long long frame;
+    };
+
+    /// The shadow state shared by every translation unit. The report is
+    /// printed when the program exits.
+    static PerfLint &
+    perfLint()
+    {
+        static PerfLint __lint;
+        static bool __registered = false;
+        if (!__registered) {
+            __registered = true;
+            __lint.program = 0;
+            __lint.activeTexture = GL_TEXTURE0;
+            __lint.vertexArray = 0;
+            __lint.frame = 0;
+            atexit(PrintPerfLint);
+        }
+        return __lint;
+    }
+
+    /// Decides what `name` means to the shadow state.
+    static LintFunction
+    lintFunction(const std::string & name)
+    {
+        LintFunction function;
+        function.check = kLintCheckNone;
+        function.keyBytes = 0;
+        function.elementSize = 0;
+        
+        if (name == "glEnable" || name == "glDisable" || name == "glBindFramebuffer"
+         || name == "glBindRenderbuffer" || name == "glBindSampler"
+         || name == "glPixelStorei" || name == "glPolygonMode") {
+            function.check = kLintCheckState;
+            function.keyBytes = 4;
+        }
+        else if (name == "glActiveTexture" || name == "glViewport" || name == "glScissor"
+         || name == "glClearColor" || name == "glClearDepth" || name == "glDepthFunc"
+         || name == "glDepthMask" || name == "glColorMask" || name == "glCullFace"
+         || name == "glFrontFace" || name == "glBlendFunc" || name == "glBlendFuncSeparate"
+         || name == "glBlendEquation" || name == "glLineWidth") {
+            function.check = kLintCheckState;
+        }
+        else if (name == "glBindTexture") {
+            function.check = kLintCheckBindTexture;
+        }
+        else if (name == "glBindBuffer") {
+            function.check = kLintCheckBindBuffer;
+        }
+        else if (name == "glBindBufferBase" || name == "glBindBufferRange") {
+            function.check = kLintCheckBindIndexedBuffer;
+        }
+        else if (name == "glBindVertexArray") {
+            function.check = kLintCheckBindVertexArray;
+        }
+        else if (name == "glUseProgram") {
+            function.check = kLintCheckUseProgram;
+        }
+        else if (name == "glLinkProgram" || name == "glProgramBinary") {
+            function.check = kLintCheckLinkProgram;
+        }
+        else if (name.compare(0, 8, "glDelete") == 0 && name != "glDeleteShader"
+         && name != "glDeleteProgram" && name != "glDeleteSync" && name != "glDeleteQueries") {
+            function.check = kLintCheckDelete;
+        }
+        else if (name.compare(0, 15, "glUniformMatrix") == 0) {
+            function.check = kLintCheckUniformMatrix;
+            function.elementSize = uniformElementSize(name);
+        }
+        else if (name.compare(0, 9, "glUniform") == 0
+         && name.compare(0, 14, "glUniformBlock") != 0
+         && name.compare(0, 19, "glUniformSubroutine") != 0) {
+            bool vector = name[name.length() - 1] == 'v';
+            function.check = vector ? kLintCheckUniformVector : kLintCheckUniform;
+            function.elementSize = uniformElementSize(name);
+        }
+        else if (name == "glVertexAttribPointer" || name == "glVertexAttribIPointer"
+         || name == "glVertexAttribLPointer") {
+            function.check = kLintCheckVertexAttribPointer;
         }
-    };
+        else if (name == "glBufferData") {
+            function.check = kLintCheckBufferData;
+        }
+        else if (name == "glBufferSubData") {
+            function.check = kLintCheckBufferSubData;
+        }
+        else if (name.compare(0, 6, "glDraw") == 0 || name.compare(0, 11, "glMultiDraw") == 0) {
+            function.check = kLintCheckDraw;
+        }
+        else if (name == "glGetUniformLocation" || name == "glGetAttribLocation"
+         || name == "glGetUniformBlockIndex" || name == "glGetFragDataLocation"
+         || name == "glGetUniformIndices" || name == "glGetProgramResourceLocation"
+         || name == "glGetProgramResourceIndex" || name == "glGetSubroutineUniformLocation") {
+            function.check = kLintCheckLocationQuery;
+        }
+        else if (name == "glGetProgramiv" || name == "glGetShaderiv") {
+            function.check = kLintCheckObjectQuery;
+        }
+        else if (name.compare(0, 5, "glGet") == 0 || name == "glReadPixels" || name == "glFinish") {
+            function.check = kLintCheckSyncQuery;
+        }
+        return function;
+    }
 
-    /// Returns whether an OpenGL error has occurred, and a general error description
-    /// for all of the errors found, as well as all of the error enums in an array.
-    /// After this function is called the caller is guaranteed that
-    /// glGetError() == GL_NO_ERROR (basically this function clears the error state
-    /// for OpenGL)
-    static OpenGLStateErrorInfo
-    GetOpenGLStateErrors()
+    /// Returns the id of the call site `functionName`, `fileName`:`lineNumber`
+    /// of `oglFuncName`. Called once per site; the macros cache the result.
+    static unsigned
+    LintCallSite(
+        const char * oglFuncName,
+        const char * functionName,
+        const char * fileName,
+        const int lineNumber)
     {
-        std::string toRet = "";
-        GLenum error = glGetError();
-        std::vector<OpenGLEnumInfo> rawErrors;
-        bool foundError = false;
-        
-        if (error != GLenum(GL_NO_ERROR)) {
-            foundError = true;
+        PerfLint & lint = perfLint();
+        std::string name = oglFuncName;
+        std::map<std::string, LintFunction>::iterator found = lint.functions.find(name);
+        if (found == lint.functions.end()) {
+            found = lint.functions.insert(std::make_pair(name, lintFunction(name))).first;
         }
         
-        while (error != GLenum(GL_NO_ERROR)) {
-            OpenGLEnumInfo info = OpenGLEnumInfo(error);
-            toRet += info.generalErrorDescription();
-            rawErrors.push_back(info);
-            
-            error = glGetError();
+        LintSite site;
+        site.oglFuncName = oglFuncName;
+        site.functionName = functionName;
+        site.fileName = fileName;
+        site.lineNumber = lineNumber;
+        site.function = found->second;
+        memset(site.issues, 0, sizeof(site.issues));
+        lint.sites.push_back(site);
+        return (unsigned)(lint.sites.size() - 1);
+    }
+
+    static const char *
+    lintIssueDescription(LintIssue issue)
+    {
+        switch (issue) {
+            case kLintRedundantState: return "sets state or binds an object that is already current";
+            case kLintRedundantUniform: return "uploads the uniform value that is already set";
+            case kLintBufferInFlight: return "updates a buffer a recent draw reads from, which can stall until the GPU is done with it";
+            case kLintLocationQueryInFrame: return "looks up a location every frame, query it once after linking";
+            case kLintSyncQueryInFrame: return "queries GL state every frame, which can force the CPU to wait for the GPU";
+            case kLintIssueCount: break;
         }
-        
-        OpenGLStateErrorInfo toReturn;
-        
-        toReturn.encounteredError = foundError;
-        toReturn.description = toRet;
-        toReturn.rawErrors = rawErrors;
-        
-        return toReturn;
+        return "";
     }
-    
-    /// Tries to query the OpenGL website https://www.opengl.org for the
-    /// documentation of `function`.
-    static OpenGLAdditionalErrorInfo
-    RequestOpenGLAPIErrorInfoForFunction(
-        const std::string & function)
+
+    /// Counts `issue` at `site`, printing it the first time.
+    static void
+    lintReport(LintSite & site, LintIssue issue)
     {
-        std::vector<std::string> invalidEnum, invalidValue, invalidOperation, invalidFramebufferOperation, outOfMemory, errorNotes;
-        std::string url;
+        if (site.issues[issue]++ == 0) {
+            std::cerr << "{" << site.fileName << ":" << site.lineNumber
+             << " (" << site.functionName << ")} perf lint: "
+             << site.oglFuncName << " " << lintIssueDescription(issue) << std::endl;
+        }
+    }
+
+    /// Records `value` as the current value of `key`, returning whether it
+    /// already was.
+    static bool
+    lintSetState(PerfLint & lint, const std::string & key, const std::vector<char> & value)
+    {
+        std::map<std::string, std::vector<char> >::iterator found = lint.state.find(key);
+        if (found != lint.state.end() && found->second == value) {
+            return true;
+        }
+        lint.state[key] = value;
+        return false;
+    }
+
+    /// Reports a write to the buffer bound to `target` if a draw in the last
+    /// GLEE_LINT_FRAMES_IN_FLIGHT frames read from it.
+    static void
+    lintBufferWrite(PerfLint & lint, LintSite & site, GLenum target)
+    {
+        GLuint buffer = lint.buffers[target];
+        std::map<GLuint, unsigned long long>::iterator drawn = lint.bufferLastDrawn.find(buffer);
+        if (buffer != 0 && drawn != lint.bufferLastDrawn.end()
+         && drawn->second + GLEE_LINT_FRAMES_IN_FLIGHT > lint.frame) {
+            lintReport(site, kLintBufferInFlight);
+        }
+    }
+
+    static void
+    lintMarkDrawn(PerfLint & lint, GLuint buffer)
+    {
+        if (buffer != 0) {
+            lint.bufferLastDrawn[buffer] = lint.frame;
+        }
+    }
+
+    /// DESCRIPTION
+    ///
+    ///     Checks a call made at `site`, which is about to call `func` with
+    /// `args`, against the shadow state and then updates the shadow state as
+    /// the call will.
+    template <typename R, typename... Params, typename... Args>
+    static void
+    LintCall(unsigned siteId, R (GLAPIENTRY * func)(Params...), Args... params)
+    {
+        PerfLint & lint = perfLint();
+        LintSite & site = lint.sites[siteId];
+        const LintFunction & function = site.function;
+        if (function.check == kLintCheckNone) {
+            return;
+        }
         
-#ifdef GLEE_NETWORKING
-        URL_FILE * urlDataStream = NULL;
-        int subStringLen = (int) function.length();
-        std::string functionGroupName;
+        std::vector<char> & args = lint.args;
+        SerializeArguments(args, func, params...);
         
-        while (urlDataStream == NULL && subStringLen > 0) {
-            functionGroupName = function.substr(0, (std::string::size_type)subStringLen);
-            url = "https://www.opengl.org/sdk/docs/man/html/" + functionGroupName + ".xhtml";
-            
-            urlDataStream = url_fopen(url.c_str(), "r");
-            if (urlDataStream == NULL) {
-                subStringLen--;
+        switch (function.check) {
+            case kLintCheckNone:
+                break;
+            case kLintCheckState: {
+                /// glEnable and glDisable set the same piece of state
+                std::string name = site.oglFuncName;
+                std::vector<char> value(args.begin() + function.keyBytes, args.end());
+                if (name == "glEnable" || name == "glDisable") {
+                    value.assign(1, name == "glEnable" ? 1 : 0);
+                    name = "glEnable";
+                }
+                std::string key = name + std::string(args.begin(), args.begin() + function.keyBytes);
+                if (lintSetState(lint, key, value)) {
+                    lintReport(site, kLintRedundantState);
+                }
+                if (name == "glActiveTexture") {
+                    lint.activeTexture = argumentAt<GLenum>(args, 0);
+                }
+                break;
             }
-        }
-        
-        if (urlDataStream != NULL) {
-            std::string urlData = "";
-            xmlChar buffer[256] = {'\0'};
-            while (url_fread(buffer, sizeof(buffer), sizeof(char), urlDataStream) > 0) {
-                for (int i = 0; i < 256; i++) {
-                    /// We intentionally skip over all of the non-ASCII characters
-                    if (buffer[i] > 0 && buffer[i] < 128) {
-                        urlData.push_back((char)buffer[i]);
+            case kLintCheckBindTexture: {
+                std::string key = "glBindTexture" + std::string((const char *)&lint.activeTexture, sizeof(GLenum))
+                 + std::string(args.begin(), args.begin() + sizeof(GLenum));
+                if (lintSetState(lint, key, std::vector<char>(args.begin() + sizeof(GLenum), args.end()))) {
+                    lintReport(site, kLintRedundantState);
+                }
+                break;
+            }
+            case kLintCheckBindBuffer: {
+                GLenum target = argumentAt<GLenum>(args, 0);
+                GLuint buffer = argumentAt<GLuint>(args, 4);
+                if (lint.buffers.count(target) > 0 && lint.buffers[target] == buffer) {
+                    lintReport(site, kLintRedundantState);
+                }
+                lint.buffers[target] = buffer;
+                /// The element buffer binding belongs to the vertex array
+                if (target == GLenum(GL_ELEMENT_ARRAY_BUFFER)) {
+                    lint.vertexArrayElements[lint.vertexArray] = buffer;
+                }
+                break;
+            }
+            case kLintCheckBindIndexedBuffer: {
+                std::string key = std::string(site.oglFuncName) + std::string(args.begin(), args.begin() + 8);
+                if (lintSetState(lint, key, std::vector<char>(args.begin() + 8, args.end()))) {
+                    lintReport(site, kLintRedundantState);
+                }
+                /// Also binds the generic binding point
+                GLenum target = argumentAt<GLenum>(args, 0);
+                GLuint buffer = argumentAt<GLuint>(args, 8);
+                lint.indexedBuffers[std::make_pair(target, argumentAt<GLuint>(args, 4))] = buffer;
+                lint.buffers[target] = buffer;
+                break;
+            }
+            case kLintCheckBindVertexArray: {
+                GLuint vertexArray = argumentAt<GLuint>(args, 0);
+                if (vertexArray == lint.vertexArray) {
+                    lintReport(site, kLintRedundantState);
+                }
+                lint.vertexArray = vertexArray;
+                lint.buffers[GL_ELEMENT_ARRAY_BUFFER] = lint.vertexArrayElements[vertexArray];
+                break;
+            }
+            case kLintCheckUseProgram: {
+                GLuint program = argumentAt<GLuint>(args, 0);
+                if (program == lint.program) {
+                    lintReport(site, kLintRedundantState);
+                }
+                lint.program = program;
+                break;
+            }
+            case kLintCheckLinkProgram: {
+                /// Linking resets the program's uniforms
+                GLuint program = argumentAt<GLuint>(args, 0);
+                std::map<std::pair<GLuint, GLint>, std::vector<char> >::iterator i
+                 = lint.uniforms.lower_bound(std::make_pair(program, (GLint)-1));
+                while (i != lint.uniforms.end() && i->first.first == program) {
+                    lint.uniforms.erase(i++);
+                }
+                break;
+            }
+            case kLintCheckDelete: {
+                /// Deleting a bound object unbinds it, so forget what is bound
+                /// rather than track every kind of object
+                lint.state.clear();
+                lint.buffers.clear();
+                lint.indexedBuffers.clear();
+                lint.vertexArray = (GLuint)-1;
+                /// Names of deleted buffers may be handed out again
+                if (std::string(site.oglFuncName) == "glDeleteBuffers") {
+                    GLsizei count = argumentAt<GLsizei>(args, 0);
+                    const GLuint * names = (const GLuint *)pointerArgumentAt(args, sizeof(GLsizei));
+                    for (GLsizei i = 0; names != NULL && i < count; i++) {
+                        lint.bufferLastDrawn.erase(names[i]);
+                    }
+                }
+                break;
+            }
+            case kLintCheckUniform:
+            case kLintCheckUniformVector:
+            case kLintCheckUniformMatrix: {
+                GLint location = argumentAt<GLint>(args, 0);
+                if (location < 0) {
+                    break;
+                }
+                std::vector<char> value(args.begin() + sizeof(GLint), args.end());
+                if (function.check != kLintCheckUniform) {
+                    /// Compare the values pointed to, not the pointer
+                    size_t pointer = args.size() - sizeof(uint64_t);
+                    size_t size = (size_t)argumentAt<GLsizei>(args, sizeof(GLint)) * function.elementSize;
+                    const char * data = pointerArgumentAt(args, pointer);
+                    value.assign(args.begin() + sizeof(GLint), args.begin() + pointer);
+                    if (data != NULL) {
+                        value.insert(value.end(), data, data + size);
                     }
                 }
+                std::pair<GLuint, GLint> key = std::make_pair(lint.program, location);
+                std::map<std::pair<GLuint, GLint>, std::vector<char> >::iterator found = lint.uniforms.find(key);
+                if (found != lint.uniforms.end() && found->second == value) {
+                    lintReport(site, kLintRedundantUniform);
+                }
+                lint.uniforms[key] = value;
+                break;
             }
-            htmlDocPtr doc = htmlReadDoc((xmlChar*)urlData.c_str(), NULL, NULL,
-             HTML_PARSE_RECOVER | HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING);
-            xmlNodePtr root = xmlDocGetRootElement(doc);
-            std::vector<xmlNodePtr> errorSearch
-             = findXMLNodeChildrenForXPath("//div[@id='errors']/p", root);
-            for (std::vector<xmlNodePtr>::iterator itr = errorSearch.begin();
-                itr != errorSearch.end(); itr++) {
-                
-                std::string content = unannotedXMLNodeContent(*itr);
-                if (content.find("GL_INVALID_ENUM") != std::string::npos) {
-                    invalidEnum.push_back(content);
+            case kLintCheckVertexAttribPointer: {
+                std::vector<GLuint> & buffers = lint.vertexArrayBuffers[lint.vertexArray];
+                GLuint buffer = lint.buffers[GL_ARRAY_BUFFER];
+                if (std::find(buffers.begin(), buffers.end(), buffer) == buffers.end()) {
+                    buffers.push_back(buffer);
                 }
-                else if (content.find("GL_INVALID_VALUE") != std::string::npos) {
-                    invalidValue.push_back(content);
+                break;
+            }
+            case kLintCheckBufferData:
+                /// glBufferData with no data is the orphaning idiom, which
+                /// is exactly how to avoid the stall
+                if (pointerArgumentAt(args, sizeof(GLenum) + sizeof(GLsizeiptr)) != NULL) {
+                    lintBufferWrite(lint, site, argumentAt<GLenum>(args, 0));
                 }
-                else if (content.find("GL_INVALID_OPERATION") != std::string::npos) {
-                    invalidOperation.push_back(content);
+                break;
+            case kLintCheckBufferSubData:
+                lintBufferWrite(lint, site, argumentAt<GLenum>(args, 0));
+                break;
+            case kLintCheckDraw: {
+                std::vector<GLuint> & buffers = lint.vertexArrayBuffers[lint.vertexArray];
+                for (size_t i = 0; i < buffers.size(); i++) {
+                    lintMarkDrawn(lint, buffers[i]);
                 }
-                else if (content.find("GL_INVALID_FRAMEBUFFER_OPERATION") != std::string::npos) {
-                    invalidFramebufferOperation.push_back(content);
+                lintMarkDrawn(lint, lint.vertexArrayElements[lint.vertexArray]);
+                lintMarkDrawn(lint, lint.buffers[GL_DRAW_INDIRECT_BUFFER]);
+                for (std::map<std::pair<GLenum, GLuint>, GLuint>::iterator i = lint.indexedBuffers.begin();
+                    i != lint.indexedBuffers.end(); i++) {
+                    lintMarkDrawn(lint, i->second);
                 }
-                else if (content.find("GL_OUT_OF_MEMORY") != std::string::npos) {
-                    outOfMemory.push_back(content);
+                break;
+            }
+            case kLintCheckLocationQuery:
+                if (lint.frame > 0) {
+                    lintReport(site, kLintLocationQueryInFrame);
                 }
-                else {
-                    errorNotes.push_back(content);
+                break;
+            case kLintCheckObjectQuery: {
+                /// GL_COMPLETION_STATUS_KHR is the non-blocking way to poll
+                /// a parallel compile or link, so it is never a stall
+                const GLenum completionStatus = 0x91B1;
+                if (lint.frame > 0 && argumentAt<GLenum>(args, sizeof(GLuint)) != completionStatus) {
+                    lintReport(site, kLintSyncQueryInFrame);
                 }
+                break;
             }
-            
-            xmlFreeDoc(doc);
-            url_fclose(urlDataStream);
+            case kLintCheckSyncQuery:
+                if (lint.frame > 0) {
+                    lintReport(site, kLintSyncQueryInFrame);
+                }
+                break;
         }
-        else {
-            std::cerr << "{" << __FILE__ << ":" << __LINE__
-             << " (" << __FUNCTION__ << ")} "
-             << "Could not find documentation for function " << function
-             << std::endl;
+    }
+
+    /// Starts the next frame. Location and state queries are only reported
+    /// after the first frame so that setup code is not flagged.
+    static void
+    PerfLintFrameEnd()
+    {
+        perfLint().frame++;
+    }
+
+    static bool
+    lintSiteMoreIssues(const LintSite & a, const LintSite & b)
+    {
+        unsigned long long countA = 0, countB = 0;
+        for (int i = 0; i < kLintIssueCount; i++) {
+            countA += a.issues[i];
+            countB += b.issues[i];
         }
-#endif // GLEE_NETWORKING
+        return countA > countB;
+    }
+
+    /// Prints every call site with issues, most occurrences first.
+    /// Registered with atexit.
+    static void
+    PrintPerfLint()
+    {
+        std::vector<LintSite> sites = perfLint().sites;
+        std::sort(sites.begin(), sites.end(), lintSiteMoreIssues);
         
-        return OpenGLAdditionalErrorInfo(function, url, invalidEnum,
-         invalidValue, invalidOperation, invalidFramebufferOperation,
-         outOfMemory, errorNotes);
+        bool header = false;
+        for (size_t i = 0; i < sites.size(); i++) {
+            for (int issue = 0; issue < kLintIssueCount; issue++) {
+                if (sites[i].issues[issue] == 0) {
+                    continue;
+                }
+                if (!header) {
+                    std::cerr << std::endl << "[GLEE] perf lint report:" << std::endl;
+                    header = true;
+                }
+                std::cerr << std::setw(10) << sites[i].issues[issue] << "x  {"
+                 << sites[i].fileName << ":" << sites[i].lineNumber
+                 << " (" << sites[i].functionName << ")} " << sites[i].oglFuncName
+                 << " " << lintIssueDescription((LintIssue)issue) << std::endl;
+            }
+        }
+    }
+
+#endif // defined(GLEE_OVERWRITE_GL_FUNCTIONS) && defined(GLEE_PERF_LINT)
+
+#if defined(GLEE_OVERWRITE_GL_FUNCTIONS)
+
+    /// A call site of a wrapped function, and the ids the enabled modes gave
+    /// it. Set up once per site by the GLEE_GuardedGLCall macros.
+    struct GuardedCallSite {
+        const char * oglFuncName;
+        const char * functionName;
+        const char * fileName;
+        int lineNumber;
+        /// Whether the first argument is a uniform location to check under
+        /// GLEE_CHECK_UNIFORM_LOCATIONS
+        bool checkLocation;
+#if defined(GLEE_TRACE_CALLS)
+        unsigned short traceId;
+#endif // defined(GLEE_TRACE_CALLS)
+#if defined(GLEE_CALL_STATISTICS)
+        unsigned statisticsSite;
+#endif // defined(GLEE_CALL_STATISTICS)
+#if defined(GLEE_PERF_LINT)
+        unsigned lintSite;
+#endif // defined(GLEE_PERF_LINT)
+    };
+
+    /// Returns the call site `functionName`, `fileName`:`lineNumber` of
+    /// `oglFuncName`. `checkArgName` is the spelling of the argument the
+    /// generated macro names for the location check, "0" when there is none.
+    static GuardedCallSite
+    MakeGuardedCallSite(
+        const char * oglFuncName,
+        const char * functionName,
+        const char * fileName,
+        const int lineNumber,
+        const char * checkArgName)
+    {
+        GuardedCallSite site;
+        site.oglFuncName = oglFuncName;
+        site.functionName = functionName;
+        site.fileName = fileName;
+        site.lineNumber = lineNumber;
+        site.checkLocation = GLEE_DO_CHECK_UNIFORMS && strcmp(checkArgName, "0") != 0;
+#if defined(GLEE_TRACE_CALLS)
+        site.traceId = TraceFunctionId(oglFuncName);
+#endif // defined(GLEE_TRACE_CALLS)
+#if defined(GLEE_CALL_STATISTICS)
+        site.statisticsSite = StatisticsCallSite(oglFuncName, functionName, fileName, lineNumber);
+#endif // defined(GLEE_CALL_STATISTICS)
+#if defined(GLEE_PERF_LINT)
+        site.lintSite = LintCallSite(oglFuncName, functionName, fileName, lineNumber);
+#endif // defined(GLEE_PERF_LINT)
+        return site;
+    }
+
+    /// Names a parameter type without making it deducible, so arguments are
+    /// converted to what the function takes (NULL or 0 for a pointer, ...).
+    template <typename T>
+    struct GuardedParam {
+        typedef T type;
+    };
+
+    template <typename T>
+    static inline bool
+    guardedNegative(T value)
+    {
+        return value < (T)0;
+    }
+
+    template <typename T>
+    static inline bool
+    guardedNegative(T * value)
+    {
+        (void)value;
+        return false;
+    }
+
+    static inline void
+    guardedCheckLocation(const GuardedCallSite & site)
+    {
+        (void)site;
+    }
+
+    /// Reports a negative location passed as the first argument.
+    template <typename T, typename... Rest>
+    static void
+    guardedCheckLocation(const GuardedCallSite & site, T first, Rest... rest)
+    {
+        (void)sizeof...(rest);
+        if (site.checkLocation && guardedNegative(first)) {
+            std::cerr << "{" << site.fileName << ":" << site.lineNumber
+             << " (" << site.functionName
+             << ")} error: [GLEE_CHECK_UNIFORM_LOCATIONS] " << site.oglFuncName << " received a negative value for its 'location' parameter (" << first << ")" << std::endl;
+            assert(false);
+        }
+    }
+
+    /// DESCRIPTION
+    ///
+    ///     Calls `func` with `args` for the wrapper at `site`, with the lint,
+    /// statistics, trace and location check of the enabled modes around it.
+    /// The wrapper macros hand their arguments to this function so each one
+    /// is evaluated exactly once, however many modes look at it. This
+    /// version is used for OpenGL functions with no return value.
+    template <typename... Params>
+    static void
+    GuardedCall(const GuardedCallSite & site, void (GLAPIENTRY * func)(Params...), typename GuardedParam<Params>::type... args)
+    {
+#if defined(GLEE_PERF_LINT)
+        LintCall(site.lintSite, func, args...);
+#endif // defined(GLEE_PERF_LINT)
+#if defined(GLEE_TRACE_CALLS)
+        TraceBeforeCall(site.traceId, func, args...);
+#endif // defined(GLEE_TRACE_CALLS)
+#if defined(GLEE_CALL_STATISTICS)
+        StatisticsClock::time_point start = StatisticsClock::now();
+#endif // defined(GLEE_CALL_STATISTICS)
+        func(args...);
+#if defined(GLEE_CALL_STATISTICS)
+        RecordCallStatistics(site.statisticsSite, start, args...);
+#endif // defined(GLEE_CALL_STATISTICS)
+#if defined(GLEE_TRACE_CALLS)
+        TraceCall(site.traceId, func, args...);
+#endif // defined(GLEE_TRACE_CALLS)
+        guardedCheckLocation(site, args...);
+    }
+
+    /// Same as GuardedCall, for OpenGL functions with a return value.
+    template <typename R, typename... Params>
+    static R
+    GuardedCallWithReturn(const GuardedCallSite & site, R (GLAPIENTRY * func)(Params...), typename GuardedParam<Params>::type... args)
+    {
+#if defined(GLEE_PERF_LINT)
+        LintCall(site.lintSite, func, args...);
+#endif // defined(GLEE_PERF_LINT)
+#if defined(GLEE_TRACE_CALLS)
+        TraceBeforeCall(site.traceId, func, args...);
+#endif // defined(GLEE_TRACE_CALLS)
+#if defined(GLEE_CALL_STATISTICS)
+        StatisticsClock::time_point start = StatisticsClock::now();
+#endif // defined(GLEE_CALL_STATISTICS)
+        R result = func(args...);
+#if defined(GLEE_CALL_STATISTICS)
+        RecordCallStatistics(site.statisticsSite, start, args...);
+#endif // defined(GLEE_CALL_STATISTICS)
+#if defined(GLEE_TRACE_CALLS)
+        TraceCallWithResult(site.traceId, func, result, args...);
+#endif // defined(GLEE_TRACE_CALLS)
+        guardedCheckLocation(site, args...);
+        return result;
     }
-    
-#endif // GLEE_OVERWRITE_GL_FUNCTIONS
+
+#endif // defined(GLEE_OVERWRITE_GL_FUNCTIONS)
 
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-/// 4. Networking
+/// 5. Networking
 ///
 
 #if defined(GLEE_NETWORKING)
@@ -1084,7 +3110,7 @@ struct glee_api {
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
-/// 5. OpenGL Redifinitions
+/// 6. OpenGL Redifinitions
 ///
 }; // struct glee_api
 
@@ -2714,20 +4740,69 @@ struct glee_api {
 
 #if defined(GLEE_OVERWRITE_GL_FUNCTIONS)
 
+#if defined(GLEE_TRACE_CALLS)
+///  Marks the end of a frame in the trace.
+#define GLEE_TraceFrameEnd() glee_api::TraceFrameEnd()
+#else // !defined(GLEE_TRACE_CALLS)
+#define GLEE_TraceFrameEnd() ((void)0)
+#endif // defined(GLEE_TRACE_CALLS)
+
+#if defined(GLEE_CALL_STATISTICS)
+///  Ends the frame's statistics.
+#define GLEE_StatisticsFrameEnd() glee_api::StatisticsFrameEnd()
+#else // !defined(GLEE_CALL_STATISTICS)
+#define GLEE_StatisticsFrameEnd() ((void)0)
+#endif // defined(GLEE_CALL_STATISTICS)
+
+#if defined(GLEE_PERF_LINT)
+///  Marks the end of a frame for the lint.
+#define GLEE_PerfLintFrameEnd() glee_api::PerfLintFrameEnd()
+#else // !defined(GLEE_PERF_LINT)
+#define GLEE_PerfLintFrameEnd() ((void)0)
+#endif // defined(GLEE_PERF_LINT)
+
+///  The call site of `ogl_func`, set up the first time the call is made.
+/// `check_arg` is only stringized, never evaluated.
+#define GLEE_CallSite(ogl_func, check_arg) \
+    static const glee_api::GuardedCallSite __gleeSite = glee_api::MakeGuardedCallSite( #ogl_func, __FUNCTION__, __FILE__, __LINE__, #check_arg)
+
+#if defined(GLEE_DEFERRED_ERROR_CHECKS)
+
+///  Calls `oglfun` with the arguments `...` and records the call site for
+/// the next deferred error poll. This version of the macro is used for OpenGL
+/// functions with no return value.
+#define GLEE_GuardedGLCall(ogl_func, Type, real_func, check_arg, ...) ({\
+    GLEE_CallSite(ogl_func, check_arg); \
+    glee_api::GuardedCall(__gleeSite, real_func, ##__VA_ARGS__); \
+    glee_api::RecordDeferredCall( #ogl_func, __FUNCTION__, __FILE__, __LINE__); \
+})
+
+///  Calls `oglfun` with the arguments `...` and records the call site for
+/// the next deferred error poll. This version of the macro is used for OpenGL
+/// functions with a return value.
+#define GLEE_GuardedGLCallWithReturn(ogl_func, Type, real_func, check_arg, ...) ({\
+    GLEE_CallSite(ogl_func, check_arg); \
+    Type __result = glee_api::GuardedCallWithReturn(__gleeSite, real_func, ##__VA_ARGS__); \
+    glee_api::RecordDeferredCall( #ogl_func, __FUNCTION__, __FILE__, __LINE__); \
+    __result;\
+})
+
+///  Polls for errors raised by any wrapped call since the last poll. Call
+/// this once per frame.
+#define GLEE_CheckDeferredErrors() \
+    glee_api::CheckDeferredOpenGLErrors("error raised since the last check", __FUNCTION__, __FILE__, __LINE__)
+
+#else // !defined(GLEE_DEFERRED_ERROR_CHECKS)
+
 ///  Calls `oglfun` with the arguments `...` in between two
 /// `AssertNoOpenGLErrors` calls that are intended catch errors that occur at
 /// or near the call of `oglfun`. This version of the macro is used for OpenGL
 /// functions with no return value.
 #define GLEE_GuardedGLCall(ogl_func, Type, real_func, check_arg, ...) ({\
     glee_api::AssertNoOpenGLErrors("some function before calling " #ogl_func " threw an error", __FUNCTION__, __FILE__, __LINE__, #ogl_func); \
-    real_func ( __VA_ARGS__ ); \
+    GLEE_CallSite(ogl_func, check_arg); \
+    glee_api::GuardedCall(__gleeSite, real_func, ##__VA_ARGS__); \
     glee_api::AssertNoOpenGLErrors( #ogl_func " threw an error", __FUNCTION__, __FILE__, __LINE__, #ogl_func); \
-    if (GLEE_DO_CHECK_UNIFORMS && check_arg <= -1) {\
-        std::cerr << "{" << __FILE__ << ":" << __LINE__\
-         << " (" << __FUNCTION__\
-         << ")} error: [GLEE_CHECK_UNIFORM_LOCATIONS] " #ogl_func " received a negative value for its 'location' parameter (" << check_arg << ")" << std::endl;\
-        assert(false);\
-    }\
 })
 
 ///  Calls `oglfun` with the arguments `...` in between two
@@ -2736,17 +4811,26 @@ struct glee_api {
 /// functions with a return value.
 #define GLEE_GuardedGLCallWithReturn(ogl_func, Type, real_func, check_arg, ...) ({\
     glee_api::AssertNoOpenGLErrors("some function before calling " #ogl_func " threw an error", __FUNCTION__, __FILE__, __LINE__, #ogl_func); \
-    Type __result = real_func ( __VA_ARGS__ ); \
+    GLEE_CallSite(ogl_func, check_arg); \
+    Type __result = glee_api::GuardedCallWithReturn(__gleeSite, real_func, ##__VA_ARGS__); \
     glee_api::AssertNoOpenGLErrors( #ogl_func " threw an error", __FUNCTION__, __FILE__, __LINE__, #ogl_func); \
-    if (GLEE_DO_CHECK_UNIFORMS && check_arg <= -1) {\
-        std::cerr << "{" << __FILE__ << ":" << __LINE__\
-         << " (" << __FUNCTION__\
-         << ")} error: [GLEE_CHECK_UNIFORM_LOCATIONS] " #ogl_func " received a negative value for its 'location' parameter (" << check_arg << ")" << std::endl;\
-        assert(false);\
-    }\
     __result;\
 })
 
+///  Errors are already checked around every call in this mode.
+#define GLEE_CheckDeferredErrors() ((void)0)
+
+#endif // defined(GLEE_DEFERRED_ERROR_CHECKS)
+
+///  Call once at the end of every frame. Polls for deferred errors, marks
+/// the frame boundary in the trace and ends the frame's statistics and lint.
+#define GLEE_EndFrame() ({\
+    GLEE_CheckDeferredErrors(); \
+    GLEE_TraceFrameEnd(); \
+    GLEE_StatisticsFrameEnd(); \
+    GLEE_PerfLintFrameEnd(); \
+})
+
 #define glAccum(op, value) GLEE_GuardedGLCall(glAccum, void, glAccum_RealName, 0, op, value)
 #define glActiveShaderProgram(pipeline, program) GLEE_GuardedGLCall(glActiveShaderProgram, void, glActiveShaderProgram_RealName, 0, pipeline, program)
 #define glActiveTexture(texture) GLEE_GuardedGLCall(glActiveTexture, void, glActiveTexture_RealName, 0, texture)
@@ -3501,6 +5585,12 @@ struct glee_api {
 #define glViewportIndexedfv(index, v) GLEE_GuardedGLCall(glViewportIndexedfv, void, glViewportIndexedfv_RealName, 0, index, v)
 #define glWaitSync(sync, flags, timeout) GLEE_GuardedGLCall(glWaitSync, void, glWaitSync_RealName, 0, sync, flags, timeout)
 
+#else // !defined(GLEE_OVERWRITE_GL_FUNCTIONS)
+
+///  Nothing is wrapped, so there is nothing to check.
+#define GLEE_CheckDeferredErrors() ((void)0)
+#define GLEE_EndFrame() ((void)0)
+
 #endif // defined(GLEE_OVERWRITE_GL_FUNCTIONS)
 
 
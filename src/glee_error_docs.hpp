@@ -0,0 +1,583 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+///  glee_error_docs.hpp
+///  (Automatically generated by glee_docgen)
+///
+///  Offline copy of the Errors section of the OpenGL reference pages,
+/// included inside glee_api by glee.hpp. Do not edit by hand; regenerate
+/// it with
+///
+///      glee_docgen > src/glee_error_docs.hpp
+///
+/// which fetches every page listed below again, or pass page names to
+/// fetch a different set.
+///
+
+    /// The number of pages in ErrorDocs().
+    static int
+    ErrorDocCount()
+    {
+        return 45;
+    }
+
+    /// Every documented page, sorted by name.
+    static const OpenGLErrorDoc *
+    ErrorDocs()
+    {
+        static const OpenGLErrorDoc __docs[] = {
+            {
+                "glActiveTexture",
+                "https://www.opengl.org/sdk/docs/man/html/glActiveTexture.xhtml",
+                "GL_INVALID_ENUM is generated if texture is not one of GL_TEXTUREi, where i ranges from zero to the value of GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS minus one.",
+                "",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glAttachShader",
+                "https://www.opengl.org/sdk/docs/man/html/glAttachShader.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if either program or shader is not a value generated by OpenGL.",
+                "GL_INVALID_OPERATION is generated if program is not a program object.\n"
+                "GL_INVALID_OPERATION is generated if shader is not a shader object.\n"
+                "GL_INVALID_OPERATION is generated if shader is already attached to program.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glBindBuffer",
+                "https://www.opengl.org/sdk/docs/man/html/glBindBuffer.xhtml",
+                "GL_INVALID_ENUM is generated if target is not one of the allowable values.",
+                "GL_INVALID_VALUE is generated if buffer is not a name previously returned from a call to glGenBuffers.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glBindBufferBase",
+                "https://www.opengl.org/sdk/docs/man/html/glBindBufferBase.xhtml",
+                "GL_INVALID_ENUM is generated if target is not GL_ATOMIC_COUNTER_BUFFER, GL_TRANSFORM_FEEDBACK_BUFFER, GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER.",
+                "GL_INVALID_VALUE is generated if index is greater than or equal to the number of target-specific indexed binding points.\n"
+                "GL_INVALID_VALUE is generated if buffer does not have an associated data store, or if the size of that store is zero.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glBindBufferRange",
+                "https://www.opengl.org/sdk/docs/man/html/glBindBufferRange.xhtml",
+                "GL_INVALID_ENUM is generated if target is not GL_ATOMIC_COUNTER_BUFFER, GL_TRANSFORM_FEEDBACK_BUFFER, GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER.",
+                "GL_INVALID_VALUE is generated if index is greater than or equal to the number of target-specific indexed binding points.\n"
+                "GL_INVALID_VALUE is generated if size is less than or equal to zero, or if offset + size is greater than the value of GL_BUFFER_SIZE.\n"
+                "GL_INVALID_VALUE is generated if target is GL_UNIFORM_BUFFER and offset is not a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glBindTexture",
+                "https://www.opengl.org/sdk/docs/man/html/glBindTexture.xhtml",
+                "GL_INVALID_ENUM is generated if target is not one of the allowable values.",
+                "GL_INVALID_VALUE is generated if texture is not a name returned from a previous call to glGenTextures.",
+                "GL_INVALID_OPERATION is generated if texture was previously created with a target that doesn't match that of target.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glBindVertexArray",
+                "https://www.opengl.org/sdk/docs/man/html/glBindVertexArray.xhtml",
+                "",
+                "",
+                "GL_INVALID_OPERATION is generated if array is not zero or the name of a vertex array object previously returned from a call to glGenVertexArrays.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glBlendFunc",
+                "https://www.opengl.org/sdk/docs/man/html/glBlendFunc.xhtml",
+                "GL_INVALID_ENUM is generated if either sfactor or dfactor is not an accepted value.",
+                "GL_INVALID_VALUE is generated by glBlendFunci if buf is greater than or equal to the value of GL_MAX_DRAW_BUFFERS.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glBufferData",
+                "https://www.opengl.org/sdk/docs/man/html/glBufferData.xhtml",
+                "GL_INVALID_ENUM is generated by glBufferData if target is not one of the accepted buffer targets.\n"
+                "GL_INVALID_ENUM is generated if usage is not GL_STREAM_DRAW, GL_STREAM_READ, GL_STREAM_COPY, GL_STATIC_DRAW, GL_STATIC_READ, GL_STATIC_COPY, GL_DYNAMIC_DRAW, GL_DYNAMIC_READ, or GL_DYNAMIC_COPY.",
+                "GL_INVALID_VALUE is generated if size is negative.",
+                "GL_INVALID_OPERATION is generated by glBufferData if the reserved buffer object name 0 is bound to target.\n"
+                "GL_INVALID_OPERATION is generated if the GL_BUFFER_IMMUTABLE_STORAGE flag of the buffer object is GL_TRUE.",
+                "",
+                "GL_OUT_OF_MEMORY is generated if the GL is unable to create a data store with the specified size.",
+                ""
+            },
+            {
+                "glBufferStorage",
+                "https://www.opengl.org/sdk/docs/man/html/glBufferStorage.xhtml",
+                "GL_INVALID_ENUM is generated by glBufferStorage if target is not one of the accepted buffer targets.",
+                "GL_INVALID_VALUE is generated if size is less than or equal to zero.\n"
+                "GL_INVALID_VALUE is generated if flags has any bits set other than those defined above.\n"
+                "GL_INVALID_VALUE is generated if flags contains GL_MAP_PERSISTENT_BIT but does not contain at least one of GL_MAP_READ_BIT or GL_MAP_WRITE_BIT.\n"
+                "GL_INVALID_VALUE is generated if flags contains GL_MAP_COHERENT_BIT, but does not also contain GL_MAP_PERSISTENT_BIT.",
+                "GL_INVALID_OPERATION is generated by glBufferStorage if the reserved buffer object name 0 is bound to target.\n"
+                "GL_INVALID_OPERATION is generated if the GL_BUFFER_IMMUTABLE_STORAGE flag of the buffer bound to target is GL_TRUE.",
+                "",
+                "GL_OUT_OF_MEMORY is generated if the GL is unable to create a data store with the properties requested in flags.",
+                ""
+            },
+            {
+                "glBufferSubData",
+                "https://www.opengl.org/sdk/docs/man/html/glBufferSubData.xhtml",
+                "GL_INVALID_ENUM is generated by glBufferSubData if target is not one of the accepted buffer targets.",
+                "GL_INVALID_VALUE is generated if offset or size is negative, or if offset + size is greater than the value of GL_BUFFER_SIZE for the specified buffer object.",
+                "GL_INVALID_OPERATION is generated by glBufferSubData if zero is bound to target.\n"
+                "GL_INVALID_OPERATION is generated if any part of the specified range of the buffer object is mapped with glMapBufferRange or glMapBuffer, unless it was mapped with the GL_MAP_PERSISTENT_BIT bit set in the glMapBufferRange access flags.\n"
+                "GL_INVALID_OPERATION is generated if the value of the GL_BUFFER_IMMUTABLE_STORAGE flag of the buffer object is GL_TRUE and the value of GL_BUFFER_STORAGE_FLAGS for the buffer object does not have the GL_DYNAMIC_STORAGE_BIT bit set.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glClear",
+                "https://www.opengl.org/sdk/docs/man/html/glClear.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if any bit other than the three defined bits is set in mask.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glClientWaitSync",
+                "https://www.opengl.org/sdk/docs/man/html/glClientWaitSync.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if sync is not the name of an existing sync object.\n"
+                "GL_INVALID_VALUE is generated if flags contains any unsupported flag.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glCompileShader",
+                "https://www.opengl.org/sdk/docs/man/html/glCompileShader.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if shader is not a value generated by OpenGL.",
+                "GL_INVALID_OPERATION is generated if shader is not a shader object.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glCreateShader",
+                "https://www.opengl.org/sdk/docs/man/html/glCreateShader.xhtml",
+                "GL_INVALID_ENUM is generated if shaderType is not an accepted value.",
+                "",
+                "",
+                "",
+                "",
+                "This function returns 0 if an error occurs creating the shader object."
+            },
+            {
+                "glDeleteBuffers",
+                "https://www.opengl.org/sdk/docs/man/html/glDeleteBuffers.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if n is negative.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glDrawElements",
+                "https://www.opengl.org/sdk/docs/man/html/glDrawElements.xhtml",
+                "GL_INVALID_ENUM is generated if mode is not an accepted value.",
+                "GL_INVALID_VALUE is generated if count is negative.",
+                "GL_INVALID_OPERATION is generated if a geometry shader is active and mode is incompatible with the input primitive type of the geometry shader in the currently installed program object.\n"
+                "GL_INVALID_OPERATION is generated if a non-zero buffer object name is bound to an enabled array or the element array and the buffer object's data store is currently mapped.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glDrawElementsInstanced",
+                "https://www.opengl.org/sdk/docs/man/html/glDrawElementsInstanced.xhtml",
+                "GL_INVALID_ENUM is generated if mode is not one of the accepted values.\n"
+                "GL_INVALID_ENUM is generated if type is not one of GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, or GL_UNSIGNED_INT.",
+                "GL_INVALID_VALUE is generated if count or instancecount are negative.",
+                "GL_INVALID_OPERATION is generated if a geometry shader is active and mode is incompatible with the input primitive type of the geometry shader in the currently installed program object.\n"
+                "GL_INVALID_OPERATION is generated if a non-zero buffer object name is bound to an enabled array and the buffer object's data store is currently mapped.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glDrawElementsInstancedBaseVertex",
+                "https://www.opengl.org/sdk/docs/man/html/glDrawElementsInstancedBaseVertex.xhtml",
+                "GL_INVALID_ENUM is generated if mode is not an accepted value.",
+                "GL_INVALID_VALUE is generated if count or instancecount is negative.",
+                "GL_INVALID_OPERATION is generated if a geometry shader is active and mode is incompatible with the input primitive type of the geometry shader in the currently installed program object.\n"
+                "GL_INVALID_OPERATION is generated if a non-zero buffer object name is bound to an enabled array or the element array and the buffer object's data store is currently mapped.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glEnable",
+                "https://www.opengl.org/sdk/docs/man/html/glEnable.xhtml",
+                "GL_INVALID_ENUM is generated if cap is not one of the values listed previously.",
+                "GL_INVALID_VALUE is generated by glEnablei and glDisablei if index is greater than or equal to the number of indexed capabilities for cap.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glEnableVertexAttribArray",
+                "https://www.opengl.org/sdk/docs/man/html/glEnableVertexAttribArray.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if index is greater than or equal to GL_MAX_VERTEX_ATTRIBS.",
+                "GL_INVALID_OPERATION is generated by glEnableVertexAttribArray and glDisableVertexAttribArray if no vertex array object is bound.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glFenceSync",
+                "https://www.opengl.org/sdk/docs/man/html/glFenceSync.xhtml",
+                "GL_INVALID_ENUM is generated if condition is not GL_SYNC_GPU_COMMANDS_COMPLETE.",
+                "GL_INVALID_VALUE is generated if flags is not zero.",
+                "",
+                "",
+                "",
+                "If the fence sync object cannot be created, glFenceSync returns zero."
+            },
+            {
+                "glGenBuffers",
+                "https://www.opengl.org/sdk/docs/man/html/glGenBuffers.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if n is negative.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glGenTextures",
+                "https://www.opengl.org/sdk/docs/man/html/glGenTextures.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if n is negative.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glGenVertexArrays",
+                "https://www.opengl.org/sdk/docs/man/html/glGenVertexArrays.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if n is negative.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glGenerateMipmap",
+                "https://www.opengl.org/sdk/docs/man/html/glGenerateMipmap.xhtml",
+                "GL_INVALID_ENUM is generated by glGenerateMipmap if target is not one of the accepted texture targets.",
+                "",
+                "GL_INVALID_OPERATION is generated if target is GL_TEXTURE_CUBE_MAP or GL_TEXTURE_CUBE_MAP_ARRAY, and the specified texture object is not cube complete or cube array complete, respectively.\n"
+                "GL_INVALID_OPERATION is generated if the base level of the texture has a compressed or depth/stencil internal format.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glGetAttribLocation",
+                "https://www.opengl.org/sdk/docs/man/html/glGetAttribLocation.xhtml",
+                "",
+                "",
+                "GL_INVALID_OPERATION is generated if program is not a value generated by OpenGL.\n"
+                "GL_INVALID_OPERATION is generated if program is not a program object.\n"
+                "GL_INVALID_OPERATION is generated if program has not been successfully linked.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glGetProgram",
+                "https://www.opengl.org/sdk/docs/man/html/glGetProgram.xhtml",
+                "GL_INVALID_ENUM is generated if pname is not an accepted value.",
+                "GL_INVALID_VALUE is generated if program is not a value generated by OpenGL.",
+                "GL_INVALID_OPERATION is generated if program does not refer to a program object.\n"
+                "GL_INVALID_OPERATION is generated if pname is GL_GEOMETRY_VERTICES_OUT, GL_GEOMETRY_INPUT_TYPE, or GL_GEOMETRY_OUTPUT_TYPE, and program does not contain a geometry shader.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glGetShader",
+                "https://www.opengl.org/sdk/docs/man/html/glGetShader.xhtml",
+                "GL_INVALID_ENUM is generated if pname is not an accepted value.",
+                "GL_INVALID_VALUE is generated if shader is not a value generated by OpenGL.",
+                "GL_INVALID_OPERATION is generated if shader does not refer to a shader object.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glGetUniformBlockIndex",
+                "https://www.opengl.org/sdk/docs/man/html/glGetUniformBlockIndex.xhtml",
+                "",
+                "",
+                "GL_INVALID_OPERATION is generated if program is not the name of a program object for which glLinkProgram has been called in the past.",
+                "",
+                "",
+                "GL_INVALID_INDEX is returned if uniformBlockName does not identify an active uniform block of program."
+            },
+            {
+                "glGetUniformLocation",
+                "https://www.opengl.org/sdk/docs/man/html/glGetUniformLocation.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if program is not a value generated by OpenGL.",
+                "GL_INVALID_OPERATION is generated if program is not a program object.\n"
+                "GL_INVALID_OPERATION is generated if program has not been successfully linked.",
+                "",
+                "",
+                "This function returns -1 if name does not correspond to an active uniform variable in program, if name starts with the reserved prefix \"gl_\", or if name is associated with an atomic counter or a named uniform block."
+            },
+            {
+                "glLinkProgram",
+                "https://www.opengl.org/sdk/docs/man/html/glLinkProgram.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if program is not a value generated by OpenGL.",
+                "GL_INVALID_OPERATION is generated if program is not a program object.\n"
+                "GL_INVALID_OPERATION is generated if program is the currently active program object and transform feedback mode is active.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glMapBufferRange",
+                "https://www.opengl.org/sdk/docs/man/html/glMapBufferRange.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if either of offset or length is negative, or if offset + length is greater than the value of GL_BUFFER_SIZE for the buffer object, or if access has any bits set other than those defined above.",
+                "GL_INVALID_OPERATION is generated for any of the following conditions: length is zero; the buffer object is already in a mapped state; neither GL_MAP_READ_BIT nor GL_MAP_WRITE_BIT is set; GL_MAP_READ_BIT is set and any of GL_MAP_INVALIDATE_RANGE_BIT, GL_MAP_INVALIDATE_BUFFER_BIT or GL_MAP_UNSYNCHRONIZED_BIT is set; GL_MAP_FLUSH_EXPLICIT_BIT is set and GL_MAP_WRITE_BIT is not set; any of GL_MAP_READ_BIT, GL_MAP_WRITE_BIT, GL_MAP_PERSISTENT_BIT, or GL_MAP_COHERENT_BIT are set, but the same bit is not included in the buffer's storage flags.",
+                "",
+                "GL_OUT_OF_MEMORY is generated by glMapBufferRange if the GL is unable to map the buffer range.",
+                ""
+            },
+            {
+                "glMultiDrawElementsBaseVertex",
+                "https://www.opengl.org/sdk/docs/man/html/glMultiDrawElementsBaseVertex.xhtml",
+                "GL_INVALID_ENUM is generated if mode is not an accepted value.",
+                "GL_INVALID_VALUE is generated if drawcount is negative.",
+                "GL_INVALID_OPERATION is generated if a geometry shader is active and mode is incompatible with the input primitive type of the geometry shader in the currently installed program object.\n"
+                "GL_INVALID_OPERATION is generated if a non-zero buffer object name is bound to an enabled array or the element array and the buffer object's data store is currently mapped.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glMultiDrawElementsIndirect",
+                "https://www.opengl.org/sdk/docs/man/html/glMultiDrawElementsIndirect.xhtml",
+                "GL_INVALID_ENUM is generated if mode is not an accepted value.",
+                "GL_INVALID_VALUE is generated if stride is not a multiple of four, or if drawcount is negative.",
+                "GL_INVALID_OPERATION is generated if no buffer is bound to the GL_ELEMENT_ARRAY_BUFFER binding, or if such a buffer's data store is currently mapped.\n"
+                "GL_INVALID_OPERATION is generated if zero is bound to GL_DRAW_INDIRECT_BUFFER and the command would source its arguments from client memory in a core profile context, or if the command would source data beyond the end of the buffer object.\n"
+                "GL_INVALID_OPERATION is generated if a non-zero buffer object name is bound to an enabled array or to the GL_DRAW_INDIRECT_BUFFER binding and the buffer object's data store is currently mapped.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glShaderSource",
+                "https://www.opengl.org/sdk/docs/man/html/glShaderSource.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if shader is not a value generated by OpenGL.\n"
+                "GL_INVALID_VALUE is generated if count is less than 0.",
+                "GL_INVALID_OPERATION is generated if shader is not a shader object.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glTexImage2D",
+                "https://www.opengl.org/sdk/docs/man/html/glTexImage2D.xhtml",
+                "GL_INVALID_ENUM is generated if target is not an accepted texture target.\n"
+                "GL_INVALID_ENUM is generated if type is not a type constant.",
+                "GL_INVALID_VALUE is generated if width is less than 0 or greater than GL_MAX_TEXTURE_SIZE.\n"
+                "GL_INVALID_VALUE is generated if level is less than 0, or greater than log2(max), where max is the returned value of GL_MAX_TEXTURE_SIZE.\n"
+                "GL_INVALID_VALUE is generated if internalFormat is not one of the accepted resolution and format symbolic constants.\n"
+                "GL_INVALID_VALUE is generated if width or height is less than 0 or greater than GL_MAX_TEXTURE_SIZE, or if border is not 0.",
+                "GL_INVALID_OPERATION is generated if type is one of the packed types (for example GL_UNSIGNED_SHORT_5_6_5) and format does not match it.\n"
+                "GL_INVALID_OPERATION is generated if a non-zero buffer object name is bound to the GL_PIXEL_UNPACK_BUFFER target and the buffer object's data store is currently mapped, or the data would be unpacked from beyond the end of the buffer.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glTexParameter",
+                "https://www.opengl.org/sdk/docs/man/html/glTexParameter.xhtml",
+                "GL_INVALID_ENUM is generated by glTexParameter if target is not one of the accepted defined values.\n"
+                "GL_INVALID_ENUM is generated if pname is not one of the accepted defined values.\n"
+                "GL_INVALID_ENUM is generated if params should have a defined constant value (based on the value of pname) and does not.",
+                "GL_INVALID_VALUE is generated if pname is GL_TEXTURE_BASE_LEVEL or GL_TEXTURE_MAX_LEVEL, and param or params is negative.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glUniform",
+                "https://www.opengl.org/sdk/docs/man/html/glUniform.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if count is less than 0.",
+                "GL_INVALID_OPERATION is generated if there is no current program object.\n"
+                "GL_INVALID_OPERATION is generated if the size of the uniform variable declared in the shader does not match the size indicated by the glUniform command.\n"
+                "GL_INVALID_OPERATION is generated if one of the signed or unsigned integer variants of this function is used to load a uniform variable of type float, vec2, vec3, vec4, or an array of these, or if one of the floating-point variants of this function is used to load a uniform variable of type int, ivec2, ivec3, ivec4, unsigned int, uvec2, uvec3, uvec4, or an array of these.\n"
+                "GL_INVALID_OPERATION is generated if location is an invalid uniform location for the current program object and location is not equal to -1.\n"
+                "GL_INVALID_OPERATION is generated if count is greater than 1 and the indicated uniform variable is not an array variable.\n"
+                "GL_INVALID_OPERATION is generated if a sampler is loaded using a command other than glUniform1i and glUniform1iv.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glUniformBlockBinding",
+                "https://www.opengl.org/sdk/docs/man/html/glUniformBlockBinding.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if uniformBlockIndex is not an active uniform block index of program, or if uniformBlockBinding is greater than or equal to the value of GL_MAX_UNIFORM_BUFFER_BINDINGS.\n"
+                "GL_INVALID_VALUE is generated if program is not the name of a program object generated by the GL.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glUnmapBuffer",
+                "https://www.opengl.org/sdk/docs/man/html/glUnmapBuffer.xhtml",
+                "GL_INVALID_ENUM is generated by glUnmapBuffer if target is not one of the buffer binding targets.",
+                "",
+                "GL_INVALID_OPERATION is generated by glUnmapBuffer if zero is bound to target.\n"
+                "GL_INVALID_OPERATION is generated if the buffer object is not in a mapped state.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glUseProgram",
+                "https://www.opengl.org/sdk/docs/man/html/glUseProgram.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if program is neither 0 nor a value generated by OpenGL.",
+                "GL_INVALID_OPERATION is generated if program is not a program object.\n"
+                "GL_INVALID_OPERATION is generated if program could not be made part of current state.\n"
+                "GL_INVALID_OPERATION is generated if transform feedback mode is active.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glVertexAttribDivisor",
+                "https://www.opengl.org/sdk/docs/man/html/glVertexAttribDivisor.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if index is greater than or equal to the value of GL_MAX_VERTEX_ATTRIBS.",
+                "",
+                "",
+                "",
+                ""
+            },
+            {
+                "glVertexAttribPointer",
+                "https://www.opengl.org/sdk/docs/man/html/glVertexAttribPointer.xhtml",
+                "GL_INVALID_ENUM is generated if type is not an accepted value.",
+                "GL_INVALID_VALUE is generated if index is greater than or equal to GL_MAX_VERTEX_ATTRIBS.\n"
+                "GL_INVALID_VALUE is generated if size is not 1, 2, 3, 4 or (for glVertexAttribPointer), GL_BGRA.\n"
+                "GL_INVALID_VALUE is generated if stride is negative.",
+                "GL_INVALID_OPERATION is generated if size is GL_BGRA and type is not GL_UNSIGNED_BYTE, GL_INT_2_10_10_10_REV or GL_UNSIGNED_INT_2_10_10_10_REV.\n"
+                "GL_INVALID_OPERATION is generated if zero is bound to the GL_ARRAY_BUFFER buffer object binding point and the pointer argument is not NULL.\n"
+                "GL_INVALID_OPERATION is generated if no vertex array object is bound.",
+                "",
+                "",
+                ""
+            },
+            {
+                "glViewport",
+                "https://www.opengl.org/sdk/docs/man/html/glViewport.xhtml",
+                "",
+                "GL_INVALID_VALUE is generated if either width or height is negative.",
+                "",
+                "",
+                "",
+                ""
+            }
+        };
+        return __docs;
+    }
+
+    /// The index in ErrorDocs() of the page whose name hashes to `hash`, or
+    /// -1 if there is none. Callers still have to compare the name.
+    static int
+    ErrorDocIndex(unsigned hash)
+    {
+        switch (hash) {
+            case ErrorDocHash("glActiveTexture"): return 0;
+            case ErrorDocHash("glAttachShader"): return 1;
+            case ErrorDocHash("glBindBuffer"): return 2;
+            case ErrorDocHash("glBindBufferBase"): return 3;
+            case ErrorDocHash("glBindBufferRange"): return 4;
+            case ErrorDocHash("glBindTexture"): return 5;
+            case ErrorDocHash("glBindVertexArray"): return 6;
+            case ErrorDocHash("glBlendFunc"): return 7;
+            case ErrorDocHash("glBufferData"): return 8;
+            case ErrorDocHash("glBufferStorage"): return 9;
+            case ErrorDocHash("glBufferSubData"): return 10;
+            case ErrorDocHash("glClear"): return 11;
+            case ErrorDocHash("glClientWaitSync"): return 12;
+            case ErrorDocHash("glCompileShader"): return 13;
+            case ErrorDocHash("glCreateShader"): return 14;
+            case ErrorDocHash("glDeleteBuffers"): return 15;
+            case ErrorDocHash("glDrawElements"): return 16;
+            case ErrorDocHash("glDrawElementsInstanced"): return 17;
+            case ErrorDocHash("glDrawElementsInstancedBaseVertex"): return 18;
+            case ErrorDocHash("glEnable"): return 19;
+            case ErrorDocHash("glEnableVertexAttribArray"): return 20;
+            case ErrorDocHash("glFenceSync"): return 21;
+            case ErrorDocHash("glGenBuffers"): return 22;
+            case ErrorDocHash("glGenTextures"): return 23;
+            case ErrorDocHash("glGenVertexArrays"): return 24;
+            case ErrorDocHash("glGenerateMipmap"): return 25;
+            case ErrorDocHash("glGetAttribLocation"): return 26;
+            case ErrorDocHash("glGetProgram"): return 27;
+            case ErrorDocHash("glGetShader"): return 28;
+            case ErrorDocHash("glGetUniformBlockIndex"): return 29;
+            case ErrorDocHash("glGetUniformLocation"): return 30;
+            case ErrorDocHash("glLinkProgram"): return 31;
+            case ErrorDocHash("glMapBufferRange"): return 32;
+            case ErrorDocHash("glMultiDrawElementsBaseVertex"): return 33;
+            case ErrorDocHash("glMultiDrawElementsIndirect"): return 34;
+            case ErrorDocHash("glShaderSource"): return 35;
+            case ErrorDocHash("glTexImage2D"): return 36;
+            case ErrorDocHash("glTexParameter"): return 37;
+            case ErrorDocHash("glUniform"): return 38;
+            case ErrorDocHash("glUniformBlockBinding"): return 39;
+            case ErrorDocHash("glUnmapBuffer"): return 40;
+            case ErrorDocHash("glUseProgram"): return 41;
+            case ErrorDocHash("glVertexAttribDivisor"): return 42;
+            case ErrorDocHash("glVertexAttribPointer"): return 43;
+            case ErrorDocHash("glViewport"): return 44;
+            default: return -1;
+        }
+    }
@@ -0,0 +1,95 @@
+#include "image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc_track.h"
+
+// Helper functions for image load
+static unsigned int getint(const unsigned char *p) {
+	return ((unsigned int) p[0]) + (((unsigned int) p[1]) << 8) +
+	(((unsigned int) p[2]) << 16) + (((unsigned int) p[3]) << 24);
+}
+
+static unsigned int getshort(const unsigned char *p) {
+	return ((unsigned int) p[0]) + (((unsigned int) p[1]) << 8);
+}
+
+int imageLoad(const AssetArchive *archive, const char *filename,
+  Image *image) {
+	ALLOC_TAG(ALLOC_IMAGE);
+	VirtualFile file;
+	const unsigned char *header;
+	unsigned long size; // Size of the image in bytes
+	unsigned long i; // Standard counter
+	unsigned short int planes; // Number of planes in image (must be 1)
+	unsigned short int bpp; // Number of bits per pixel (must be 24)
+	char temp; // Used to convert bgr to rgb color
+	
+	// Make sure the file is there
+	if(!virtualFileOpen(archive, filename, &file)) {
+		printf("File Not Found : %s\n", filename);
+		return 0;
+	}
+	if(file.size < BMP_HEADER_SIZE) {
+		printf("Error reading image header from %s.\n", filename);
+		virtualFileClose(&file);
+		return 0;
+	}
+	header = (const unsigned char *) file.data;
+	
+	// No 100% errorchecking anymore!!!
+	
+	// Read the width, past the first 18 bytes of the header
+  image->sizeX = getint(header + 18);
+	
+	// Read the height
+	image->sizeY = getint(header + 22);
+	
+	// Calculate the size (assuming 24 bits or 3 bytes per pixel)
+	size = image->sizeX * image->sizeY * 3;
+	
+	// Read the planes
+	planes = getshort(header + 26);
+	if(planes != 1) {
+		printf("Planes from %s is not 1: %u\n", filename, planes);
+		virtualFileClose(&file);
+		return 0;
+	}
+	
+	// Read the bpp
+	bpp = getshort(header + 28);
+	if(bpp != 24) {
+		printf("Bpp from %s is not 24: %u\n", filename, bpp);
+		virtualFileClose(&file);
+		return 0;
+	}
+	
+	// The data follows the bitmap header
+	if(file.size - BMP_HEADER_SIZE < size) {
+		printf("Error reading image data from %s.\n", filename);
+		virtualFileClose(&file);
+		return 0;
+	}
+	
+	// Copy the data, the file may be mapped read only
+	image->data = (char *) malloc(size);
+	if(image->data == NULL) {
+		printf("Error allocating memory for color-corrected image data");
+		virtualFileClose(&file);
+		return 0;
+	}
+	memcpy(image->data, file.data + BMP_HEADER_SIZE, size);
+	
+	for(i = 0; i < size; i += 3) { // Reverse all of the colors (bgr -> rgb)
+		temp = image->data[i];
+		image->data[i] = image->data[i+2];
+		image->data[i+2] = temp;
+	}
+	
+	virtualFileClose(&file); // Release the buffer or the mapping
+	
+	// We're done
+	return 1;
+}
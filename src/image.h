@@ -0,0 +1,21 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include "asset_archive.h"
+
+// Image code, for textures
+struct Image {
+  int sizeX, sizeY;
+  char *data;
+};
+
+// Bytes of bmp header before the pixels
+#define BMP_HEADER_SIZE 54
+
+// Read a 24 bit uncompressed bmp through the archive (or from disk). data
+// is malloced RGB8, rows from bottom to top like glTexImage2D takes them.
+// Returns 0, printing why, if the file is missing or in another format.
+int imageLoad(const AssetArchive *archive, const char *filename,
+  Image *image);
+
+#endif
@@ -0,0 +1,122 @@
+#include "job_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobPoolState {
+  // Worker threads wait for a new generation of jobs
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable wake, done;
+  unsigned generation;
+  bool quit;
+  JobFunc job;
+  void *context;
+  int jobCount;
+  std::atomic<int> next;
+  int busy;
+};
+
+// Take jobs until the current generation runs out
+static void drainJobs(JobPoolState *s) {
+  for(;;) {
+    int i = s->next++;
+    if(i >= s->jobCount) {
+      return;
+    }
+    s->job(s->context, i);
+  }
+}
+
+static void workerMain(JobPoolState *s) {
+  unsigned seen = 0;
+  for(;;) {
+    {
+      std::unique_lock<std::mutex> lock(s->mutex);
+      while(!s->quit && s->generation == seen) {
+        s->wake.wait(lock);
+      }
+      if(s->quit) {
+        return;
+      }
+      seen = s->generation;
+    }
+    drainJobs(s);
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if(--s->busy == 0) {
+      s->done.notify_one();
+    }
+  }
+}
+
+void jobPoolInit(JobPool *pool, int threads) {
+  if(threads <= 0) {
+    threads = (int) std::thread::hardware_concurrency();
+  }
+  if(threads <= 0) {
+    threads = 1;
+  }
+  JobPoolState *s = new JobPoolState();
+  s->generation = 0;
+  s->quit = false;
+  s->job = NULL;
+  s->context = NULL;
+  s->jobCount = 0;
+  s->next = 0;
+  s->busy = 0;
+  for(int i = 1; i < threads; i++) {
+    s->threads.push_back(std::thread(workerMain, s));
+  }
+  pool->threads = threads;
+  pool->state = s;
+}
+
+void jobPoolRun(JobPool *pool, JobFunc job, void *context, int count) {
+  JobPoolState *s = pool->state;
+  if(s->threads.empty()) {
+    for(int i = 0; i < count; i++) {
+      job(context, i);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    s->job = job;
+    s->context = context;
+    s->jobCount = count;
+    s->next = 0;
+    s->busy = (int) s->threads.size();
+    s->generation++;
+  }
+  s->wake.notify_all();
+  drainJobs(s);
+  std::unique_lock<std::mutex> lock(s->mutex);
+  while(s->busy > 0) {
+    s->done.wait(lock);
+  }
+}
+
+void jobPoolDestroy(JobPool *pool) {
+  JobPoolState *s = pool->state;
+  if(s != NULL) {
+    {
+      std::lock_guard<std::mutex> lock(s->mutex);
+      s->quit = true;
+    }
+    s->wake.notify_all();
+    for(size_t i = 0; i < s->threads.size(); i++) {
+      s->threads[i].join();
+    }
+    delete s;
+  }
+  pool->threads = 0;
+  pool->state = NULL;
+}
+
+void jobRange(size_t count, int jobs, int i, size_t *begin, size_t *end) {
+  *begin = count * i / jobs;
+  *end = count * (i + 1) / jobs;
+}
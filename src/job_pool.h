@@ -0,0 +1,29 @@
+#ifndef JOB_POOL_H
+#define JOB_POOL_H
+
+#include <stddef.h>
+
+// Worker threads that run numbered jobs in parallel, for the CPU side
+// rendering passes. jobPoolRun hands out job(context, 0 .. count - 1) to
+// every worker and the calling thread, and returns once all of them ran.
+
+typedef void (*JobFunc)(void *context, int index);
+
+struct JobPoolState;
+
+struct JobPool {
+  int threads; // Workers plus the calling thread
+  JobPoolState *state;
+};
+
+// Start threads - 1 workers. threads 0 uses every hardware thread.
+void jobPoolInit(JobPool *pool, int threads);
+
+void jobPoolRun(JobPool *pool, JobFunc job, void *context, int count);
+
+void jobPoolDestroy(JobPool *pool);
+
+// Evenly split count items over jobs, job i gets [begin, end)
+void jobRange(size_t count, int jobs, int i, size_t *begin, size_t *end);
+
+#endif
@@ -1,26 +1,35 @@
+#include <chrono>
 #include <iostream>
 
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
-#include <GL/glew.h>
+#include "gl_include.h"
 #include <GLFW/glfw3.h>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
+#include "asset_archive.h"
+#include "image.h"
+#include "mesh_load.h"
+#include "mesh_soa.h"
+#include "ring_buffer.h"
+#include "mesh_pool.h"
+#include "frustum_cull.h"
+#include "occlusion_cull.h"
+#include "file_watch.h"
+#include "profiler.h"
+#include "shader_manager.h"
+#include "soft_raster.h"
+#include "texture.h"
+#include "alloc_track.h"
 
 #include <unistd.h>
 
-// Image code, for textures
-struct Image {
-  int sizeX, sizeY;
-  char *data;
-};
-
 struct RGB {
   GLubyte r, g, b;
 };
@@ -32,38 +41,123 @@ float camLocation[] = {
   0.f, 0.f, 1.f
 };
 
+// The mesh every instance draws, and an interleaved copy of its positions
+// for the occluder rasterizer
+MeshSoA mesh;
 std::vector<float> posBuf;
-std::vector<float> norBuf;
-std::vector<float> texCoordBuf;
-std::vector<unsigned int> eleBuf;
+
+// Per-instance placement matrices, one per copy of the mesh
+std::vector<glm::mat4> instanceBuf;
+int numInstances = 1;
+// Grids the instances are split over, one behind the other
+int numLayers = 1;
+
+// World space bounds of each instance, and the instances that survived
+// culling this frame
+AABBList instanceBounds;
+std::vector<unsigned> visibleBuf;
+CullStats cullStats;
+
+// Size of the depth buffer occluders are rasterized into. Instances hidden
+// behind the largest visible ones are dropped too, -noocclusion turns it off.
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 160
+OcclusionCuller occlusion;
+OcclusionStats occlusionStats;
+bool useOcclusion = true;
+
+// Capacity of the shared mesh buffers
+#define POOL_MAX_VERTICES (1 << 20)
+#define POOL_MAX_INDICES (1 << 22)
+// Draw commands a frame may queue
+#define BATCH_MAX_DRAWS 4096
+
+// All meshes live in one pool and are drawn through one batch
+MeshPool meshPool;
+MeshBatch meshBatch;
+int meshID;
 
 // Buffer IDs
-unsigned vaoID;
-unsigned posBufID;
-unsigned eleBufID;
-unsigned texCoordBufID;
 unsigned texBufID;
 
+// Placements of the visible instances, streamed each frame
+RingBuffer instanceRing;
+
 // Shader program
+ShaderManager shaders;
+int mainProgram;
 GLuint pid;
+// Load the program from the binary cache when possible, -nocache turns off
+bool useProgramCache = true;
+
+// Shader sources, rebuilt while running when they are saved
+#define RESOURCE_DIR "../resources"
+#define VERTEX_SHADER "vertexShader.glsl"
+#define FRAGMENT_SHADER "fragmentShader.glsl"
+#define MESH_FILE RESOURCE_DIR "/cube.obj"
+#define TEXTURE_FILE RESOURCE_DIR "/world.bmp"
+FileWatch resourceWatch = {-1, -1};
+
+// Resources are read from this archive when it exists (see
+// tools/asset_pack.cpp), -noarchive reads the loose files instead
+#define ASSET_ARCHIVE RESOURCE_DIR "/assets.pak"
+AssetArchive assets;
+bool useArchive = true;
 
 // Shader attribs
-GLint vertPosLoc;
+GLint instancePlacementLoc = -1;
+
+// Per-frame camera data, laid out to match the std140 Camera block in
+// vertexShader.glsl (mat4 members need no padding)
+struct CameraBlock {
+  glm::mat4 perspective;
+  glm::mat4 placement;
+};
+
+// Uniform buffer binding point shared by every program's Camera block
+#define CAMERA_BINDING 0
 
-// Shader uniforms
-GLint perspectiveLoc;
-GLint placementLoc;
+// Bytes of per-frame dynamic data (camera, per-object constants)
+#define FRAME_DATA_SIZE (64 * 1024)
+
+// Per-frame dynamic uniform data, written straight into mapped memory
+RingBuffer frameRing;
+CameraBlock camera;
 
 // Texture testing
-GLint texCoordLoc;
 GLint texLoc;
 
 // Height of window ???
 int g_width, g_height;
 
+// Recompute the projection for a new framebuffer size
+static void setProjection(int width, int height) {
+  g_width = width;
+  g_height = height;
+  camera.perspective = glm::perspective(70.f,
+    width / (float) (height > 0 ? height : 1), .1f, 100.f);
+}
+
+static void updatePerspective(int width, int height) {
+  glViewport(0, 0, width, height);
+  setProjection(width, height);
+}
+
 // TESTING
 float yRot = 0.f;
 
+// Frames timed for each instance count in benchmark mode
+#define BENCH_FRAMES 100
+// Largest instance count reached in benchmark mode
+#define BENCH_MAX_INSTANCES 100000
+
+// Size of the software rendered frames, how many are timed, and where the
+// last one is saved
+#define SOFT_WIDTH 640
+#define SOFT_HEIGHT 480
+#define SOFT_FRAMES 100
+#define SOFT_FRAME_FILE "soft_frame.bmp"
+
 static const float posArr[] = {
   1.f, 1.f, 0.f,
   1.f, -1.f, 0.f,
@@ -83,99 +177,6 @@ static const unsigned int eleArr[] = {
   3, 1, 0
 };
 
-// Helper functions for image load
-static unsigned int getint(FILE *fp) {
-  int c, c1, c2, c3;
-	
-  // Get 4 bytes
-  c = getc(fp);
-  c1 = getc(fp);
-  c2 = getc(fp);
-  c3 = getc(fp);
-
-	return ((unsigned int) c) + (((unsigned int) c1) << 8) +
-	(((unsigned int) c2) << 16) + (((unsigned int) c3) << 24);
-}
-
-static unsigned int getshort(FILE *fp) {
-	int c, c1;
-	
-	// Get 2 bytes
-	c = getc(fp);
-	c1 = getc(fp);
-	
-	return ((unsigned int) c) + (((unsigned int) c1) << 8);
-}
-
-int imageLoad(const char *filename, Image *image) {
-	FILE *file;
-	unsigned long size; // Size of the image in bytes
-	unsigned long i; // Standard counter
-	unsigned short int planes; // Number of planes in image (must be 1)
-	unsigned short int bpp; // Number of bits per pixel (must be 24)
-	char temp; // Used to convert bgr to rgb color
-	
-	// Make sure the file is there
-	if((file = fopen(filename, "rb")) == NULL) {
-		printf("File Not Found : %s\n", filename);
-		return 0;
-	}
-	
-	// Seek through the bmp header, up to the width height:
-	fseek(file, 18, SEEK_CUR);
-	
-	// No 100% errorchecking anymore!!!
-	
-	// Read the width
-  image->sizeX = getint(file);
-	
-	// Read the height
-	image->sizeY = getint(file);
-	
-	// Calculate the size (assuming 24 bits or 3 bytes per pixel)
-	size = image->sizeX * image->sizeY * 3;
-	
-	// Read the planes
-	planes = getshort(file);
-	if(planes != 1) {
-		printf("Planes from %s is not 1: %u\n", filename, planes);
-		return 0;
-	}
-	
-	// Read the bpp
-	bpp = getshort(file);
-	if(bpp != 24) {
-		printf("Bpp from %s is not 24: %u\n", filename, bpp);
-		return 0;
-	}
-	
-	// Seek past the rest of the bitmap header
-	fseek(file, 24, SEEK_CUR);
-	
-	// Read the data
-	image->data = (char *) malloc(size);
-	if(image->data == NULL) {
-		printf("Error allocating memory for color-corrected image data");
-		return 0;
-	}
-	
-	if((i = fread(image->data, size, 1, file)) != 1) {
-		printf("Error reading image data from %s.\n", filename);
-		return 0;
-	}
-	
-	for(i = 0; i < size; i += 3) { // Reverse all of the colors (bgr -> rgb)
-		temp = image->data[i];
-		image->data[i] = image->data[i+2];
-		image->data[i+2] = temp;
-	}
-	
-	fclose(file); // Close the file and release the filedes
-	
-	// We're done
-	return 1;
-}
-
 // For debugging
 void printMatrix(glm::mat4 mat) {
   int i, j;
@@ -199,143 +200,235 @@ static void key_callback(GLFWwindow *window, int key, int scancode, int action,
 }
 
 static void resize_callback(GLFWwindow *window, int width, int height) {
-  g_width = width;
-  g_height = height;
-  glViewport(0, 0, width, height);
+  updatePerspective(width, height);
 }
 
-char *textfileRead(const char *fn) {
-  FILE *fp;
-  char *content = NULL;
-  int count = 0;
-  if(fn != NULL) {
-    fp = fopen(fn, "rt");
-    if(fp != NULL) {
-      fseek(fp, 0, SEEK_END);
-      count = (int) ftell(fp);
-      rewind(fp);
-      if(count > 0) {
-        content = (char *) malloc(sizeof(char) * (count + 1));
-        count = (int) fread(content, sizeof(char), count, fp);
-        content[count] = '\0';
-      }
-      fclose(fp);
-    } else {
-      printf("error loading %s\n", fn);
-    }
-  }
-  return content;
+// Startup phases, timed in the -profile trace and, in TRACK_ALLOCS builds,
+// counted in the allocation report printed at exit
+static void phaseBegin(ProfileZone *zone, const char *name) {
+  profileBegin(zone, name);
+  allocPhaseBegin(name);
 }
 
-static void resizeMesh(std::vector<float>& posBuf) {
-  float minX, minY, minZ;
-  float maxX, maxY, maxZ;
-  float scaleX, scaleY, scaleZ;
-  float shiftX, shiftY, shiftZ;
-  float epsilon = 0.001;
-
-  minX = minY = minZ = 1.1754E+38F;
-  maxX = maxY = maxZ = -1.1754E+38F;
-
-  //Go through all vertices to determine min and max of each dimension
-  for(size_t v = 0; v < posBuf.size() / 3; v++) {
-    if(posBuf[3*v+0] < minX) minX = posBuf[3*v+0];
-    if(posBuf[3*v+0] > maxX) maxX = posBuf[3*v+0];
-
-    if(posBuf[3*v+1] < minY) minY = posBuf[3*v+1];
-    if(posBuf[3*v+1] > maxY) maxY = posBuf[3*v+1];
-
-    if(posBuf[3*v+2] < minZ) minZ = posBuf[3*v+2];
-    if(posBuf[3*v+2] > maxZ) maxZ = posBuf[3*v+2];
-	}
-
-	//From min and max compute necessary scale and shift for each dimension
-  float maxExtent, xExtent, yExtent, zExtent;
-  
-  xExtent = maxX-minX;
-  yExtent = maxY-minY;
-  zExtent = maxZ-minZ;
-
-  if(xExtent >= yExtent && xExtent >= zExtent) {
-    maxExtent = xExtent;
-  }
-
-  if(yExtent >= xExtent && yExtent >= zExtent) {
-    maxExtent = yExtent;
-  }
-
-  if(zExtent >= xExtent && zExtent >= yExtent) {
-    maxExtent = zExtent;
-  }
-
-  scaleX = 2.0 /maxExtent;
-  shiftX = minX + (xExtent/ 2.0);
-  scaleY = 2.0 / maxExtent;
-  shiftY = minY + (yExtent / 2.0);
-  scaleZ = 2.0/ maxExtent;
-  shiftZ = minZ + (zExtent)/2.0;
-
-  //Go through all verticies shift and scale them
-	for(size_t v = 0; v < posBuf.size() / 3; v++) {
-    posBuf[3*v+0] = (posBuf[3*v+0] - shiftX) * scaleX;
-    assert(posBuf[3*v+0] >= -1.0 - epsilon);
-    assert(posBuf[3*v+0] <= 1.0 + epsilon);
-    posBuf[3*v+1] = (posBuf[3*v+1] - shiftY) * scaleY;
-    assert(posBuf[3*v+1] >= -1.0 - epsilon);
-    assert(posBuf[3*v+1] <= 1.0 + epsilon);
-    posBuf[3*v+2] = (posBuf[3*v+2] - shiftZ) * scaleZ;
-    assert(posBuf[3*v+2] >= -1.0 - epsilon);
-    assert(posBuf[3*v+2] <= 1.0 + epsilon);
-  }
+static void phaseEnd(ProfileZone *zone) {
+  allocPhaseEnd();
+  profileEnd(zone);
 }
 
 static void getMesh(const std::string &meshName) {
   /* std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> objMaterials;
 	std::string errStr;
-	bool rc = tinyobj::LoadObj(shapes, objMaterials, errStr, meshName.c_str());
+	bool rc = loadObj(&assets, meshName.c_str(), shapes, objMaterials, errStr);
 	if(!rc) {
 		std::cerr << errStr << std::endl;
     exit(0);
 	} else {
-		posBuf = shapes[0].mesh.positions;
-    texCoordBuf = shapes[0].mesh.texcoords;
-		eleBuf = shapes[0].mesh.indices;
+		const tinyobj::mesh_t &obj = shapes[0].mesh;
+		meshSoAFromInterleaved(&mesh, &obj.positions[0], NULL,
+      obj.texcoords.empty() ? NULL : &obj.texcoords[0],
+      obj.positions.size() / 3, &obj.indices[0], obj.indices.size());
 	} */
 
-  copy(&posArr[0], &posArr[12], back_inserter(posBuf));
-  copy(&texCoordArr[0], &texCoordArr[8], back_inserter(texCoordBuf));
-  copy(&eleArr[0], &eleArr[6], back_inserter(eleBuf));
+  meshSoAFromInterleaved(&mesh, posArr, NULL, texCoordArr, 4, eleArr, 6);
 }
 
-static void sendMesh() {
-  // Send vertex position array to GPU
-  glGenBuffers(1, &posBufID);
-  glBindBuffer(GL_ARRAY_BUFFER, posBufID);
-  glBufferData(GL_ARRAY_BUFFER, posBuf.size() * sizeof(float), &posBuf[0],
-    GL_STATIC_DRAW);
+// Center and scale the mesh, then interleave the positions for the CPU
+static void normalizeMesh() {
+  meshSoAResize(&mesh);
+  posBuf.resize(mesh.vertexCount * 3);
+  meshSoAInterleave(&mesh, MESH_SOA_POSITIONS, &posBuf[0]);
+}
 
+static void sendMesh() {
   // Error if texture buffer is empty
-  if(texCoordBuf.empty()) {
+  if(mesh.u == NULL) {
     fprintf(stderr, "Could not find texture coordinate buffer.\n");
     exit(0);
   }
 
-  // Send texture coordinate array to GPU
-  glGenBuffers(1, &texCoordBufID);
-  glBindBuffer(GL_ARRAY_BUFFER, texCoordBufID);
-  glBufferData(GL_ARRAY_BUFFER, texCoordBuf.size() * sizeof(float),
-    &texCoordBuf[0], GL_STATIC_DRAW);
+  // Interleave positions and texture coordinates into the pool
+  meshID = meshPoolAddSoA(&meshPool, &mesh);
+  if(meshID < 0) {
+    exit(0);
+  }
+}
+
+// Lay out count copies of the mesh on square grids in the xy plane, split
+// over numLayers grids going away from the camera
+static void makeInstances(int count) {
+  int perLayer = (count + numLayers - 1) / numLayers;
+  int side = (int) ceil(sqrt((double) perLayer));
+  float spacing = 2.5f;
+
+  instanceBuf.clear();
+  instanceBuf.reserve(count);
+  for(int i = 0; i < count; i++) {
+    int cell = i % perLayer;
+    float x = (cell % side - (side - 1) / 2.f) * spacing;
+    float y = (cell / side - (side - 1) / 2.f) * spacing;
+    float z = -(i / perLayer) * spacing;
+    instanceBuf.push_back(glm::translate(glm::mat4(1.f),
+      glm::vec3(x, y, z)));
+  }
+  numInstances = count;
+}
 
-  // Send element array to GPU
-  glGenBuffers(1, &eleBufID);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eleBufID);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, eleBuf.size() * sizeof(unsigned),
-    &eleBuf[0], GL_STATIC_DRAW);
+// World space bounds of every instance, for culling
+static void boundInstances() {
+  // Bounds of the mesh itself
+  float boundsMin[3], boundsMax[3];
+  meshSoABounds(&mesh, boundsMin, boundsMax);
+  glm::vec3 meshMin(boundsMin[0], boundsMin[1], boundsMin[2]);
+  glm::vec3 meshMax(boundsMax[0], boundsMax[1], boundsMax[2]);
+
+  // Transform the box by each placement (Arvo's method: per axis, take the
+  // smaller and larger product of each matrix entry with the box extents)
+  aabbListResize(&instanceBounds, instanceBuf.size());
+  for(size_t i = 0; i < instanceBuf.size(); i++) {
+    const glm::mat4 &m = instanceBuf[i];
+    glm::vec3 min(m[3][0], m[3][1], m[3][2]);
+    glm::vec3 max = min;
+    for(int c = 0; c < 3; c++) {
+      for(int r = 0; r < 3; r++) {
+        float a = m[c][r] * meshMin[c];
+        float b = m[c][r] * meshMax[c];
+        min[r] += a < b ? a : b;
+        max[r] += a < b ? b : a;
+      }
+    }
+    aabbListSet(&instanceBounds, i, min, max);
+  }
+  visibleBuf.resize(instanceBuf.size());
+}
 
-  // Unbind arrays
+static void sendInstances() {
+  boundInstances();
+
+  // Grow the stream when there are more instances than it can hold
+  size_t size = instanceBuf.size() * sizeof(glm::mat4);
+  if(instanceRing.id == 0 || instanceRing.frameSize < size) {
+    if(instanceRing.id != 0) {
+      ringBufferDestroy(&instanceRing);
+    }
+    ringBufferInit(&instanceRing, GL_ARRAY_BUFFER, size);
+  }
+}
+
+// Leave the instances to draw this frame in visibleBuf and return how many:
+// those inside the view, less those hidden behind the largest of them
+static size_t cullInstances(const glm::mat4 &viewProj) {
+  Frustum frustum;
+  frustumFromMatrix(&frustum, viewProj);
+  size_t numVisible = frustumCull(&frustum, &instanceBounds, &visibleBuf[0],
+    &cullStats);
+  if(!useOcclusion) {
+    return numVisible;
+  }
+
+  // Every instance is a copy of the one mesh
+  OccluderDraw draw;
+  draw.positions = &posBuf[0];
+  draw.vertexCount = mesh.vertexCount;
+  draw.indices = &mesh.indices[0];
+  draw.indexCount = mesh.indices.size();
+  draw.viewProj = viewProj;
+  draw.instances = &instanceBuf[0];
+  draw.candidates = &visibleBuf[0];
+  draw.candidateCount = numVisible;
+  occlusionRender(&occlusion, &draw, &instanceBounds, &occlusionStats);
+  return occlusionTest(&occlusion, &instanceBounds, &visibleBuf[0],
+    numVisible, &occlusionStats);
+}
+
+// Point the instance attributes at this frame's placements
+static void bindInstances(GLintptr offset) {
+  glBindVertexArray(meshPool.vaoID);
+  glBindBuffer(GL_ARRAY_BUFFER, instanceRing.id);
+  for(int i = 0; i < 4; i++) {
+    glVertexAttribPointer(instancePlacementLoc + i, 4, GL_FLOAT, GL_FALSE,
+      sizeof(glm::mat4), (const void *) (offset + sizeof(glm::vec4) * i));
+  }
   glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+// Look up what the shader program is driven through and hook it up to the
+// mesh pool and the camera block. Done again whenever the program is rebuilt
+// since an edit may move any of it.
+static void setupProgram() {
+  // Position and texture coordinates are already set up by the mesh pool
+  GLint oldLoc = instancePlacementLoc;
+  instancePlacementLoc = glGetAttribLocation(pid, "instancePlacement");
+
+  // Add the instance attributes to the pool's vertex array object
+  glBindVertexArray(meshPool.vaoID);
+
+  // Stop feeding the old locations if the attribute moved
+  if(oldLoc >= 0 && oldLoc != instancePlacementLoc) {
+    for(int i = 0; i < 4; i++) {
+      glDisableVertexAttribArray(oldLoc + i);
+    }
+  }
+
+  // Bind instance placement buffer
+  // A mat4 attribute takes four consecutive locations, one per column, and
+  // advances once per instance instead of once per vertex
+  // The pointers themselves move every frame, see bindInstances
+  if(instancePlacementLoc >= 0) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceRing.id);
+    for(int i = 0; i < 4; i++) {
+      glEnableVertexAttribArray(instancePlacementLoc + i);
+      glVertexAttribPointer(instancePlacementLoc + i, 4, GL_FLOAT, GL_FALSE,
+        sizeof(glm::mat4), (const void *) (sizeof(glm::vec4) * i));
+      glVertexAttribDivisor(instancePlacementLoc + i, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  // Unbind vertex array object
+  glBindVertexArray(0);
+
+  // Matrices to pass to vertex shaders
+  // Point the program's Camera block at the shared binding point
+  GLuint cameraBlock = glGetUniformBlockIndex(pid, "Camera");
+  glUniformBlockBinding(pid, cameraBlock, CAMERA_BINDING);
+
+  // Get the location of the sampler2D in fragment shader (???)
+  texLoc = glGetUniformLocation(pid, "tex");
+}
+
+// Start rebuilding the shader program if one of its sources was saved
+static void checkShaderEdits() {
+  std::vector<std::string> changed;
+  fileWatchPoll(&resourceWatch, &changed);
+  bool edited = false;
+  for(size_t i = 0; i < changed.size(); i++) {
+    if(changed[i] == VERTEX_SHADER || changed[i] == FRAGMENT_SHADER) {
+      edited = true;
+    }
+  }
+  if(!edited) {
+    return;
+  }
+
+  char *vsSource = textfileRead(&assets, RESOURCE_DIR "/" VERTEX_SHADER);
+  char *fsSource = textfileRead(&assets, RESOURCE_DIR "/" FRAGMENT_SHADER);
+  if(vsSource != NULL && fsSource != NULL) {
+    printf("Reloading shaders\n");
+    shaderManagerReload(&shaders, mainProgram, vsSource, fsSource);
+  }
+  free(vsSource);
+  free(fsSource);
+}
+
+// Frame boundary: put a finished rebuild in use before anything is drawn
+static void swapShaders() {
+  if(shaderManagerSwap(&shaders, mainProgram)) {
+    pid = shaders.programs[mainProgram].pid;
+    setupProgram();
+    printf("Shader program reloaded\n");
+  }
 }
 
 static void init() {
@@ -348,152 +441,103 @@ static void init() {
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   glEnable(GL_BLEND);
 
+  PROFILE_SCOPE("init");
+  ProfileZone zone;
+
+  // Start building the shader program first so the driver compiles it
+  // while the mesh and texture load
+  phaseBegin(&zone, "shader submit");
+  char *vsSource = textfileRead(&assets, RESOURCE_DIR "/" VERTEX_SHADER);
+  char *fsSource = textfileRead(&assets, RESOURCE_DIR "/" FRAGMENT_SHADER);
+  double start = glfwGetTime();
+  shaderManagerInit(&shaders, useProgramCache);
+  mainProgram = shaderManagerAdd(&shaders, vsSource, fsSource);
+  double submitTime = glfwGetTime() - start;
+  free(vsSource);
+  free(fsSource);
+  phaseEnd(&zone);
+
   // Get mesh
+  phaseBegin(&zone, "getMesh");
   // getMesh("../resources/sphere.obj");
-  getMesh("../resources/cube.obj");
-  resizeMesh(posBuf);
+  getMesh(MESH_FILE);
+  phaseEnd(&zone);
+  phaseBegin(&zone, "normalizeMesh");
+  normalizeMesh();
+  phaseEnd(&zone);
 
   // Send mesh to GPU
+  phaseBegin(&zone, "sendMesh");
+  meshPoolInit(&meshPool, POOL_MAX_VERTICES, POOL_MAX_INDICES);
+  meshBatchInit(&meshBatch, BATCH_MAX_DRAWS);
   sendMesh();
+  phaseEnd(&zone);
+
+  // Prepare instance placements for the GPU
+  phaseBegin(&zone, "instances");
+  makeInstances(numInstances);
+  sendInstances();
+  if(useOcclusion) {
+    occlusionInit(&occlusion, OCCLUSION_WIDTH, OCCLUSION_HEIGHT, 0);
+  }
+  phaseEnd(&zone);
 
   // Read texture into CPU memory
   struct Image image;
-  imageLoad("../resources/world.bmp", &image);
-
-  // Load the texture into the GPU
-
-  // Set the first texture unit as active
-  glActiveTexture(GL_TEXTURE0);
-  // Generate texture buffer object
-  glGenTextures(1, &texBufID);
-  // Bind current texture unit to texture buffer object as a GL_TEXTURE_2D
-  glBindTexture(GL_TEXTURE_2D, texBufID);
-  // Load texture data into texBufID
-  // Base level is 0, number of channels is 3, and border is 0
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.sizeX, image.sizeY,
-    0, GL_RGB, GL_UNSIGNED_BYTE, (GLubyte *) image.data);
-
-  // Generate image pyramid
-  glGenerateMipmap(GL_TEXTURE_2D);
-  // Set texture wrap modes for S and T directions
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  // Set filtering mode for magnification and minification
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  // glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-    GL_LINEAR_MIPMAP_LINEAR);
-
-  // Unbind from texture buffer object from current texture unit
-  glBindTexture(GL_TEXTURE_2D, 0);
-
-  // Initialize shader program
-  GLint rc;
-
-  // Create shader handles
-  GLuint vsHandle = glCreateShader(GL_VERTEX_SHADER);
-  GLuint fsHandle = glCreateShader(GL_FRAGMENT_SHADER);
-
-  // Read shader source code
-  const char *vsSource = textfileRead("../resources/vertexShader.glsl");
-  const char *fsSource = textfileRead("../resources/fragmentShader.glsl");
-
-  glShaderSource(vsHandle, 1, &vsSource, NULL);
-  glShaderSource(fsHandle, 1, &fsSource, NULL);
-
-  // Compile vertex shader
-  glCompileShader(vsHandle);
-  glGetShaderiv(vsHandle, GL_COMPILE_STATUS, &rc);
-  
-  if(!rc) {
-    std::cout << "Error compiling vertex shader" << std::endl;
+  phaseBegin(&zone, "imageLoad");
+  if(!imageLoad(&assets, TEXTURE_FILE, &image)) {
     exit(EXIT_FAILURE);
   }
+  phaseEnd(&zone);
 
-  // Compile fragment shader
-  glCompileShader(fsHandle);
-  glGetShaderiv(fsHandle, GL_COMPILE_STATUS, &rc);
-
-  if(!rc) {
-    std::cout << "Error compiling fragment shader" << std::endl;
-    exit(EXIT_FAILURE);
-  }
-
-  // Create program and link
-  pid = glCreateProgram();
-  glAttachShader(pid, vsHandle);
-  glAttachShader(pid, fsHandle);
-  glLinkProgram(pid);
-  glGetProgramiv(pid, GL_LINK_STATUS, &rc);
-
-  if(!rc) {
-    std::cout << "Error linking shaders" << std::endl;
+  // Load the texture into the GPU, on the first texture unit
+  phaseBegin(&zone, "texture upload");
+  glActiveTexture(GL_TEXTURE0);
+  texBufID = textureCreate(&image);
+  free(image.data);
+  phaseEnd(&zone);
+
+  // The shader program has been building since the start of init, this
+  // only waits for whatever is left
+  phaseBegin(&zone, "shader wait");
+  start = glfwGetTime();
+  pid = shaderManagerGet(&shaders, mainProgram);
+  double waitTime = glfwGetTime() - start;
+  phaseEnd(&zone);
+
+  if(pid == 0) {
     exit(EXIT_FAILURE);
   }
+  printf("Shader program %s: %.3f ms to submit, %.3f ms waiting\n",
+    shaders.programs[mainProgram].fromCache ? "loaded from cache" : "compiled",
+    submitTime * 1e3, waitTime * 1e3);
 
-  // Attribs
-  vertPosLoc = glGetAttribLocation(pid, "vertPos");
-  texCoordLoc = glGetAttribLocation(pid, "texCoord");
-
-  // Create vertex array object
-  glGenVertexArrays(1, &vaoID);
-  glBindVertexArray(vaoID);
-
-  // Bind position buffer
-  glEnableVertexAttribArray(vertPosLoc);
-  glBindBuffer(GL_ARRAY_BUFFER, posBufID);
-  glVertexAttribPointer(vertPosLoc, 3, GL_FLOAT, GL_FALSE, sizeof(GL_FLOAT) * 3,
-    (const void *) 0);
-
-  // Bind texture coordinate buffer
-  glEnableVertexAttribArray(texCoordLoc);
-  glBindBuffer(GL_ARRAY_BUFFER, texCoordBufID);
-  glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE, 
-    sizeof(GL_FLOAT) * 2, (const void *) 0);
-
-  // Bind element buffer
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eleBufID);
-
-  // Unbind vertex array object
-  glBindVertexArray(0);
-
-  // Disable
-  glDisableVertexAttribArray(vertPosLoc);
-  glDisableVertexAttribArray(texCoordLoc);
+  // Attribs, camera block and sampler
+  phaseBegin(&zone, "setupProgram");
+  setupProgram();
+  phaseEnd(&zone);
 
   // Unbind GPU buffers
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-  // Matrices to pass to vertex shaders
-  perspectiveLoc = glGetUniformLocation(pid, "perspective");
-  placementLoc = glGetUniformLocation(pid, "placement");
+  // Watch the shader sources for edits, unless they come from the archive
+  if(assets.base == NULL) {
+    fileWatchInit(&resourceWatch, RESOURCE_DIR);
+  }
 
-  // Get the location of the sampler2D in fragment shader (???)
-  texLoc = glGetUniformLocation(pid, "tex");
-}
+  // Create the ring the camera block is streamed through each frame
+  ringBufferInit(&frameRing, GL_UNIFORM_BUFFER, FRAME_DATA_SIZE);
 
-static void render() {
+  // Projection only changes on resize
   int width, height;
-  float aspect;
-
-  // Create matrices
-  glm::mat4 matPlacement;
-  glm::mat4 matPerspective;
-
-  // Get current frame buffer size ???
   glfwGetFramebufferSize(window, &width, &height);
-  glViewport(0, 0, width, height);
-
-  // Clear framebuffer
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-  // Perspective matrix
-  aspect = width / (float) height;
-  matPerspective = glm::perspective(70.f, aspect, .1f, 100.f);
+  updatePerspective(width, height);
+}
 
-  // Placement matrix
-  matPlacement = glm::mat4(1.f);
+// Camera placement matrix for the next frame, moves the camera along
+static glm::mat4 cameraPlacement() {
+  glm::mat4 matPlacement = glm::mat4(1.f);
   matPlacement = glm::scale(glm::mat4(1.f),
     glm::vec3(1.f, 1.f, 1.f)) * 
     matPlacement;
@@ -505,67 +549,302 @@ static void render() {
     glm::vec3(-camLocation[0], -camLocation[1], -camLocation[2])) *
     matPlacement;
   camLocation[2] = camLocation[2] + 0.01;
+  return matPlacement;
+}
 
-  // Bind shader program
-  glUseProgram(pid);
+static void render() {
+  // Clear framebuffer
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  // Perspective matrix is kept up to date by resize_callback
 
-  // Fill in matrices
-  glUniformMatrix4fv(perspectiveLoc, 1, GL_FALSE,
-    glm::value_ptr(matPerspective));
-  glUniformMatrix4fv(placementLoc, 1, GL_FALSE,
-    glm::value_ptr(matPlacement));
+  // Placement matrix
+  glm::mat4 matPlacement = cameraPlacement();
+
+  // Fill in matrices once for every program reading the Camera block
+  ringBufferBeginFrame(&frameRing);
+  camera.placement = matPlacement;
+  GLintptr cameraOffset = 0;
+  void *cameraData = ringBufferAlloc(&frameRing, sizeof(CameraBlock),
+    &cameraOffset);
+  if(cameraData != NULL) {
+    memcpy(cameraData, &camera, sizeof(CameraBlock));
+  }
+  ringBufferFlush(&frameRing);
+  glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BINDING, frameRing.id,
+    cameraOffset, sizeof(CameraBlock));
+
+  // Drop instances outside the view or hidden before anything is submitted
+  size_t numVisible = cullInstances(camera.perspective * matPlacement);
+
+  // Stream the surviving placements
+  ringBufferBeginFrame(&instanceRing);
+  GLintptr instanceOffset = 0;
+  glm::mat4 *instanceData = (glm::mat4 *) ringBufferAlloc(&instanceRing,
+    numVisible * sizeof(glm::mat4), &instanceOffset);
+  if(instanceData == NULL) {
+    numVisible = 0;
+  }
+  for(size_t i = 0; i < numVisible; i++) {
+    instanceData[i] = instanceBuf[visibleBuf[i]];
+  }
+  ringBufferFlush(&instanceRing);
+  bindInstances(instanceOffset);
 
-  // Bind vertex array object
-  glBindVertexArray(vaoID);
+  // Bind shader program
+  glUseProgram(pid);
 
   // Bind texture to texture unit 0
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, texBufID);
   glUniform1i(texLoc, 0);
 
-  // Draw one object
-  glDrawElements(GL_TRIANGLES, (int) eleBuf.size(), GL_UNSIGNED_INT,
-    (const void *) 0);
+  // Queue every visible instance of the object and submit the frame's
+  // draws at once
+  meshBatchBegin(&meshBatch);
+  if(numVisible > 0) {
+    meshBatchAdd(&meshBatch, &meshPool, meshID, (GLuint) numVisible, 0);
+  }
+  meshBatchSubmit(&meshBatch, &meshPool);
 
   // Unbind texture
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, 0);
 
-  // Unbind vertex array object
-  glBindVertexArray(0);
-
   // Unbind shader program
   glUseProgram(0);
+
+  // This frame's dynamic data is in flight until the GPU passes the fence
+  ringBufferEndFrame(&frameRing);
+  ringBufferEndFrame(&instanceRing);
+}
+
+// Time frames at instance counts from 1 up to BENCH_MAX_INSTANCES
+static void benchInstances() {
+  // Don't let vsync cap the frame rate
+  glfwSwapInterval(0);
+
+  printf("%10s %12s %16s %10s %10s %10s %12s\n", "instances", "ms/frame",
+    "ns/instance", "visible", "culled", "occluded", "occl ms");
+  for(int count = 1; count <= BENCH_MAX_INSTANCES; count *= 10) {
+    makeInstances(count);
+    sendInstances();
+
+    // Warm up so buffer allocation isn't part of the measurement
+    render();
+    glFinish();
+
+    double start = glfwGetTime();
+    for(int i = 0; i < BENCH_FRAMES; i++) {
+      render();
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+      GLEE_EndFrame();
+    }
+    glFinish();
+    double frameTime = (glfwGetTime() - start) / BENCH_FRAMES;
+
+    printf("%10d %12.3f %16.3f %10u %10u %10u %12.3f\n", count,
+      frameTime * 1e3, frameTime * 1e9 / count, cullStats.visible,
+      cullStats.culled, occlusionStats.occluded,
+      (occlusionStats.renderTime + occlusionStats.testTime) * 1e3);
+  }
+}
+
+// Draw the scene on the CPU with the software rasterizer, for hosts without
+// a GPU. Loads what init() does, draws the same frames render() would (same
+// camera path and culling) without opening a window, and saves the last one.
+static void softwareRender() {
+  PROFILE_SCOPE("softwareRender");
+  ProfileZone zone;
+  phaseBegin(&zone, "getMesh");
+  getMesh(MESH_FILE);
+  normalizeMesh();
+  std::vector<float> texCoordBuf(mesh.vertexCount * 2);
+  meshSoAInterleave(&mesh, MESH_SOA_TEXCOORDS, &texCoordBuf[0]);
+  phaseEnd(&zone);
+  phaseBegin(&zone, "instances");
+  makeInstances(numInstances);
+  boundInstances();
+  phaseEnd(&zone);
+
+  struct Image image;
+  phaseBegin(&zone, "imageLoad");
+  if(!imageLoad(&assets, TEXTURE_FILE, &image)) {
+    exit(EXIT_FAILURE);
+  }
+  phaseEnd(&zone);
+  // Mipmapped and filtered like the GL texture init() makes
+  phaseBegin(&zone, "mipChainInit");
+  MipChain texture;
+  mipChainInit(&texture, image.sizeX, image.sizeY,
+    (const unsigned char *) image.data);
+  free(image.data);
+  Sampler sampler;
+  samplerDefault(&sampler);
+  phaseEnd(&zone);
+
+  phaseBegin(&zone, "softRasterInit");
+  SoftRasterizer raster;
+  softRasterInit(&raster, SOFT_WIDTH, SOFT_HEIGHT, 0);
+  setProjection(SOFT_WIDTH, SOFT_HEIGHT);
+  if(useOcclusion) {
+    occlusionInit(&occlusion, OCCLUSION_WIDTH, OCCLUSION_HEIGHT, 0);
+  }
+  phaseEnd(&zone);
+  // Time spent occlusion culling over all frames
+  double occlusionTime = 0.;
+  unsigned occluded = 0;
+
+  SoftDraw draw;
+  draw.positions = &posBuf[0];
+  draw.texCoords = &texCoordBuf[0];
+  draw.vertexCount = mesh.vertexCount;
+  draw.indices = &mesh.indices[0];
+  draw.indexCount = mesh.indices.size();
+  draw.instances = &instanceBuf[0];
+  draw.visible = &visibleBuf[0];
+  draw.texture = &texture;
+  draw.sampler = &sampler;
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  for(int i = 0; i < SOFT_FRAMES; i++) {
+    glm::mat4 matPlacement = cameraPlacement();
+    draw.viewProj = camera.perspective * matPlacement;
+    draw.instanceCount = cullInstances(draw.viewProj);
+    if(useOcclusion) {
+      occlusionTime += occlusionStats.renderTime + occlusionStats.testTime;
+      occluded = occlusionStats.occluded;
+    }
+
+    softRasterClear(&raster, .25f, .75f, 1.f, 0.f);
+    softRasterDraw(&raster, &draw);
+  }
+  double frameTime = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count() / SOFT_FRAMES;
+
+  printf("Software rendered %d frames of %d instances: %.3f ms/frame "
+    "(%u visible, %u culled)\n", SOFT_FRAMES, numInstances, frameTime * 1e3,
+    cullStats.visible, cullStats.culled);
+  if(useOcclusion) {
+    printf("Occlusion culling: %.3f ms/frame, %u of the visible occluded by "
+      "%u occluders (%u triangles)\n", occlusionTime * 1e3 / SOFT_FRAMES,
+      occluded, occlusionStats.occluders, occlusionStats.triangles);
+  }
+  if(softRasterWriteBmp(&raster, SOFT_FRAME_FILE)) {
+    printf("Last frame saved to %s\n", SOFT_FRAME_FILE);
+  }
+
+  softRasterDestroy(&raster);
+  occlusionDestroy(&occlusion);
+  mipChainFree(&texture);
 }
 
 int main(int argc, char **argv) {
+  bool bench = false;
+  bool software = false;
+  // Chrome trace of the startup phases, written after the first frame
+  const char *profilePath = NULL;
+  ProfileZone zone;
+
+  // Parse options
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-instances") == 0 && i + 1 < argc) {
+      numInstances = atoi(argv[++i]);
+      if(numInstances < 1) {
+        numInstances = 1;
+      }
+    } else if(strcmp(argv[i], "-layers") == 0 && i + 1 < argc) {
+      numLayers = atoi(argv[++i]);
+      if(numLayers < 1) {
+        numLayers = 1;
+      }
+    } else if(strcmp(argv[i], "-noocclusion") == 0) {
+      useOcclusion = false;
+    } else if(strcmp(argv[i], "-bench") == 0) {
+      bench = true;
+    } else if(strcmp(argv[i], "-nocache") == 0) {
+      useProgramCache = false;
+    } else if(strcmp(argv[i], "-noarchive") == 0) {
+      useArchive = false;
+    } else if(strcmp(argv[i], "-profile") == 0 && i + 1 < argc) {
+      profilePath = argv[++i];
+    } else if(strcmp(argv[i], "-soft") == 0) {
+      software = true;
+    }
+  }
+  if(profilePath != NULL) {
+    profileEnable();
+    profileThreadName("main");
+  }
+  ProfileZone startup;
+  profileBegin(&startup, "startup");
+
+  // Read resources from the packed archive if there is one
+  phaseBegin(&zone, "archiveOpen");
+  if(useArchive && archiveOpen(&assets, ASSET_ARCHIVE)) {
+    printf("Reading resources from %s\n", ASSET_ARCHIVE);
+  }
+  phaseEnd(&zone);
+
+  // No window or GL context needed
+  if(software) {
+    profileEnd(&startup);
+    softwareRender();
+    if(profilePath != NULL) {
+      profileWrite(profilePath);
+    }
+    archiveClose(&assets);
+    aabbListFree(&instanceBounds);
+    meshSoAFree(&mesh);
+    allocReport(stdout);
+    return 0;
+  }
+
   // What function to call when there is an error
   glfwSetErrorCallback(error_callback);
 
   // Initialize GLFW
+  phaseBegin(&zone, "glfwInit");
   if(glfwInit() == false) {
+    phaseEnd(&zone);
+    profileEnd(&startup);
+    if(profilePath != NULL) {
+      profileWrite(profilePath);
+    }
     return -1;
   }
+  phaseEnd(&zone);
 
   // ???
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 
   // Create a windowed mode window and (?) its OpenGL context. (?)
+  phaseBegin(&zone, "create window");
   window = glfwCreateWindow(640, 480, "Some title", NULL, NULL);
   if(window == false) {
+    phaseEnd(&zone);
+    profileEnd(&startup);
+    if(profilePath != NULL) {
+      profileWrite(profilePath);
+    }
     glfwTerminate();
     return -1;
   }
   glfwMakeContextCurrent(window);
+  phaseEnd(&zone);
 
   // Initialize GLEW
+  phaseBegin(&zone, "glewInit");
   glewExperimental = true;
   if(glewInit() != GLEW_OK) {
     std::cerr << "Failed to initialize GLEW" << std::endl;
   }
+  phaseEnd(&zone);
 
   // Bootstrap ???
   glGetError();
@@ -586,9 +865,40 @@ int main(int argc, char **argv) {
 
   // Initialize scene
   init();
+  profileEnd(&startup);
+
+  if(bench) {
+    if(profilePath != NULL) {
+      profileWrite(profilePath);
+    }
+    benchInstances();
+    meshBatchDestroy(&meshBatch);
+    meshPoolDestroy(&meshPool);
+    ringBufferDestroy(&instanceRing);
+    ringBufferDestroy(&frameRing);
+    shaderManagerDestroy(&shaders);
+    fileWatchDestroy(&resourceWatch);
+    archiveClose(&assets);
+    occlusionDestroy(&occlusion);
+    aabbListFree(&instanceBounds);
+    meshSoAFree(&mesh);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    allocReport(stdout);
+    return 0;
+  }
+
+  // The first frame also pays for whatever the driver put off until the
+  // first draw
+  bool firstFrame = true;
+  phaseBegin(&zone, "first frame");
 
   // Loop until the user closes the window
   while(!glfwWindowShouldClose(window)) {
+    // Pick up edited shaders between frames
+    checkShaderEdits();
+    swapShaders();
+
     // Render scene
     render();
     // Swap front and back buffers
@@ -596,11 +906,33 @@ int main(int argc, char **argv) {
 
     // Poll for and process events
     glfwPollEvents();
+
+    // Check deferred GL errors, end the frame for GLEE traces and stats
+    GLEE_EndFrame();
+
+    if(firstFrame) {
+      firstFrame = false;
+      phaseEnd(&zone);
+      if(profilePath != NULL) {
+        profileWrite(profilePath);
+      }
+    }
   }
 
   // Quit program
+  meshBatchDestroy(&meshBatch);
+  meshPoolDestroy(&meshPool);
+  ringBufferDestroy(&instanceRing);
+  ringBufferDestroy(&frameRing);
+  shaderManagerDestroy(&shaders);
+  fileWatchDestroy(&resourceWatch);
+  archiveClose(&assets);
+  occlusionDestroy(&occlusion);
+  aabbListFree(&instanceBounds);
+  meshSoAFree(&mesh);
   glfwDestroyWindow(window);
   glfwTerminate();
+  allocReport(stdout);
 
   return 0;
 }
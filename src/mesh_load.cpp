@@ -0,0 +1,131 @@
+// tinyobj's implementation is compiled here, before mesh_load.h pulls in
+// its declarations
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "mesh_load.h"
+
+#include <assert.h>
+
+#include <istream>
+#include <streambuf>
+
+#include "alloc_track.h"
+
+// Read only stream over a file's bytes, for tinyobj
+struct MemoryStreamBuf : std::streambuf {
+  MemoryStreamBuf(const char *data, size_t size) {
+    char *p = const_cast<char *>(data);
+    setg(p, p, p + size);
+  }
+};
+
+// Materials are looked up next to the mesh, through the archive as well
+class VirtualMaterialReader : public tinyobj::MaterialReader {
+public:
+  VirtualMaterialReader(const AssetArchive *archive,
+    const std::string &basePath) : archive(archive), basePath(basePath) {}
+  virtual bool operator()(const std::string &matId,
+    std::vector<tinyobj::material_t> &materials,
+    std::map<std::string, int> &matMap, std::string &err) {
+    VirtualFile file;
+    std::string path = basePath + matId;
+    if(!virtualFileOpen(archive, path.c_str(), &file)) {
+      err += "WARN: Material file [ " + path +
+        " ] not found. Created a default material.";
+      return true;
+    }
+    MemoryStreamBuf buf(file.data, file.size);
+    std::istream stream(&buf);
+    tinyobj::LoadMtl(matMap, materials, stream);
+    virtualFileClose(&file);
+    return true;
+  }
+
+private:
+  const AssetArchive *archive;
+  std::string basePath;
+};
+
+bool loadObj(const AssetArchive *archive, const char *path,
+  std::vector<tinyobj::shape_t> &shapes,
+  std::vector<tinyobj::material_t> &materials, std::string &err) {
+  ALLOC_TAG(ALLOC_MESH);
+  VirtualFile file;
+  shapes.clear();
+  if(!virtualFileOpen(archive, path, &file)) {
+    err = std::string("Cannot open file [") + path + "]\n";
+    return false;
+  }
+  std::string basePath(path);
+  size_t slash = basePath.find_last_of('/');
+  basePath = slash == std::string::npos ? "" : basePath.substr(0, slash + 1);
+
+  MemoryStreamBuf buf(file.data, file.size);
+  std::istream stream(&buf);
+  VirtualMaterialReader materialReader(archive, basePath);
+  bool rc = tinyobj::LoadObj(shapes, materials, err, stream, materialReader);
+  virtualFileClose(&file);
+  return rc;
+}
+
+void resizeMesh(std::vector<float>& posBuf) {
+  ALLOC_TAG(ALLOC_MESH);
+  float minX, minY, minZ;
+  float maxX, maxY, maxZ;
+  float scaleX, scaleY, scaleZ;
+  float shiftX, shiftY, shiftZ;
+  float epsilon = 0.001;
+
+  minX = minY = minZ = 1.1754E+38F;
+  maxX = maxY = maxZ = -1.1754E+38F;
+
+  //Go through all vertices to determine min and max of each dimension
+  for(size_t v = 0; v < posBuf.size() / 3; v++) {
+    if(posBuf[3*v+0] < minX) minX = posBuf[3*v+0];
+    if(posBuf[3*v+0] > maxX) maxX = posBuf[3*v+0];
+
+    if(posBuf[3*v+1] < minY) minY = posBuf[3*v+1];
+    if(posBuf[3*v+1] > maxY) maxY = posBuf[3*v+1];
+
+    if(posBuf[3*v+2] < minZ) minZ = posBuf[3*v+2];
+    if(posBuf[3*v+2] > maxZ) maxZ = posBuf[3*v+2];
+	}
+
+	//From min and max compute necessary scale and shift for each dimension
+  float maxExtent, xExtent, yExtent, zExtent;
+  
+  xExtent = maxX-minX;
+  yExtent = maxY-minY;
+  zExtent = maxZ-minZ;
+
+  if(xExtent >= yExtent && xExtent >= zExtent) {
+    maxExtent = xExtent;
+  }
+
+  if(yExtent >= xExtent && yExtent >= zExtent) {
+    maxExtent = yExtent;
+  }
+
+  if(zExtent >= xExtent && zExtent >= yExtent) {
+    maxExtent = zExtent;
+  }
+
+  scaleX = 2.0 /maxExtent;
+  shiftX = minX + (xExtent/ 2.0);
+  scaleY = 2.0 / maxExtent;
+  shiftY = minY + (yExtent / 2.0);
+  scaleZ = 2.0/ maxExtent;
+  shiftZ = minZ + (zExtent)/2.0;
+
+  //Go through all verticies shift and scale them
+	for(size_t v = 0; v < posBuf.size() / 3; v++) {
+    posBuf[3*v+0] = (posBuf[3*v+0] - shiftX) * scaleX;
+    assert(posBuf[3*v+0] >= -1.0 - epsilon);
+    assert(posBuf[3*v+0] <= 1.0 + epsilon);
+    posBuf[3*v+1] = (posBuf[3*v+1] - shiftY) * scaleY;
+    assert(posBuf[3*v+1] >= -1.0 - epsilon);
+    assert(posBuf[3*v+1] <= 1.0 + epsilon);
+    posBuf[3*v+2] = (posBuf[3*v+2] - shiftZ) * scaleZ;
+    assert(posBuf[3*v+2] >= -1.0 - epsilon);
+    assert(posBuf[3*v+2] <= 1.0 + epsilon);
+  }
+}
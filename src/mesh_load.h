@@ -0,0 +1,20 @@
+#ifndef MESH_LOAD_H
+#define MESH_LOAD_H
+
+#include <string>
+#include <vector>
+
+#include "asset_archive.h"
+#include "tiny_obj_loader.h"
+
+// tinyobj::LoadObj reading the mesh and its materials through the asset
+// archive (or from disk)
+bool loadObj(const AssetArchive *archive, const char *path,
+  std::vector<tinyobj::shape_t> &shapes,
+  std::vector<tinyobj::material_t> &materials, std::string &err);
+
+// Center xyz positions on the origin and scale them uniformly so the
+// longest side of their bounds spans -1 .. 1
+void resizeMesh(std::vector<float>& posBuf);
+
+#endif
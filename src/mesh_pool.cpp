@@ -0,0 +1,281 @@
+#include "mesh_pool.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "alloc_track.h"
+#include "mesh_soa.h"
+
+void meshPoolInit(MeshPool *pool, size_t maxVertices, size_t maxIndices) {
+  ALLOC_TAG(ALLOC_MESH);
+  pool->maxVertices = maxVertices;
+  pool->maxIndices = maxIndices;
+  pool->numVertices = 0;
+  pool->numIndices = 0;
+  pool->meshes.clear();
+
+  // Allocate the shared buffers once; meshes are copied in with
+  // glBufferSubData so adding one never reallocates
+  glGenBuffers(1, &pool->posBufID);
+  glBindBuffer(GL_ARRAY_BUFFER, pool->posBufID);
+  glBufferData(GL_ARRAY_BUFFER, maxVertices * 3 * sizeof(float), NULL,
+    GL_STATIC_DRAW);
+
+  glGenBuffers(1, &pool->texCoordBufID);
+  glBindBuffer(GL_ARRAY_BUFFER, pool->texCoordBufID);
+  glBufferData(GL_ARRAY_BUFFER, maxVertices * 2 * sizeof(float), NULL,
+    GL_STATIC_DRAW);
+
+  // Create vertex array object
+  glGenVertexArrays(1, &pool->vaoID);
+  glBindVertexArray(pool->vaoID);
+
+  // Bind position buffer
+  glEnableVertexAttribArray(MESH_POS_LOC);
+  glBindBuffer(GL_ARRAY_BUFFER, pool->posBufID);
+  glVertexAttribPointer(MESH_POS_LOC, 3, GL_FLOAT, GL_FALSE,
+    sizeof(GL_FLOAT) * 3, (const void *) 0);
+
+  // Bind texture coordinate buffer
+  glEnableVertexAttribArray(MESH_TEXCOORD_LOC);
+  glBindBuffer(GL_ARRAY_BUFFER, pool->texCoordBufID);
+  glVertexAttribPointer(MESH_TEXCOORD_LOC, 2, GL_FLOAT, GL_FALSE,
+    sizeof(GL_FLOAT) * 2, (const void *) 0);
+
+  // The element buffer binding is part of the vertex array state
+  glGenBuffers(1, &pool->eleBufID);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool->eleBufID);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, maxIndices * sizeof(unsigned), NULL,
+    GL_STATIC_DRAW);
+
+  // Unbind vertex array object, then the buffers
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+// Whether vertexCount vertices and indexCount indices still fit
+static bool meshPoolHasRoom(const MeshPool *pool, size_t vertexCount,
+  size_t indexCount) {
+  if(pool->numVertices + vertexCount > pool->maxVertices ||
+    pool->numIndices + indexCount > pool->maxIndices) {
+    fprintf(stderr, "Mesh pool is full.\n");
+    return false;
+  }
+  return true;
+}
+
+// Copy the indices after the last mesh's and record the new mesh, once its
+// vertices are in. Returns its handle.
+static int meshPoolCommit(MeshPool *pool, size_t vertexCount,
+  const std::vector<unsigned> &eleBuf) {
+  MeshRange range;
+  range.indexCount = (GLuint) eleBuf.size();
+  range.firstIndex = (GLuint) pool->numIndices;
+  range.baseVertex = (GLint) pool->numVertices;
+
+  // Binding GL_ELEMENT_ARRAY_BUFFER outside a vertex array object would
+  // change whatever object is bound, so go through the copy target instead
+  glBindBuffer(GL_COPY_WRITE_BUFFER, pool->eleBufID);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, pool->numIndices * sizeof(unsigned),
+    eleBuf.size() * sizeof(unsigned), &eleBuf[0]);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  pool->numVertices += vertexCount;
+  pool->numIndices += eleBuf.size();
+  pool->meshes.push_back(range);
+
+  return (int) pool->meshes.size() - 1;
+}
+
+int meshPoolAdd(MeshPool *pool, const std::vector<float> &posBuf,
+  const std::vector<float> &texCoordBuf, const std::vector<unsigned> &eleBuf) {
+  ALLOC_TAG(ALLOC_MESH);
+  size_t vertexCount = posBuf.size() / 3;
+
+  if(texCoordBuf.size() / 2 != vertexCount) {
+    fprintf(stderr, "Mesh has %lu positions but %lu texture coordinates.\n",
+      (unsigned long) vertexCount, (unsigned long) (texCoordBuf.size() / 2));
+    return -1;
+  }
+  if(!meshPoolHasRoom(pool, vertexCount, eleBuf.size())) {
+    return -1;
+  }
+
+  // Copy into the free space at the end of each buffer
+  glBindBuffer(GL_ARRAY_BUFFER, pool->posBufID);
+  glBufferSubData(GL_ARRAY_BUFFER, pool->numVertices * 3 * sizeof(float),
+    posBuf.size() * sizeof(float), &posBuf[0]);
+
+  glBindBuffer(GL_ARRAY_BUFFER, pool->texCoordBufID);
+  glBufferSubData(GL_ARRAY_BUFFER, pool->numVertices * 2 * sizeof(float),
+    texCoordBuf.size() * sizeof(float), &texCoordBuf[0]);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  return meshPoolCommit(pool, vertexCount, eleBuf);
+}
+
+// Interleave one of mesh's channels into buffer from vertex first on, with
+// components floats per vertex
+static void meshPoolWriteChannel(GLuint buffer, size_t first,
+  const MeshSoA *mesh, int channel, int components) {
+  GLintptr offset = first * components * sizeof(float);
+  GLsizeiptr size = mesh->vertexCount * components * sizeof(float);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  // Nothing draws from the free space yet, so it can be written without
+  // waiting on the GPU or keeping its old contents
+  float *data = (float *) glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+  if(data != NULL) {
+    meshSoAInterleave(mesh, channel, data);
+    // GL_FALSE means the store was lost while mapped (a mode switch, say)
+    // and the range holds garbage, so write it again
+    if(glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE) {
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      return;
+    }
+    fprintf(stderr, "Mapped mesh data was lost, uploading it again.\n");
+  }
+  std::vector<float> staging(mesh->vertexCount * components);
+  meshSoAInterleave(mesh, channel, &staging[0]);
+  glBufferSubData(GL_ARRAY_BUFFER, offset, size, &staging[0]);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+int meshPoolAddSoA(MeshPool *pool, const MeshSoA *mesh) {
+  ALLOC_TAG(ALLOC_MESH);
+  if(mesh->u == NULL && mesh->vertexCount > 0) {
+    fprintf(stderr, "Mesh has no texture coordinates.\n");
+    return -1;
+  }
+  if(!meshPoolHasRoom(pool, mesh->vertexCount, mesh->indices.size())) {
+    return -1;
+  }
+
+  if(mesh->vertexCount > 0) {
+    meshPoolWriteChannel(pool->posBufID, pool->numVertices, mesh,
+      MESH_SOA_POSITIONS, 3);
+    meshPoolWriteChannel(pool->texCoordBufID, pool->numVertices, mesh,
+      MESH_SOA_TEXCOORDS, 2);
+  }
+
+  return meshPoolCommit(pool, mesh->vertexCount, mesh->indices);
+}
+
+void meshPoolClear(MeshPool *pool) {
+  pool->meshes.clear();
+  pool->numVertices = pool->numIndices = 0;
+}
+
+void meshPoolDestroy(MeshPool *pool) {
+  glDeleteVertexArrays(1, &pool->vaoID);
+  glDeleteBuffers(1, &pool->posBufID);
+  glDeleteBuffers(1, &pool->texCoordBufID);
+  glDeleteBuffers(1, &pool->eleBufID);
+  pool->meshes.clear();
+  pool->numVertices = pool->numIndices = 0;
+}
+
+void meshBatchInit(MeshBatch *batch, size_t maxDraws) {
+  batch->indirect = GLEW_ARB_multi_draw_indirect;
+  batch->commands.reserve(maxDraws);
+  if(batch->indirect) {
+    ringBufferInit(&batch->ring, GL_DRAW_INDIRECT_BUFFER,
+      maxDraws * sizeof(DrawElementsIndirectCommand));
+  }
+}
+
+void meshBatchBegin(MeshBatch *batch) {
+  batch->commands.clear();
+}
+
+void meshBatchAdd(MeshBatch *batch, const MeshPool *pool, int mesh,
+  GLuint instanceCount, GLuint baseInstance) {
+  const MeshRange &range = pool->meshes[mesh];
+  DrawElementsIndirectCommand cmd;
+
+  cmd.count = range.indexCount;
+  cmd.instanceCount = instanceCount;
+  cmd.firstIndex = range.firstIndex;
+  cmd.baseVertex = range.baseVertex;
+  cmd.baseInstance = baseInstance;
+  batch->commands.push_back(cmd);
+}
+
+// Submit with plain GL 3.2 calls when indirect drawing is missing
+static void meshBatchSubmitFallback(MeshBatch *batch) {
+  size_t numDraws = batch->commands.size();
+  bool singleInstance = true;
+
+  for(size_t i = 0; i < numDraws; i++) {
+    if(batch->commands[i].instanceCount != 1) {
+      singleInstance = false;
+    }
+  }
+
+  if(!singleInstance) {
+    // No multi-draw entry point takes instance counts before GL 4.3
+    for(size_t i = 0; i < numDraws; i++) {
+      const DrawElementsIndirectCommand &cmd = batch->commands[i];
+      glDrawElementsInstancedBaseVertex(GL_TRIANGLES, cmd.count,
+        GL_UNSIGNED_INT, (const void *) (cmd.firstIndex * sizeof(unsigned)),
+        cmd.instanceCount, cmd.baseVertex);
+    }
+    return;
+  }
+
+  std::vector<GLsizei> counts(numDraws);
+  std::vector<const void *> offsets(numDraws);
+  std::vector<GLint> baseVertices(numDraws);
+  for(size_t i = 0; i < numDraws; i++) {
+    counts[i] = batch->commands[i].count;
+    offsets[i] = (const void *) (batch->commands[i].firstIndex *
+      sizeof(unsigned));
+    baseVertices[i] = batch->commands[i].baseVertex;
+  }
+  glMultiDrawElementsBaseVertex(GL_TRIANGLES, &counts[0], GL_UNSIGNED_INT,
+    &offsets[0], (GLsizei) numDraws, &baseVertices[0]);
+}
+
+void meshBatchSubmit(MeshBatch *batch, const MeshPool *pool) {
+  size_t numDraws = batch->commands.size();
+  if(numDraws == 0) {
+    return;
+  }
+
+  glBindVertexArray(pool->vaoID);
+
+  if(!batch->indirect) {
+    meshBatchSubmitFallback(batch);
+    glBindVertexArray(0);
+    return;
+  }
+
+  // Stream the command array and let the GPU walk it
+  GLintptr offset = 0;
+  size_t size = numDraws * sizeof(DrawElementsIndirectCommand);
+  ringBufferBeginFrame(&batch->ring);
+  void *data = ringBufferAlloc(&batch->ring, size, &offset);
+  if(data == NULL) {
+    ringBufferFlush(&batch->ring);
+    meshBatchSubmitFallback(batch);
+  } else {
+    memcpy(data, &batch->commands[0], size);
+    ringBufferFlush(&batch->ring);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch->ring.id);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+      (const void *) offset, (GLsizei) numDraws, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+  ringBufferEndFrame(&batch->ring);
+
+  glBindVertexArray(0);
+}
+
+void meshBatchDestroy(MeshBatch *batch) {
+  if(batch->indirect) {
+    ringBufferDestroy(&batch->ring);
+  }
+  batch->commands.clear();
+}
@@ -0,0 +1,93 @@
+#ifndef MESH_POOL_H
+#define MESH_POOL_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "gl_include.h"
+
+#include "ring_buffer.h"
+
+struct MeshSoA;
+
+// Attribute locations the pool's vertex array feeds, matching the layout
+// qualifiers in vertexShader.glsl
+#define MESH_POS_LOC 0
+#define MESH_TEXCOORD_LOC 1
+
+// Where one mesh lives inside the pool's shared buffers
+struct MeshRange {
+  GLuint indexCount;
+  GLuint firstIndex;
+  GLint baseVertex;
+};
+
+// Every mesh's vertices and indices sub-allocated from one set of large
+// buffers behind a single vertex array object, so switching meshes costs
+// nothing but different draw parameters
+struct MeshPool {
+  unsigned vaoID;
+  unsigned posBufID;
+  unsigned texCoordBufID;
+  unsigned eleBufID;
+
+  size_t maxVertices, maxIndices;
+  size_t numVertices, numIndices;
+
+  std::vector<MeshRange> meshes;
+};
+
+// Layout of one command in GL_DRAW_INDIRECT_BUFFER, fixed by the GL spec
+struct DrawElementsIndirectCommand {
+  GLuint count;
+  GLuint instanceCount;
+  GLuint firstIndex;
+  GLint baseVertex;
+  GLuint baseInstance;
+};
+
+// Draws from a MeshPool collected over a frame and submitted at once
+struct MeshBatch {
+  std::vector<DrawElementsIndirectCommand> commands;
+  // Whether glMultiDrawElementsIndirect is available
+  bool indirect;
+  // Streams the command array to the GPU each frame
+  RingBuffer ring;
+};
+
+// Reserve room for maxVertices vertices and maxIndices indices
+void meshPoolInit(MeshPool *pool, size_t maxVertices, size_t maxIndices);
+
+// Copy a mesh into the pool. Positions are xyz, texture coordinates uv, and
+// indices are relative to the mesh's own first vertex. Returns the mesh
+// handle, or -1 if the pool is full.
+int meshPoolAdd(MeshPool *pool, const std::vector<float> &posBuf,
+  const std::vector<float> &texCoordBuf, const std::vector<unsigned> &eleBuf);
+
+// meshPoolAdd from a structure of arrays mesh, which must have texture
+// coordinates. Its channels are interleaved straight into the mapped
+// buffers, with no interleaved copy on the CPU.
+int meshPoolAddSoA(MeshPool *pool, const MeshSoA *mesh);
+
+// Forget every mesh, keeping the buffers for the next ones
+void meshPoolClear(MeshPool *pool);
+
+void meshPoolDestroy(MeshPool *pool);
+
+// Allow up to maxDraws commands per frame
+void meshBatchInit(MeshBatch *batch, size_t maxDraws);
+
+// Start collecting a new frame's draws
+void meshBatchBegin(MeshBatch *batch);
+
+// Queue instanceCount copies of mesh. baseInstance offsets per-instance
+// attributes and is only honored on the multi-draw indirect path.
+void meshBatchAdd(MeshBatch *batch, const MeshPool *pool, int mesh,
+  GLuint instanceCount, GLuint baseInstance);
+
+// Draw everything queued this frame with the pool's vertex array
+void meshBatchSubmit(MeshBatch *batch, const MeshPool *pool);
+
+void meshBatchDestroy(MeshBatch *batch);
+
+#endif
@@ -0,0 +1,193 @@
+#include "mesh_soa.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc_track.h"
+#include "simd.h"
+
+// Channels are aligned and padded, so loads are aligned and loops run over
+// whole vectors of SIMD_LANES vertices.
+
+// Floats per MESH_SOA_ALIGN bytes, what capacity is rounded to
+#define MESH_SOA_GRANULE (MESH_SOA_ALIGN / sizeof(float))
+
+// Where an empty box starts, as in resizeMesh
+#define MESH_SOA_HUGE 1.1754E+38F
+
+bool meshSoAInit(MeshSoA *mesh, size_t vertexCount, int channels) {
+  ALLOC_TAG(ALLOC_MESH);
+  meshSoAFree(mesh);
+
+  size_t capacity = (vertexCount + MESH_SOA_GRANULE - 1) / MESH_SOA_GRANULE *
+    MESH_SOA_GRANULE;
+  int count = 3;
+  if(channels & MESH_SOA_NORMALS) {
+    count += 3;
+  }
+  if(channels & MESH_SOA_TEXCOORDS) {
+    count += 2;
+  }
+  if(capacity > 0) {
+    // Over allocate and align by hand, so the tracked malloc sees it
+    mesh->storage = malloc(capacity * count * sizeof(float) + MESH_SOA_ALIGN);
+    if(mesh->storage == NULL) {
+      return false;
+    }
+  }
+  float *next = (float *) (((uintptr_t) mesh->storage + MESH_SOA_ALIGN - 1) &
+    ~(uintptr_t) (MESH_SOA_ALIGN - 1));
+
+  mesh->vertexCount = vertexCount;
+  mesh->capacity = capacity;
+  float **channel[] = {&mesh->x, &mesh->y, &mesh->z, &mesh->nx, &mesh->ny,
+    &mesh->nz, &mesh->u, &mesh->v};
+  for(int i = 0; i < 8; i++) {
+    bool present = i < 3 || (i < 6 ? (channels & MESH_SOA_NORMALS) != 0 :
+      (channels & MESH_SOA_TEXCOORDS) != 0);
+    if(present && capacity > 0) {
+      *channel[i] = next;
+      next += capacity;
+    } else {
+      *channel[i] = NULL;
+    }
+  }
+  return true;
+}
+
+// Split a vertex's count interleaved components into the channels, then
+// repeat the last vertex over the padding
+static void deinterleave(float *const *channels, int count, const float *in,
+  size_t vertexCount, size_t capacity) {
+  for(int c = 0; c < count; c++) {
+    float *out = channels[c];
+    for(size_t v = 0; v < vertexCount; v++) {
+      out[v] = in[v * count + c];
+    }
+    for(size_t v = vertexCount; v < capacity; v++) {
+      out[v] = out[vertexCount - 1];
+    }
+  }
+}
+
+bool meshSoAFromInterleaved(MeshSoA *mesh, const float *positions,
+  const float *normals, const float *texCoords, size_t vertexCount,
+  const unsigned *indices, size_t indexCount) {
+  ALLOC_TAG(ALLOC_MESH);
+  int channels = MESH_SOA_POSITIONS;
+  if(normals != NULL) {
+    channels |= MESH_SOA_NORMALS;
+  }
+  if(texCoords != NULL) {
+    channels |= MESH_SOA_TEXCOORDS;
+  }
+  if(!meshSoAInit(mesh, vertexCount, channels)) {
+    return false;
+  }
+  mesh->indices.assign(indices, indices + indexCount);
+  if(vertexCount == 0) {
+    return true;
+  }
+
+  float *position[3] = {mesh->x, mesh->y, mesh->z};
+  deinterleave(position, 3, positions, vertexCount, mesh->capacity);
+  if(normals != NULL) {
+    float *normal[3] = {mesh->nx, mesh->ny, mesh->nz};
+    deinterleave(normal, 3, normals, vertexCount, mesh->capacity);
+  }
+  if(texCoords != NULL) {
+    float *texCoord[2] = {mesh->u, mesh->v};
+    deinterleave(texCoord, 2, texCoords, vertexCount, mesh->capacity);
+  }
+  return true;
+}
+
+// Smallest and largest of one channel, skipping NaNs
+static void channelBounds(const float *p, size_t capacity, float *min,
+  float *max) {
+  vfloat vMin = vset1(MESH_SOA_HUGE), vMax = vset1(-MESH_SOA_HUGE);
+  for(size_t i = 0; i < capacity; i += SIMD_LANES) {
+    vfloat a = vloadAligned(p + i);
+    vMin = vmin(a, vMin);
+    vMax = vmax(a, vMax);
+  }
+
+  // Unions keep the lanes aligned for the stores
+  union { vfloat v; float f[SIMD_LANES]; } mins, maxs;
+  vstoreAligned(mins.f, vMin);
+  vstoreAligned(maxs.f, vMax);
+  *min = MESH_SOA_HUGE;
+  *max = -MESH_SOA_HUGE;
+  for(int i = 0; i < SIMD_LANES; i++) {
+    if(mins.f[i] < *min) *min = mins.f[i];
+    if(maxs.f[i] > *max) *max = maxs.f[i];
+  }
+}
+
+void meshSoABounds(const MeshSoA *mesh, float min[3], float max[3]) {
+  const float *position[3] = {mesh->x, mesh->y, mesh->z};
+  for(int c = 0; c < 3; c++) {
+    channelBounds(position[c], mesh->capacity, &min[c], &max[c]);
+  }
+}
+
+void meshSoAResize(MeshSoA *mesh) {
+  float min[3], max[3];
+  meshSoABounds(mesh, min, max);
+
+  float extent[3];
+  for(int c = 0; c < 3; c++) {
+    extent[c] = max[c] - min[c];
+  }
+  float maxExtent = extent[0];
+  if(extent[1] > maxExtent) maxExtent = extent[1];
+  if(extent[2] > maxExtent) maxExtent = extent[2];
+
+  // Computed in double and rounded once, as resizeMesh does, so the results
+  // match it bit for bit
+  float scale = (float) (2.0 / maxExtent);
+  float *position[3] = {mesh->x, mesh->y, mesh->z};
+  for(int c = 0; c < 3; c++) {
+    vfloat shift = vset1((float) (min[c] + extent[c] / 2.0));
+    vfloat vScale = vset1(scale);
+    float *p = position[c];
+    // The padding copies the last vertex and stays a copy of it
+    for(size_t i = 0; i < mesh->capacity; i += SIMD_LANES) {
+      vstoreAligned(p + i, vmul(vsub(vloadAligned(p + i), shift), vScale));
+    }
+  }
+}
+
+void meshSoAInterleave(const MeshSoA *mesh, int channel, float *out) {
+  size_t count = mesh->vertexCount;
+  if(channel == MESH_SOA_TEXCOORDS) {
+    for(size_t v = 0; v < count; v++) {
+      out[2*v+0] = mesh->u[v];
+      out[2*v+1] = mesh->v[v];
+    }
+    return;
+  }
+
+  const float *x = mesh->x, *y = mesh->y, *z = mesh->z;
+  if(channel == MESH_SOA_NORMALS) {
+    x = mesh->nx;
+    y = mesh->ny;
+    z = mesh->nz;
+  }
+  for(size_t v = 0; v < count; v++) {
+    out[3*v+0] = x[v];
+    out[3*v+1] = y[v];
+    out[3*v+2] = z[v];
+  }
+}
+
+void meshSoAFree(MeshSoA *mesh) {
+  free(mesh->storage);
+  mesh->storage = NULL;
+  mesh->x = mesh->y = mesh->z = NULL;
+  mesh->nx = mesh->ny = mesh->nz = NULL;
+  mesh->u = mesh->v = NULL;
+  mesh->vertexCount = mesh->capacity = 0;
+  std::vector<unsigned>().swap(mesh->indices);
+}
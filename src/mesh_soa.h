@@ -0,0 +1,64 @@
+#ifndef MESH_SOA_H
+#define MESH_SOA_H
+
+#include <stddef.h>
+#include <vector>
+
+// Alignment of each channel, a cache line (and a multiple of an AVX vector)
+#define MESH_SOA_ALIGN 64
+
+// Channels a MeshSoA can hold, positions are always there
+#define MESH_SOA_POSITIONS 1
+#define MESH_SOA_NORMALS 2
+#define MESH_SOA_TEXCOORDS 4
+
+// A mesh stored as structure of arrays: one float array per component
+// instead of the xyz xyz ... of tinyobj::mesh_t, so CPU passes over it
+// (bounds, normalization, transforms) run a whole SSE/AVX vector of
+// vertices per instruction with aligned loads. The interleaved layouts GL
+// and the CPU rasterizers take are made from it with meshSoAInterleave, or
+// written straight into the GPU buffers by meshPoolAddSoA.
+//
+// Every channel holds capacity floats, vertexCount rounded up to a whole
+// MESH_SOA_ALIGN bytes, so each starts aligned and vector loops never need
+// a scalar tail. The padding repeats the last vertex, leaving the bounds
+// unchanged.
+struct MeshSoA {
+  size_t vertexCount;
+  size_t capacity;
+  float *x, *y, *z;
+  float *nx, *ny, *nz; // NULL without MESH_SOA_NORMALS
+  float *u, *v; // NULL without MESH_SOA_TEXCOORDS
+  std::vector<unsigned> indices; // Triangles
+  void *storage; // One allocation behind every channel
+};
+
+// Make room for vertexCount vertices with the given channels (a mask of
+// MESH_SOA_*), discarding the old contents. mesh is either value
+// initialized (MeshSoA mesh = MeshSoA()) or was set up before. Returns false
+// if out of memory.
+bool meshSoAInit(MeshSoA *mesh, size_t vertexCount, int channels);
+
+// Fill the mesh from interleaved arrays: positions xyz, normals xyz and
+// texCoords uv per vertex, normals or texCoords NULL where there are none.
+// Returns false if out of memory.
+bool meshSoAFromInterleaved(MeshSoA *mesh, const float *positions,
+  const float *normals, const float *texCoords, size_t vertexCount,
+  const unsigned *indices, size_t indexCount);
+
+// Bounding box of the positions. With no vertices min is a huge positive
+// number and max a huge negative one, an empty box.
+void meshSoABounds(const MeshSoA *mesh, float min[3], float max[3]);
+
+// resizeMesh on the SoA positions, with bit identical results: center them
+// on the origin and scale uniformly so the longest side spans -1 .. 1
+void meshSoAResize(MeshSoA *mesh);
+
+// Write one channel interleaved to out: xyz per vertex for
+// MESH_SOA_POSITIONS or MESH_SOA_NORMALS, uv for MESH_SOA_TEXCOORDS.
+// out holds vertexCount * 3 (or 2) floats and needs no alignment.
+void meshSoAInterleave(const MeshSoA *mesh, int channel, float *out);
+
+void meshSoAFree(MeshSoA *mesh);
+
+#endif
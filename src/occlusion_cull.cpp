@@ -0,0 +1,526 @@
+#include "occlusion_cull.h"
+#include "raster_setup.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#  define OCCLUSION_SIMD 1
+#else
+#  define OCCLUSION_SIMD 0
+#endif
+
+// Setup and test jobs per thread, so uneven jobs still spread out
+#define OCCLUSION_JOBS_PER_THREAD 4
+// Fewest boxes worth handing to another thread
+#define OCCLUSION_MIN_TEST_JOB 256
+
+// An occluder triangle ready to rasterize
+struct OccluderTriangle : RasterTriangle {
+  RasterPlane z; // Window depth
+};
+
+struct OcclusionState {
+  JobPool pool;
+  int setupJobs;
+
+  // Scratch for the frame in progress, kept so steady state frames don't
+  // allocate
+  const OccluderDraw *draw;
+  glm::mat4 viewProj; // Of the occluders, for the box tests
+  std::vector<std::pair<float, unsigned> > ranked; // Score, instance
+  std::vector<unsigned> occluders;
+  std::vector<unsigned char> isOccluder; // Per box
+  std::vector<std::vector<glm::vec4> > clip; // Per setup job, per vertex
+  std::vector<std::vector<OccluderTriangle> > triangles; // Per setup job
+
+  // Boxes of the test in progress
+  const AABBList *boxes;
+  const unsigned *visible;
+  size_t count;
+  int testJobs;
+  std::vector<unsigned char> keep;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+// Viewport transform, back face culling and edge setup of a clipped
+// triangle. Back faces of a closed occluder are behind its front faces
+// anyway. Returns false if it covers no pixel centers.
+static bool setupTriangle(const OcclusionCuller *cull, const glm::vec4 &v0,
+  const glm::vec4 &v1, const glm::vec4 &v2, OccluderTriangle *tri) {
+  const glm::vec4 *v[3] = {&v0, &v1, &v2};
+  float x[3], y[3], z[3], invW;
+  for(int i = 0; i < 3; i++) {
+    rasterViewport(*v[i], cull->width[0], cull->height[0], &x[i], &y[i],
+      &z[i], &invW);
+  }
+
+  float invArea;
+  if(!rasterSetup(x, y, cull->width[0], cull->height[0], tri, &invArea)) {
+    return false;
+  }
+  tri->z = rasterPlane(tri, z, invArea);
+  return true;
+}
+
+// Transform, clip and set up the triangles of a range of occluders
+static void setupJob(void *context, int index) {
+  OcclusionCuller *cull = (OcclusionCuller *) context;
+  OcclusionState *s = cull->state;
+  const OccluderDraw *draw = s->draw;
+  std::vector<glm::vec4> &clip = s->clip[index];
+  std::vector<OccluderTriangle> &triangles = s->triangles[index];
+  triangles.clear();
+  clip.resize(draw->vertexCount);
+
+  size_t begin, end;
+  jobRange(s->occluders.size(), s->setupJobs, index, &begin, &end);
+  for(size_t n = begin; n < end; n++) {
+    glm::mat4 m = draw->viewProj * draw->instances[s->occluders[n]];
+    for(size_t v = 0; v < draw->vertexCount; v++) {
+      const float *p = &draw->positions[3 * v];
+      clip[v] = m * glm::vec4(p[0], p[1], p[2], 1.f);
+    }
+
+    for(size_t t = 0; t + 2 < draw->indexCount; t += 3) {
+      glm::vec4 polygon[3] = {
+        clip[draw->indices[t]], clip[draw->indices[t + 1]],
+        clip[draw->indices[t + 2]]
+      };
+
+      if(rasterOutside(polygon[0], polygon[1], polygon[2])) {
+        continue;
+      }
+
+      // Only the near plane needs clipping, depth past the far plane is
+      // clamped by the buffer's clear value
+      glm::vec4 clipped[4];
+      const glm::vec4 *poly = polygon;
+      int count = 3;
+      if(polygon[0].z < -polygon[0].w || polygon[1].z < -polygon[1].w ||
+        polygon[2].z < -polygon[2].w) {
+        count = rasterClip(polygon, 3, clipped, rasterNearPlane);
+        poly = clipped;
+      }
+      for(int i = 1; i + 1 < count; i++) {
+        OccluderTriangle tri;
+        if(setupTriangle(cull, poly[0], poly[i], poly[i + 1], &tri)) {
+          triangles.push_back(tri);
+        }
+      }
+    }
+  }
+}
+
+// Keep the nearer depth of each covered pixel in rows [y0, y1]
+static void rasterTriangle(OcclusionCuller *cull, const OccluderTriangle *tri,
+  int y0, int y1) {
+  if(tri->minY > y0) {
+    y0 = tri->minY;
+  }
+  if(tri->maxY < y1) {
+    y1 = tri->maxY;
+  }
+  for(int y = y0; y <= y1; y++) {
+    float *row = &cull->depth[0][(size_t) y * cull->stride[0]];
+    float py = y + .5f;
+#if OCCLUSION_SIMD
+    __m128 zero = _mm_setzero_ps();
+    __m128 last = _mm_set1_ps((float) tri->maxX);
+    __m128 edgeRow[3], edgeStep[3];
+    int x = tri->minX & ~3;
+    __m128 column = _mm_add_ps(_mm_set1_ps((float) x),
+      _mm_set_ps(3.f, 2.f, 1.f, 0.f));
+    __m128 px = _mm_add_ps(column, _mm_set1_ps(.5f));
+    for(int e = 0; e < 3; e++) {
+      edgeRow[e] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->a[e]), px),
+        _mm_set1_ps(tri->b[e] * py + tri->c[e]));
+      edgeStep[e] = _mm_set1_ps(tri->a[e] * 4.f);
+    }
+    __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->z.dx), px),
+      _mm_set1_ps(tri->z.dy * py + tri->z.c));
+    __m128 zStep = _mm_set1_ps(tri->z.dx * 4.f);
+    __m128 four = _mm_set1_ps(4.f);
+    for(; x <= tri->maxX; x += 4) {
+      __m128 inside = _mm_cmple_ps(column, last);
+      for(int e = 0; e < 3; e++) {
+        inside = _mm_and_ps(inside, (tri->topLeft & (1 << e)) ?
+          _mm_cmpge_ps(edgeRow[e], zero) : _mm_cmpgt_ps(edgeRow[e], zero));
+        edgeRow[e] = _mm_add_ps(edgeRow[e], edgeStep[e]);
+      }
+      if(_mm_movemask_ps(inside) != 0) {
+        __m128 stored = _mm_loadu_ps(&row[x]);
+        __m128 nearer = _mm_min_ps(z, stored);
+        _mm_storeu_ps(&row[x], _mm_or_ps(_mm_and_ps(inside, nearer),
+          _mm_andnot_ps(inside, stored)));
+      }
+      z = _mm_add_ps(z, zStep);
+      column = _mm_add_ps(column, four);
+    }
+#else
+    for(int x = tri->minX; x <= tri->maxX; x++) {
+      float px = x + .5f;
+      bool inside = true;
+      for(int e = 0; e < 3 && inside; e++) {
+        float edge = tri->a[e] * px + (tri->b[e] * py + tri->c[e]);
+        inside = (tri->topLeft & (1 << e)) ? edge >= 0.f : edge > 0.f;
+      }
+      float z = tri->z.dx * px + (tri->z.dy * py + tri->z.c);
+      if(inside && z < row[x]) {
+        row[x] = z;
+      }
+    }
+#endif
+  }
+}
+
+// Rows [y0, y1) of a level, each texel the farthest of the 2x2 under it
+// (edge texels of an odd sized level below are reused)
+static void reduceRows(OcclusionCuller *cull, int level, int y0, int y1) {
+  int width = cull->width[level];
+  int below = level - 1;
+  int belowWidth = cull->width[below];
+  int belowHeight = cull->height[below];
+  for(int y = y0; y < y1; y++) {
+    int r0 = 2 * y;
+    int r1 = 2 * y + 1 < belowHeight ? 2 * y + 1 : belowHeight - 1;
+    const float *row0 = &cull->depth[below][(size_t) r0 * cull->stride[below]];
+    const float *row1 = &cull->depth[below][(size_t) r1 * cull->stride[below]];
+    float *out = &cull->depth[level][(size_t) y * cull->stride[level]];
+    int x = 0;
+#if OCCLUSION_SIMD
+    for(; 2 * x + 8 <= belowWidth; x += 4) {
+      __m128 lo = _mm_max_ps(_mm_loadu_ps(&row0[2 * x]),
+        _mm_loadu_ps(&row1[2 * x]));
+      __m128 hi = _mm_max_ps(_mm_loadu_ps(&row0[2 * x + 4]),
+        _mm_loadu_ps(&row1[2 * x + 4]));
+      _mm_storeu_ps(&out[x], _mm_max_ps(
+        _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)),
+        _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))));
+    }
+#endif
+    for(; x < width; x++) {
+      int c0 = 2 * x;
+      int c1 = 2 * x + 1 < belowWidth ? 2 * x + 1 : belowWidth - 1;
+      out[x] = fmaxf(fmaxf(row0[c0], row0[c1]), fmaxf(row1[c0], row1[c1]));
+    }
+  }
+}
+
+// Clear, rasterize every occluder triangle and reduce the levels that only
+// depend on this band
+static void bandJob(void *context, int band) {
+  OcclusionCuller *cull = (OcclusionCuller *) context;
+  OcclusionState *s = cull->state;
+  int y0 = band * OCCLUSION_BAND_SIZE;
+  int y1 = y0 + OCCLUSION_BAND_SIZE < cull->height[0] ?
+    y0 + OCCLUSION_BAND_SIZE : cull->height[0];
+
+  for(int y = y0; y < y1; y++) {
+    float *row = &cull->depth[0][(size_t) y * cull->stride[0]];
+    for(int x = 0; x < cull->stride[0]; x++) {
+      row[x] = 1.f;
+    }
+  }
+
+  for(int job = 0; job < s->setupJobs; job++) {
+    const std::vector<OccluderTriangle> &triangles = s->triangles[job];
+    for(size_t i = 0; i < triangles.size(); i++) {
+      if(triangles[i].minY < y1 && triangles[i].maxY >= y0) {
+        rasterTriangle(cull, &triangles[i], y0, y1 - 1);
+      }
+    }
+  }
+
+  // The band's rows of level k come only from its rows of level k - 1 while
+  // 2^k divides the band size
+  for(int level = 1; level < cull->levels &&
+    (OCCLUSION_BAND_SIZE >> level) << level == OCCLUSION_BAND_SIZE; level++) {
+    int end = y1 == cull->height[0] ? cull->height[level] : y1 >> level;
+    reduceRows(cull, level, y0 >> level, end);
+  }
+}
+
+void occlusionInit(OcclusionCuller *cull, int width, int height,
+  int threads) {
+  OcclusionState *s = new OcclusionState();
+  cull->state = s;
+  cull->levels = 0;
+  while(cull->levels < OCCLUSION_MAX_LEVELS) {
+    int level = cull->levels++;
+    cull->width[level] = width;
+    cull->height[level] = height;
+    cull->stride[level] = (width + 3) & ~3;
+    cull->depth[level] = (float *) malloc((size_t) cull->stride[level] *
+      height * sizeof(float));
+    if(width == 1 && height == 1) {
+      break;
+    }
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+  }
+  for(int level = cull->levels; level < OCCLUSION_MAX_LEVELS; level++) {
+    cull->width[level] = cull->height[level] = cull->stride[level] = 0;
+    cull->depth[level] = NULL;
+  }
+
+  jobPoolInit(&s->pool, threads);
+  s->setupJobs = s->pool.threads * OCCLUSION_JOBS_PER_THREAD;
+  s->clip.resize(s->setupJobs);
+  s->triangles.resize(s->setupJobs);
+  s->draw = NULL;
+  s->boxes = NULL;
+  s->visible = NULL;
+  s->count = 0;
+  s->testJobs = 0;
+}
+
+void occlusionRender(OcclusionCuller *cull, const OccluderDraw *draw,
+  const AABBList *boxes, OcclusionStats *stats) {
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  OcclusionState *s = cull->state;
+
+  // Forget last frame's occluders
+  s->isOccluder.resize(boxes->count);
+  for(size_t i = 0; i < s->occluders.size(); i++) {
+    if(s->occluders[i] < boxes->count) {
+      s->isOccluder[s->occluders[i]] = 0;
+    }
+  }
+  s->occluders.clear();
+
+  // Rank the candidates by squared box radius over squared distance along
+  // the view direction, nearly the square of their size on screen. Boxes
+  // reaching behind the camera come first.
+  const glm::mat4 &m = draw->viewProj;
+  s->ranked.clear();
+  for(size_t i = 0; i < draw->candidateCount; i++) {
+    unsigned id = draw->candidates[i];
+    float cx = (boxes->minX[id] + boxes->maxX[id]) * .5f;
+    float cy = (boxes->minY[id] + boxes->maxY[id]) * .5f;
+    float cz = (boxes->minZ[id] + boxes->maxZ[id]) * .5f;
+    float ex = boxes->maxX[id] - cx;
+    float ey = boxes->maxY[id] - cy;
+    float ez = boxes->maxZ[id] - cz;
+    float radius2 = ex * ex + ey * ey + ez * ez;
+    float w = m[0][3] * cx + m[1][3] * cy + m[2][3] * cz + m[3][3];
+    float score = w * w > radius2 ? radius2 / (w * w) : FLT_MAX;
+    s->ranked.push_back(std::make_pair(score, id));
+  }
+  size_t numOccluders = s->ranked.size() < OCCLUSION_MAX_OCCLUDERS ?
+    s->ranked.size() : OCCLUSION_MAX_OCCLUDERS;
+  if(numOccluders < s->ranked.size()) {
+    std::nth_element(s->ranked.begin(), s->ranked.begin() + numOccluders,
+      s->ranked.end(), std::greater<std::pair<float, unsigned> >());
+  }
+  for(size_t i = 0; i < numOccluders; i++) {
+    s->occluders.push_back(s->ranked[i].second);
+    s->isOccluder[s->ranked[i].second] = 1;
+  }
+
+  s->draw = draw;
+  s->viewProj = draw->viewProj;
+  jobPoolRun(&s->pool, setupJob, cull, s->setupJobs);
+  int bands = (cull->height[0] + OCCLUSION_BAND_SIZE - 1) /
+    OCCLUSION_BAND_SIZE;
+  jobPoolRun(&s->pool, bandJob, cull, bands);
+  s->draw = NULL;
+
+  // Levels too small to split across bands
+  for(int level = 1; level < cull->levels; level++) {
+    if((OCCLUSION_BAND_SIZE >> level) << level != OCCLUSION_BAND_SIZE) {
+      reduceRows(cull, level, 0, cull->height[level]);
+    }
+  }
+
+  if(stats != NULL) {
+    stats->occluders = (unsigned) numOccluders;
+    stats->triangles = 0;
+    for(int job = 0; job < s->setupJobs; job++) {
+      stats->triangles += (unsigned) s->triangles[job].size();
+    }
+    stats->renderTime = secondsSince(start);
+  }
+}
+
+// Whether box id is behind the occluders: its nearest depth is farther than
+// the farthest occluder depth over its screen rectangle
+static bool boxOccluded(const OcclusionCuller *cull, const glm::mat4 &m,
+  const AABBList *boxes, unsigned id) {
+  // Window space bounds of the 8 corners
+  float minX, minY, maxX, maxY, minZ;
+#if OCCLUSION_SIMD
+  // Corner i has the max x when bit 0 is set, max y with bit 1, max z with
+  // bit 2; lanes hold corners 0 .. 3 and 4 .. 7
+  __m128 x = _mm_set_ps(boxes->maxX[id], boxes->minX[id], boxes->maxX[id],
+    boxes->minX[id]);
+  __m128 y = _mm_set_ps(boxes->maxY[id], boxes->maxY[id], boxes->minY[id],
+    boxes->minY[id]);
+  __m128 z[2] = {_mm_set1_ps(boxes->minZ[id]), _mm_set1_ps(boxes->maxZ[id])};
+  __m128 clip[4][2];
+  for(int r = 0; r < 4; r++) {
+    __m128 xy = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0][r]), x),
+      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[1][r]), y),
+        _mm_set1_ps(m[3][r])));
+    for(int h = 0; h < 2; h++) {
+      clip[r][h] = _mm_add_ps(xy, _mm_mul_ps(_mm_set1_ps(m[2][r]), z[h]));
+    }
+  }
+  // A corner at or behind the camera, the box may cover anything
+  __m128 epsilon = _mm_set1_ps(FLT_EPSILON);
+  if(_mm_movemask_ps(_mm_or_ps(_mm_cmple_ps(clip[3][0], epsilon),
+    _mm_cmple_ps(clip[3][1], epsilon))) != 0) {
+    return false;
+  }
+  __m128 lo[3], hi[3];
+  for(int h = 0; h < 2; h++) {
+    __m128 invW = _mm_div_ps(_mm_set1_ps(1.f), clip[3][h]);
+    for(int c = 0; c < 3; c++) {
+      __m128 ndc = _mm_mul_ps(clip[c][h], invW);
+      lo[c] = h == 0 ? ndc : _mm_min_ps(lo[c], ndc);
+      hi[c] = h == 0 ? ndc : _mm_max_ps(hi[c], ndc);
+    }
+  }
+  float lanes[4][4];
+  for(int c = 0; c < 3; c++) {
+    lo[c] = _mm_min_ps(lo[c], _mm_shuffle_ps(lo[c], lo[c],
+      _MM_SHUFFLE(2, 3, 0, 1)));
+    lo[c] = _mm_min_ps(lo[c], _mm_shuffle_ps(lo[c], lo[c],
+      _MM_SHUFFLE(1, 0, 3, 2)));
+    hi[c] = _mm_max_ps(hi[c], _mm_shuffle_ps(hi[c], hi[c],
+      _MM_SHUFFLE(2, 3, 0, 1)));
+    hi[c] = _mm_max_ps(hi[c], _mm_shuffle_ps(hi[c], hi[c],
+      _MM_SHUFFLE(1, 0, 3, 2)));
+  }
+  _mm_storeu_ps(lanes[0], lo[0]);
+  _mm_storeu_ps(lanes[1], lo[1]);
+  _mm_storeu_ps(lanes[2], hi[0]);
+  _mm_storeu_ps(lanes[3], hi[1]);
+  minX = lanes[0][0];
+  minY = lanes[1][0];
+  maxX = lanes[2][0];
+  maxY = lanes[3][0];
+  minZ = _mm_cvtss_f32(lo[2]);
+#else
+  minX = minY = minZ = FLT_MAX;
+  maxX = maxY = -FLT_MAX;
+  for(int i = 0; i < 8; i++) {
+    glm::vec4 corner(
+      (i & 1) ? boxes->maxX[id] : boxes->minX[id],
+      (i & 2) ? boxes->maxY[id] : boxes->minY[id],
+      (i & 4) ? boxes->maxZ[id] : boxes->minZ[id], 1.f);
+    glm::vec4 clip = m * corner;
+    if(clip.w <= FLT_EPSILON) {
+      return false;
+    }
+    float invW = 1.f / clip.w;
+    minX = fminf(minX, clip.x * invW);
+    maxX = fmaxf(maxX, clip.x * invW);
+    minY = fminf(minY, clip.y * invW);
+    maxY = fmaxf(maxY, clip.y * invW);
+    minZ = fminf(minZ, clip.z * invW);
+  }
+#endif
+
+  // Pixels the rectangle touches, partly covered ones included
+  int width = cull->width[0], height = cull->height[0];
+  float depth = minZ * .5f + .5f;
+  int x0 = (int) floorf(fmaxf((minX * .5f + .5f) * width, 0.f));
+  int y0 = (int) floorf(fmaxf((minY * .5f + .5f) * height, 0.f));
+  int x1 = (int) floorf(fminf((maxX * .5f + .5f) * width, width - 1.f));
+  int y1 = (int) floorf(fminf((maxY * .5f + .5f) * height, height - 1.f));
+  if(x0 > x1 || y0 > y1) {
+    return false;
+  }
+
+  // Coarsest level where the rectangle spans at most 2x2 texels
+  int level = 0;
+  while(level + 1 < cull->levels &&
+    ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+    level++;
+  }
+  for(int y = y0 >> level; y <= y1 >> level; y++) {
+    const float *row = &cull->depth[level][(size_t) y * cull->stride[level]];
+    for(int x = x0 >> level; x <= x1 >> level; x++) {
+      if(!(depth > row[x])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static void testJob(void *context, int index) {
+  OcclusionCuller *cull = (OcclusionCuller *) context;
+  OcclusionState *s = cull->state;
+  size_t begin, end;
+  jobRange(s->count, s->testJobs, index, &begin, &end);
+  const glm::mat4 &m = s->viewProj;
+  for(size_t i = begin; i < end; i++) {
+    unsigned id = s->visible[i];
+    s->keep[i] = s->isOccluder[id] || !boxOccluded(cull, m, s->boxes, id);
+  }
+}
+
+size_t occlusionTest(OcclusionCuller *cull, const AABBList *boxes,
+  unsigned *visible, size_t count, OcclusionStats *stats) {
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  OcclusionState *s = cull->state;
+  size_t numVisible = count;
+
+  if(!s->occluders.empty() && count > 0) {
+    s->boxes = boxes;
+    s->visible = visible;
+    s->count = count;
+    s->keep.resize(count);
+    size_t jobs = (count + OCCLUSION_MIN_TEST_JOB - 1) /
+      OCCLUSION_MIN_TEST_JOB;
+    s->testJobs = jobs < (size_t) s->pool.threads * OCCLUSION_JOBS_PER_THREAD ?
+      (int) jobs : s->pool.threads * OCCLUSION_JOBS_PER_THREAD;
+    jobPoolRun(&s->pool, testJob, cull, s->testJobs);
+
+    numVisible = 0;
+    for(size_t i = 0; i < count; i++) {
+      if(s->keep[i]) {
+        visible[numVisible++] = visible[i];
+      }
+    }
+    s->boxes = NULL;
+    s->visible = NULL;
+  }
+
+  if(stats != NULL) {
+    stats->tested = (unsigned) count;
+    stats->occluded = (unsigned) (count - numVisible);
+    stats->testTime = secondsSince(start);
+  }
+  return numVisible;
+}
+
+void occlusionDestroy(OcclusionCuller *cull) {
+  OcclusionState *s = cull->state;
+  if(s != NULL) {
+    jobPoolDestroy(&s->pool);
+    delete s;
+  }
+  for(int level = 0; level < OCCLUSION_MAX_LEVELS; level++) {
+    free(cull->depth[level]);
+    cull->depth[level] = NULL;
+  }
+  cull->levels = 0;
+  cull->state = NULL;
+}
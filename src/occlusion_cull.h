@@ -0,0 +1,87 @@
+#ifndef OCCLUSION_CULL_H
+#define OCCLUSION_CULL_H
+
+#include <stddef.h>
+
+#include <glm/glm.hpp>
+
+#include "frustum_cull.h"
+#include "job_pool.h"
+
+// Hierarchical Z occlusion culling on the CPU. Each frame the instances most
+// likely to hide others (largest on screen) are rasterized as occluders into
+// a low resolution depth buffer, which is reduced into a pyramid where every
+// texel holds the farthest depth of the 2x2 texels under it. Every other
+// instance that survived frustumCull is then tested by projecting its
+// bounding box: it is hidden when its nearest depth is behind the farthest
+// occluder depth over the pyramid texels its screen rectangle touches, and
+// is dropped before anything is submitted.
+//
+// Rasterization splits the buffer into bands of OCCLUSION_BAND_SIZE rows,
+// one per job, and fills 4 pixels at a time with SSE. Box tests run in
+// parallel too. Like the GPU, the occluders are sampled at pixel centers, so
+// an object peeking through a gap narrower than a low resolution pixel can be
+// culled.
+
+#define OCCLUSION_MAX_LEVELS 16
+// Rows per rasterization job, also how many pyramid levels each job reduces
+// on its own (log2 of it)
+#define OCCLUSION_BAND_SIZE 32
+// Instances rasterized as occluders each frame, at most
+#define OCCLUSION_MAX_OCCLUDERS 256
+
+// The occluder mesh (every instance shares it) and the instances to pick the
+// occluders from
+struct OccluderDraw {
+  const float *positions; // xyz per vertex
+  size_t vertexCount;
+  const unsigned *indices; // Triangles, counter clockwise fronts
+  size_t indexCount;
+  glm::mat4 viewProj;
+  const glm::mat4 *instances;
+  const unsigned *candidates; // Usually frustumCull's output
+  size_t candidateCount;
+};
+
+// Totals from the last occlusionRender and occlusionTest calls
+struct OcclusionStats {
+  unsigned occluders;
+  unsigned triangles; // Occluder triangles that reached the rasterizer
+  unsigned tested;
+  unsigned occluded;
+  double renderTime; // Seconds rasterizing and building the pyramid
+  double testTime; // Seconds testing boxes
+};
+
+struct OcclusionState;
+
+struct OcclusionCuller {
+  int levels;
+  // Level 0 is the depth buffer, rows from bottom to top. Window depth in
+  // 0 .. 1 like the default depth range, 1 where nothing was drawn.
+  int width[OCCLUSION_MAX_LEVELS], height[OCCLUSION_MAX_LEVELS];
+  int stride[OCCLUSION_MAX_LEVELS]; // Floats per row, a multiple of 4
+  float *depth[OCCLUSION_MAX_LEVELS];
+  OcclusionState *state; // Worker threads and per-frame scratch
+};
+
+// Create a width x height depth buffer (the projection's aspect need not
+// match) and threads - 1 workers. threads 0 uses every hardware thread.
+void occlusionInit(OcclusionCuller *cull, int width, int height,
+  int threads);
+
+// Pick up to OCCLUSION_MAX_OCCLUDERS occluders among draw->candidates by the
+// size of their boxes on screen, rasterize them and build the pyramid
+void occlusionRender(OcclusionCuller *cull, const OccluderDraw *draw,
+  const AABBList *boxes, OcclusionStats *stats);
+
+// Remove the hidden instances from visible[0 .. count - 1] (in place,
+// keeping the order) and return how many remain. The boxes must be in the
+// space of the viewProj given to the last occlusionRender, which always
+// keeps its occluders.
+size_t occlusionTest(OcclusionCuller *cull, const AABBList *boxes,
+  unsigned *visible, size_t count, OcclusionStats *stats);
+
+void occlusionDestroy(OcclusionCuller *cull);
+
+#endif
@@ -0,0 +1,143 @@
+#include "profiler.h"
+
+#include <stdio.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A finished zone
+struct ProfileEvent {
+  const char *name;
+  int64_t start, duration;
+  int thread;
+};
+
+// Shared by every thread, guarded by mutex
+struct Profile {
+  bool enabled;
+  std::chrono::steady_clock::time_point epoch;
+  std::mutex mutex;
+  std::vector<ProfileEvent> events;
+  // Small track numbers in order of first use, the main thread is 1
+  std::map<std::thread::id, int> threads;
+  std::map<int, std::string> threadNames;
+
+  Profile() : enabled(false) {}
+};
+
+static Profile &profile() {
+  static Profile instance;
+  return instance;
+}
+
+static int64_t now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - profile().epoch).count();
+}
+
+// Track of the calling thread, with the mutex held
+static int threadTrack() {
+  Profile &p = profile();
+  std::map<std::thread::id, int>::iterator it =
+    p.threads.find(std::this_thread::get_id());
+  if(it != p.threads.end()) {
+    return it->second;
+  }
+  int track = (int) p.threads.size() + 1;
+  p.threads[std::this_thread::get_id()] = track;
+  return track;
+}
+
+void profileEnable() {
+  Profile &p = profile();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  if(!p.enabled) {
+    p.epoch = std::chrono::steady_clock::now();
+    p.enabled = true;
+    threadTrack();
+  }
+}
+
+bool profileEnabled() {
+  return profile().enabled;
+}
+
+void profileBegin(ProfileZone *zone, const char *name) {
+  zone->name = name;
+  zone->start = profile().enabled ? now() : -1;
+}
+
+void profileEnd(ProfileZone *zone) {
+  if(zone->start < 0) {
+    return;
+  }
+  ProfileEvent event;
+  event.name = zone->name;
+  event.start = zone->start;
+  event.duration = now() - zone->start;
+
+  Profile &p = profile();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  event.thread = threadTrack();
+  p.events.push_back(event);
+}
+
+void profileThreadName(const char *name) {
+  Profile &p = profile();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  p.threadNames[threadTrack()] = name;
+}
+
+// Write s as a JSON string
+static void writeString(FILE *fp, const char *s) {
+  fputc('"', fp);
+  for(; *s != '\0'; s++) {
+    unsigned char c = *s;
+    if(c == '"' || c == '\\') {
+      fprintf(fp, "\\%c", c);
+    } else if(c < 0x20) {
+      fprintf(fp, "\\u%04x", c);
+    } else {
+      fputc(c, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+bool profileWrite(const char *path) {
+  Profile &p = profile();
+  std::lock_guard<std::mutex> lock(p.mutex);
+
+  FILE *fp = fopen(path, "w");
+  if(fp == NULL) {
+    fprintf(stderr, "Can't write profile %s\n", path);
+    return false;
+  }
+  fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  // Track names first, then the zones as complete ("X") events
+  bool first = true;
+  for(std::map<int, std::string>::iterator it = p.threadNames.begin();
+    it != p.threadNames.end(); ++it) {
+    fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+      "\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", it->first);
+    writeString(fp, it->second.c_str());
+    fprintf(fp, "}}");
+    first = false;
+  }
+  for(size_t i = 0; i < p.events.size(); i++) {
+    const ProfileEvent *event = &p.events[i];
+    fprintf(fp, "%s{\"name\":", first ? "" : ",\n");
+    writeString(fp, event->name);
+    fprintf(fp, ",\"cat\":\"startup\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,"
+      "\"pid\":1,\"tid\":%d}", (long long) event->start,
+      (long long) event->duration, event->thread);
+    first = false;
+  }
+  fprintf(fp, "\n]}\n");
+  return fclose(fp) == 0;
+}
@@ -0,0 +1,48 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// Wall clock timing of named phases, written out as a Chrome trace (load it
+// in chrome://tracing or ui.perfetto.dev). Zones may nest and may be timed
+// on any thread; each thread gets its own track. GL calls only measure the
+// CPU side, the driver may finish the work later.
+//
+// Nothing is recorded until profileEnable is called, so the zones can stay
+// in place at the cost of a branch each.
+
+struct ProfileZone {
+  const char *name; // Must outlive the profile, normally a literal
+  int64_t start; // Microseconds since profileEnable, -1 when not recording
+};
+
+// Start recording, timestamps count from here
+void profileEnable();
+
+bool profileEnabled();
+
+// Time a phase between these two calls. Zones on a thread must end in the
+// reverse order they began for the trace viewer to nest them.
+void profileBegin(ProfileZone *zone, const char *name);
+void profileEnd(ProfileZone *zone);
+
+// Label the calling thread's track
+void profileThreadName(const char *name);
+
+// Write every finished zone to path as Chrome trace JSON. Returns false if
+// the file can't be written.
+bool profileWrite(const char *path);
+
+// Times the rest of the enclosing block
+struct ProfileScope {
+  ProfileZone zone;
+  ProfileScope(const char *name) { profileBegin(&zone, name); }
+  ~ProfileScope() { profileEnd(&zone); }
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name) \
+  ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+#endif
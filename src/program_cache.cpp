@@ -0,0 +1,134 @@
+#include "program_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#define makeDir(path) _mkdir(path)
+#else
+#define makeDir(path) mkdir(path, 0755)
+#endif
+
+// Bumped whenever the file layout changes
+#define PROGRAM_CACHE_MAGIC 0x31424750 // "PGB1"
+
+// File header, followed by length bytes of binary
+struct ProgramCacheHeader {
+  uint32_t magic;
+  uint32_t format;
+  uint64_t key;
+  uint32_t length;
+  uint32_t pad;
+};
+
+// 64-bit FNV-1a, continued from hash
+static uint64_t hashString(uint64_t hash, const char *s) {
+  if(s == NULL) {
+    s = "";
+  }
+  // Include the terminator so "ab" + "c" differs from "a" + "bc"
+  do {
+    hash ^= (unsigned char) *s;
+    hash *= 1099511628211ULL;
+  } while(*s++ != '\0');
+  return hash;
+}
+
+bool programCacheSupported() {
+  GLint numFormats = 0;
+  if(GLEW_ARB_get_program_binary) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  }
+  return numFormats > 0;
+}
+
+uint64_t programCacheKey(const char *vsSource, const char *fsSource) {
+  uint64_t hash = 14695981039346656037ULL;
+  hash = hashString(hash, vsSource);
+  hash = hashString(hash, fsSource);
+  hash = hashString(hash, (const char *) glGetString(GL_VENDOR));
+  hash = hashString(hash, (const char *) glGetString(GL_RENDERER));
+  hash = hashString(hash, (const char *) glGetString(GL_VERSION));
+  return hash;
+}
+
+static void cachePath(uint64_t key, char *path, size_t size) {
+  snprintf(path, size, "%s/%016llx.bin", PROGRAM_CACHE_DIR,
+    (unsigned long long) key);
+}
+
+GLuint programCacheLoad(uint64_t key) {
+  char path[256];
+  ProgramCacheHeader header;
+  cachePath(key, path, sizeof(path));
+
+  FILE *fp = fopen(path, "rb");
+  if(fp == NULL) {
+    return 0;
+  }
+  std::vector<char> binary;
+  bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+    header.magic == PROGRAM_CACHE_MAGIC && header.key == key &&
+    header.length > 0;
+  if(ok) {
+    binary.resize(header.length);
+    ok = fread(&binary[0], 1, header.length, fp) == header.length;
+  }
+  fclose(fp);
+  if(!ok) {
+    return 0;
+  }
+
+  GLuint pid = glCreateProgram();
+  glProgramBinary(pid, header.format, &binary[0], header.length);
+  return pid;
+}
+
+void programCacheStore(uint64_t key, GLuint pid) {
+  GLint length = 0;
+  glGetProgramiv(pid, GL_PROGRAM_BINARY_LENGTH, &length);
+  if(length <= 0) {
+    return;
+  }
+
+  ProgramCacheHeader header;
+  std::vector<char> binary(length);
+  GLenum format;
+  glGetProgramBinary(pid, length, NULL, &format, &binary[0]);
+  memset(&header, 0, sizeof(header));
+  header.magic = PROGRAM_CACHE_MAGIC;
+  header.format = format;
+  header.key = key;
+  header.length = length;
+
+  // Write to a temporary file and rename it into place so a crash or a
+  // second instance never sees half a binary
+  char path[256], tmpPath[272];
+  makeDir(PROGRAM_CACHE_DIR);
+  cachePath(key, path, sizeof(path));
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+  FILE *fp = fopen(tmpPath, "wb");
+  if(fp == NULL) {
+    fprintf(stderr, "Could not write program cache %s\n", tmpPath);
+    return;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+    fwrite(&binary[0], 1, length, fp) == (size_t) length;
+  ok = fclose(fp) == 0 && ok;
+  if(!ok || rename(tmpPath, path) != 0) {
+    fprintf(stderr, "Could not write program cache %s\n", path);
+    remove(tmpPath);
+  }
+}
+
+void programCacheRemove(uint64_t key) {
+  char path[256];
+  cachePath(key, path, sizeof(path));
+  remove(path);
+}
@@ -0,0 +1,43 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <stdint.h>
+
+#include "gl_include.h"
+
+// Directory cached program binaries are kept in, relative to the working
+// directory
+#define PROGRAM_CACHE_DIR "program_cache"
+
+// Linked program binaries are cached under PROGRAM_CACHE_DIR, keyed by a
+// hash of the shader sources and the GL vendor, renderer and version
+// strings, so a driver update or an edited shader misses the cache.
+//
+// The cache holds one file per program in use: when a hot reload replaces
+// a program, the shader manager removes the binary of the sources it was
+// built from. Binaries left behind by a driver update, or by shaders edited
+// while the application wasn't running, are not pruned; deleting the
+// directory is always safe.
+
+// Whether the driver can hand out and take back program binaries. Some
+// drivers expose the entry points but support no binary formats.
+bool programCacheSupported();
+
+// Cache key for a program built from these sources on this driver
+uint64_t programCacheKey(const char *vsSource, const char *fsSource);
+
+// Create a program from the binary cached for key. Returns 0 if there is
+// none. The program's GL_LINK_STATUS must still be checked, since drivers
+// may reject a binary they produced themselves (e.g. after an update that
+// kept the version string); glProgramBinary does not need to finish before
+// this returns.
+GLuint programCacheLoad(uint64_t key);
+
+// Store the binary of the linked program pid under key. The program must
+// have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+void programCacheStore(uint64_t key, GLuint pid);
+
+// Delete the binary cached for key, if any
+void programCacheRemove(uint64_t key);
+
+#endif
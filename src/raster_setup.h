@@ -0,0 +1,142 @@
+#ifndef RASTER_SETUP_H
+#define RASTER_SETUP_H
+
+#include <math.h>
+
+#include <glm/glm.hpp>
+
+// Triangle setup shared by the CPU rasterizers (soft_raster and
+// occlusion_cull), so both clip, cull and fill exactly alike: trivial
+// reject against the frustum, clipping to a plane, the viewport transform,
+// counter clockwise back face culling, pixel center bounds, edge functions
+// with the top-left rule and planes interpolating per vertex values.
+
+// Plane a(x, y) = dx * x + dy * y + c over window coordinates
+struct RasterPlane {
+  float dx, dy, c;
+};
+
+// The part of a set up triangle every rasterizer needs
+struct RasterTriangle {
+  // Edge functions, positive inside. Edge i is opposite vertex i.
+  float a[3], b[3], c[3];
+  int topLeft; // Bit per edge, pixel centers exactly on it are inside
+  int minX, minY, maxX, maxY; // Pixel bounds, clamped to the viewport
+};
+
+// Near and far planes, dot(plane, pos) >= 0 inside. x and y are left to
+// the viewport clamp.
+static const glm::vec4 rasterNearPlane(0.f, 0.f, 1.f, 1.f);
+static const glm::vec4 rasterFarPlane(0.f, 0.f, -1.f, 1.f);
+
+// Whether the clip space triangle is entirely outside one of the planes
+static inline bool rasterOutside(const glm::vec4 &p0, const glm::vec4 &p1,
+  const glm::vec4 &p2) {
+  for(int c = 0; c < 3; c++) {
+    if((p0[c] > p0.w && p1[c] > p1.w && p2[c] > p2.w) ||
+      (p0[c] < -p0.w && p1[c] < -p1.w && p2[c] < -p2.w)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Vertex access for rasterClip. A rasterizer clipping vertices with more
+// than a position defines the same two functions for its vertex type.
+static inline const glm::vec4 &rasterPosition(const glm::vec4 &v) {
+  return v;
+}
+
+static inline glm::vec4 rasterLerp(const glm::vec4 &a, const glm::vec4 &b,
+  float t) {
+  return a + (b - a) * t;
+}
+
+// Keep the part of the polygon where dot(plane, pos) >= 0 (Sutherland-
+// Hodgman). Returns the new vertex count, at most count + 1.
+template <typename Vertex>
+static int rasterClip(const Vertex *in, int count, Vertex *out,
+  const glm::vec4 &plane) {
+  int n = 0;
+  for(int i = 0; i < count; i++) {
+    const Vertex &a = in[i];
+    const Vertex &b = in[(i + 1) % count];
+    float da = glm::dot(plane, rasterPosition(a));
+    float db = glm::dot(plane, rasterPosition(b));
+    if(da >= 0.f) {
+      out[n++] = a;
+    }
+    if((da >= 0.f) != (db >= 0.f)) {
+      out[n++] = rasterLerp(a, b, da / (da - db));
+    }
+  }
+  return n;
+}
+
+// Window coordinates of a clip space position in a width x height
+// viewport: x and y in pixels, z in 0 .. 1, and 1 / w
+static inline void rasterViewport(const glm::vec4 &pos, int width,
+  int height, float *x, float *y, float *z, float *invW) {
+  *invW = 1.f / pos.w;
+  *x = (pos.x * *invW * .5f + .5f) * width;
+  *y = (pos.y * *invW * .5f + .5f) * height;
+  *z = pos.z * *invW * .5f + .5f;
+}
+
+// Back face culling, bounds and edge setup of the triangle at window
+// coordinates x, y. Returns false if it faces away or covers no pixel
+// centers, otherwise fills tri and stores 1 / its doubled area, what
+// rasterPlane takes, in *invArea.
+static inline bool rasterSetup(const float x[3], const float y[3],
+  int width, int height, RasterTriangle *tri, float *invArea) {
+  // Counter clockwise is front facing
+  float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  if(!(area > 0.f)) {
+    return false;
+  }
+
+  float minX = fminf(x[0], fminf(x[1], x[2]));
+  float maxX = fmaxf(x[0], fmaxf(x[1], x[2]));
+  float minY = fminf(y[0], fminf(y[1], y[2]));
+  float maxY = fmaxf(y[0], fmaxf(y[1], y[2]));
+  // Pixels whose centers may be covered
+  tri->minX = (int) fmaxf(ceilf(minX - .5f), 0.f);
+  tri->minY = (int) fmaxf(ceilf(minY - .5f), 0.f);
+  tri->maxX = (int) fminf(floorf(maxX - .5f), width - 1.f);
+  tri->maxY = (int) fminf(floorf(maxY - .5f), height - 1.f);
+  if(tri->minX > tri->maxX || tri->minY > tri->maxY) {
+    return false;
+  }
+
+  tri->topLeft = 0;
+  for(int i = 0; i < 3; i++) {
+    int j = (i + 1) % 3, k = (i + 2) % 3;
+    // Edge from vertex j to k, positive on the side of vertex i
+    tri->a[i] = y[j] - y[k];
+    tri->b[i] = x[k] - x[j];
+    tri->c[i] = -(tri->a[i] * x[j] + tri->b[i] * y[j]);
+    // Left edges go down, top edges go left
+    if(tri->a[i] > 0.f || (tri->a[i] == 0.f && tri->b[i] < 0.f)) {
+      tri->topLeft |= 1 << i;
+    }
+  }
+
+  *invArea = 1.f / area;
+  return true;
+}
+
+// The plane through the values f at the vertices of a triangle set up by
+// rasterSetup
+static inline RasterPlane rasterPlane(const RasterTriangle *tri,
+  const float f[3], float invArea) {
+  RasterPlane plane;
+  plane.dx = (tri->a[0] * f[0] + tri->a[1] * f[1] + tri->a[2] * f[2]) *
+    invArea;
+  plane.dy = (tri->b[0] * f[0] + tri->b[1] * f[1] + tri->b[2] * f[2]) *
+    invArea;
+  plane.c = (tri->c[0] * f[0] + tri->c[1] * f[1] + tri->c[2] * f[2]) *
+    invArea;
+  return plane;
+}
+
+#endif
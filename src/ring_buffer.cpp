@@ -0,0 +1,121 @@
+#include "ring_buffer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Nanoseconds to wait on a fence before complaining
+#define RING_FENCE_TIMEOUT 1000000000
+
+void ringBufferInit(RingBuffer *ring, GLenum target, size_t frameSize) {
+  GLint align = 1;
+
+  memset(ring, 0, sizeof(RingBuffer));
+  ring->target = target;
+  ring->persistent = GLEW_ARB_buffer_storage;
+
+  // Uniform ranges have to start on the implementation's alignment
+  if(target == GL_UNIFORM_BUFFER) {
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+  }
+  ring->align = align < 16 ? 16 : align;
+  ring->frameSize = (frameSize + ring->align - 1) / ring->align * ring->align;
+
+  glGenBuffers(1, &ring->id);
+  glBindBuffer(target, ring->id);
+
+  if(ring->persistent) {
+    // Immutable storage mapped once for the lifetime of the buffer
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+      GL_MAP_COHERENT_BIT;
+    glBufferStorage(target, ring->frameSize * RING_FRAMES, NULL, flags);
+    ring->data = (char *) glMapBufferRange(target, 0,
+      ring->frameSize * RING_FRAMES, flags);
+    if(ring->data == NULL) {
+      fprintf(stderr, "Could not persistently map ring buffer.\n");
+    }
+  } else {
+    glBufferData(target, ring->frameSize, NULL, GL_STREAM_DRAW);
+  }
+
+  glBindBuffer(target, 0);
+}
+
+void ringBufferBeginFrame(RingBuffer *ring) {
+  ring->head = 0;
+
+  if(ring->persistent) {
+    // The partition is free once the GPU passes the fence placed when it
+    // was last written
+    GLsync fence = ring->fences[ring->frame];
+    if(fence != NULL) {
+      GLenum rc = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+        RING_FENCE_TIMEOUT);
+      if(rc == GL_TIMEOUT_EXPIRED || rc == GL_WAIT_FAILED) {
+        fprintf(stderr, "Timed out waiting for ring buffer frame %d.\n",
+          ring->frame);
+      }
+      glDeleteSync(fence);
+      ring->fences[ring->frame] = NULL;
+    }
+    return;
+  }
+
+  // Orphan the old storage so the driver can hand back fresh memory without
+  // waiting on draws that still read it
+  glBindBuffer(ring->target, ring->id);
+  glBufferData(ring->target, ring->frameSize, NULL, GL_STREAM_DRAW);
+  ring->data = (char *) glMapBufferRange(ring->target, 0, ring->frameSize,
+    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  glBindBuffer(ring->target, 0);
+}
+
+void *ringBufferAlloc(RingBuffer *ring, size_t size, GLintptr *offset) {
+  size_t start = (ring->head + ring->align - 1) / ring->align * ring->align;
+
+  if(ring->data == NULL || start + size > ring->frameSize) {
+    fprintf(stderr, "Ring buffer frame is full (%lu of %lu bytes).\n",
+      (unsigned long) (start + size), (unsigned long) ring->frameSize);
+    return NULL;
+  }
+  ring->head = start + size;
+
+  if(ring->persistent) {
+    *offset = (GLintptr) (ring->frame * ring->frameSize + start);
+    return ring->data + ring->frame * ring->frameSize + start;
+  }
+  *offset = (GLintptr) start;
+  return ring->data + start;
+}
+
+void ringBufferFlush(RingBuffer *ring) {
+  // Coherent persistent mappings need no flush
+  if(ring->persistent || ring->data == NULL) {
+    return;
+  }
+  glBindBuffer(ring->target, ring->id);
+  glUnmapBuffer(ring->target);
+  glBindBuffer(ring->target, 0);
+  ring->data = NULL;
+}
+
+void ringBufferEndFrame(RingBuffer *ring) {
+  if(ring->persistent) {
+    ring->fences[ring->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ring->frame = (ring->frame + 1) % RING_FRAMES;
+  }
+}
+
+void ringBufferDestroy(RingBuffer *ring) {
+  for(int i = 0; i < RING_FRAMES; i++) {
+    if(ring->fences[i] != NULL) {
+      glDeleteSync(ring->fences[i]);
+    }
+  }
+  if(ring->persistent && ring->data != NULL) {
+    glBindBuffer(ring->target, ring->id);
+    glUnmapBuffer(ring->target);
+    glBindBuffer(ring->target, 0);
+  }
+  glDeleteBuffers(1, &ring->id);
+  memset(ring, 0, sizeof(RingBuffer));
+}
@@ -0,0 +1,55 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stddef.h>
+
+#include "gl_include.h"
+
+// Number of frames the CPU may run ahead of the GPU
+#define RING_FRAMES 3
+
+// Ring allocator for per-frame dynamic data (animated vertices, per-object
+// constants). The buffer is split into RING_FRAMES partitions; the CPU writes
+// one partition while the GPU reads the others, and a fence per partition
+// keeps the CPU from overwriting data still in flight.
+//
+// With ARB_buffer_storage the whole buffer is mapped once, persistently, and
+// writes go straight into GPU visible memory. Otherwise each frame orphans a
+// single partition sized buffer and maps it, which must be unmapped with
+// ringBufferFlush before drawing.
+struct RingBuffer {
+  GLenum target;
+  unsigned id;
+  bool persistent;
+
+  size_t frameSize; // Bytes available to each frame
+  size_t align; // Minimum offset alignment for allocations
+
+  int frame; // Partition being written
+  size_t head; // Bytes used in the current partition
+  char *data; // CPU pointer to the current partition, NULL when unmapped
+
+  GLsync fences[RING_FRAMES];
+};
+
+// Create the buffer for target with frameSize bytes per frame
+void ringBufferInit(RingBuffer *ring, GLenum target, size_t frameSize);
+
+// Wait for the GPU to release the next partition and map it for writing
+void ringBufferBeginFrame(RingBuffer *ring);
+
+// Reserve size bytes in the current partition. Returns the CPU pointer to
+// write through and stores the buffer offset to bind or draw from in
+// *offset, or returns NULL if the partition is full.
+void *ringBufferAlloc(RingBuffer *ring, size_t size, GLintptr *offset);
+
+// Make this frame's writes visible to the GPU; call before drawing
+void ringBufferFlush(RingBuffer *ring);
+
+// Fence the current partition once all draws reading it are submitted
+void ringBufferEndFrame(RingBuffer *ring);
+
+// Release the buffer and any outstanding fences
+void ringBufferDestroy(RingBuffer *ring);
+
+#endif
@@ -0,0 +1,259 @@
+#include "shader_manager.h"
+
+#include <stdio.h>
+
+#include "program_cache.h"
+#include "alloc_track.h"
+
+// Let the driver pick how many compiler threads to use
+#define SHADER_COMPILER_THREADS 0xFFFFFFFF
+
+// Same value for the KHR and ARB extensions
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+void shaderManagerInit(ShaderManager *manager, bool useCache) {
+  ALLOC_TAG(ALLOC_SHADER);
+  manager->programs.clear();
+  manager->freeSlots.clear();
+  manager->useCache = useCache && programCacheSupported();
+  manager->parallel = false;
+
+  if(GLEW_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(SHADER_COMPILER_THREADS);
+    manager->parallel = true;
+  } else if(GLEW_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(SHADER_COMPILER_THREADS);
+    manager->parallel = true;
+  }
+}
+
+static GLuint submitShader(GLenum type, const std::string &source) {
+  const char *text = source.c_str();
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &text, NULL);
+  glCompileShader(shader);
+  return shader;
+}
+
+// Issue the compiles and the link without checking anything
+static void submitCompile(ShaderManager *manager, ShaderProgram *program) {
+  program->fromCache = false;
+  program->vsHandle = submitShader(GL_VERTEX_SHADER, program->vsSource);
+  program->fsHandle = submitShader(GL_FRAGMENT_SHADER, program->fsSource);
+
+  program->pid = glCreateProgram();
+  glAttachShader(program->pid, program->vsHandle);
+  glAttachShader(program->pid, program->fsHandle);
+  // Ask the driver to keep the binary around so it can be cached
+  if(manager->useCache) {
+    glProgramParameteri(program->pid, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+      GL_TRUE);
+  }
+  glLinkProgram(program->pid);
+}
+
+int shaderManagerAdd(ShaderManager *manager, const char *vsSource,
+  const char *fsSource) {
+  ALLOC_TAG(ALLOC_SHADER);
+  ShaderProgram program;
+  program.state = SHADER_PENDING;
+  program.pid = 0;
+  program.vsHandle = program.fsHandle = 0;
+  program.fromCache = false;
+  program.cacheKey = 0;
+  program.vsSource = vsSource ? vsSource : "";
+  program.fsSource = fsSource ? fsSource : "";
+  program.replacement = -1;
+
+  if(manager->useCache) {
+    program.cacheKey = programCacheKey(vsSource, fsSource);
+    program.pid = programCacheLoad(program.cacheKey);
+    program.fromCache = program.pid != 0;
+  }
+  if(program.pid == 0) {
+    submitCompile(manager, &program);
+  }
+
+  if(!manager->freeSlots.empty()) {
+    int index = manager->freeSlots.back();
+    manager->freeSlots.pop_back();
+    manager->programs[index] = program;
+    return index;
+  }
+  manager->programs.push_back(program);
+  return (int) manager->programs.size() - 1;
+}
+
+bool shaderManagerPoll(ShaderManager *manager, int index) {
+  ALLOC_TAG(ALLOC_SHADER);
+  ShaderProgram *program = &manager->programs[index];
+  if(program->state != SHADER_PENDING) {
+    return true;
+  }
+  if(!manager->parallel) {
+    return false;
+  }
+  GLint done = GL_FALSE;
+  glGetProgramiv(program->pid, GL_COMPLETION_STATUS_KHR, &done);
+  return done == GL_TRUE;
+}
+
+// Print the info log of a shader or program that failed
+static void printLog(GLuint object, bool isProgram, const char *what) {
+  GLint length = 0;
+  if(isProgram) {
+    glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+  } else {
+    glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+  }
+  std::vector<char> log(length > 0 ? length : 1, '\0');
+  if(length > 0) {
+    if(isProgram) {
+      glGetProgramInfoLog(object, length, NULL, &log[0]);
+    } else {
+      glGetShaderInfoLog(object, length, NULL, &log[0]);
+    }
+  }
+  fprintf(stderr, "Error %s\n%s\n", what, &log[0]);
+}
+
+// Report why a program failed, starting with the shaders that didn't compile
+static void printFailure(ShaderProgram *program) {
+  GLint rc;
+  bool compiled = true;
+  glGetShaderiv(program->vsHandle, GL_COMPILE_STATUS, &rc);
+  if(!rc) {
+    printLog(program->vsHandle, false, "compiling vertex shader");
+    compiled = false;
+  }
+  glGetShaderiv(program->fsHandle, GL_COMPILE_STATUS, &rc);
+  if(!rc) {
+    printLog(program->fsHandle, false, "compiling fragment shader");
+    compiled = false;
+  }
+  if(compiled) {
+    printLog(program->pid, true, "linking shaders");
+  }
+}
+
+static void releaseShaders(ShaderProgram *program) {
+  if(program->vsHandle == 0) {
+    return;
+  }
+  // The program keeps what it needs
+  glDetachShader(program->pid, program->vsHandle);
+  glDetachShader(program->pid, program->fsHandle);
+  glDeleteShader(program->vsHandle);
+  glDeleteShader(program->fsHandle);
+  program->vsHandle = program->fsHandle = 0;
+}
+
+GLuint shaderManagerGet(ShaderManager *manager, int index) {
+  ALLOC_TAG(ALLOC_SHADER);
+  ShaderProgram *program = &manager->programs[index];
+  if(program->state != SHADER_PENDING) {
+    return program->state == SHADER_READY ? program->pid : 0;
+  }
+
+  // First status query, this is where the driver is waited on
+  GLint rc;
+  glGetProgramiv(program->pid, GL_LINK_STATUS, &rc);
+
+  // Drivers may reject binaries they made themselves (e.g. after an update
+  // that kept the version string), compile after all
+  if(!rc && program->fromCache) {
+    glDeleteProgram(program->pid);
+    submitCompile(manager, program);
+    glGetProgramiv(program->pid, GL_LINK_STATUS, &rc);
+  }
+
+  if(!rc) {
+    printFailure(program);
+    releaseShaders(program);
+    glDeleteProgram(program->pid);
+    program->pid = 0;
+    program->state = SHADER_FAILED;
+    return 0;
+  }
+
+  releaseShaders(program);
+  if(manager->useCache && !program->fromCache) {
+    programCacheStore(program->cacheKey, program->pid);
+  }
+  program->state = SHADER_READY;
+  return program->pid;
+}
+
+// Delete a program that is no longer referenced and free its slot. Later
+// slots keep their indices, so other handles stay valid.
+static void removeProgram(ShaderManager *manager, int index) {
+  ShaderProgram *program = &manager->programs[index];
+  releaseShaders(program);
+  if(program->pid != 0) {
+    glDeleteProgram(program->pid);
+  }
+  program->pid = 0;
+  program->state = SHADER_FREE;
+  program->replacement = -1;
+  std::string().swap(program->vsSource);
+  std::string().swap(program->fsSource);
+  manager->freeSlots.push_back(index);
+}
+
+void shaderManagerReload(ShaderManager *manager, int index,
+  const char *vsSource, const char *fsSource) {
+  ALLOC_TAG(ALLOC_SHADER);
+  // Sources edited again before the last rebuild got used
+  if(manager->programs[index].replacement >= 0) {
+    removeProgram(manager, manager->programs[index].replacement);
+  }
+  int replacement = shaderManagerAdd(manager, vsSource, fsSource);
+  manager->programs[index].replacement = replacement;
+}
+
+bool shaderManagerSwap(ShaderManager *manager, int index) {
+  int replacement = manager->programs[index].replacement;
+  if(replacement < 0) {
+    return false;
+  }
+  if(manager->parallel && !shaderManagerPoll(manager, replacement)) {
+    return false;
+  }
+
+  manager->programs[index].replacement = -1;
+  if(shaderManagerGet(manager, replacement) == 0) {
+    fprintf(stderr, "Shader reload failed, keeping the last good program\n");
+    removeProgram(manager, replacement);
+    return false;
+  }
+
+  // Trade places so the index keeps naming the program in use, then drop the
+  // old one
+  ShaderProgram *program = &manager->programs[index];
+  ShaderProgram *rebuilt = &manager->programs[replacement];
+  GLuint oldPid = program->pid;
+  uint64_t oldKey = program->cacheKey;
+  *program = *rebuilt;
+  rebuilt->pid = oldPid;
+  removeProgram(manager, replacement);
+  // The old sources are gone from disk, so is their binary; otherwise every
+  // save while hot reloading would leave one behind for good
+  if(manager->useCache && oldKey != program->cacheKey) {
+    programCacheRemove(oldKey);
+  }
+  return true;
+}
+
+void shaderManagerDestroy(ShaderManager *manager) {
+  for(size_t i = 0; i < manager->programs.size(); i++) {
+    ShaderProgram *program = &manager->programs[i];
+    releaseShaders(program);
+    if(program->pid != 0) {
+      glDeleteProgram(program->pid);
+    }
+  }
+  manager->programs.clear();
+  manager->freeSlots.clear();
+}
@@ -0,0 +1,83 @@
+#ifndef SHADER_MANAGER_H
+#define SHADER_MANAGER_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "gl_include.h"
+
+// Builds shader programs without making the CPU wait on the driver.
+// shaderManagerAdd issues every compile and the link back to back without
+// querying any status, so the driver can work on them (on its own threads
+// with KHR_parallel_shader_compile) while the application goes on loading
+// meshes and textures. Status is only checked when the program is first
+// needed, in shaderManagerGet.
+
+enum ShaderState {
+  SHADER_PENDING, // Submitted, status not checked yet
+  SHADER_READY,
+  SHADER_FAILED,
+  SHADER_FREE // Slot of a dropped rebuild, reused by the next add
+};
+
+struct ShaderProgram {
+  ShaderState state;
+  GLuint pid;
+  // Compiling shaders, 0 once the program is finished or when it came from
+  // the binary cache
+  GLuint vsHandle, fsHandle;
+  bool fromCache;
+  uint64_t cacheKey;
+  // Kept to compile after all if the driver rejects a cached binary
+  std::string vsSource, fsSource;
+  // Index of a rebuild from shaderManagerReload waiting to take over, -1 if
+  // there is none
+  int replacement;
+};
+
+struct ShaderManager {
+  // Indexed by the handles the calls take. Slots are never erased, so
+  // handles stay valid; dropped ones go on freeSlots.
+  std::vector<ShaderProgram> programs;
+  std::vector<int> freeSlots;
+  bool useCache; // Program binary cache, see program_cache.h
+  bool parallel; // Completion can be polled without waiting
+};
+
+// Set up the manager. With useCache linked programs are loaded from and
+// stored to the program binary cache when the driver supports it.
+void shaderManagerInit(ShaderManager *manager, bool useCache);
+
+// Submit the compiles and the link of a program. Returns its index for the
+// other calls; nothing is checked yet.
+int shaderManagerAdd(ShaderManager *manager, const char *vsSource,
+  const char *fsSource);
+
+// Whether the program is finished building. Never waits: without
+// KHR_parallel_shader_compile this only turns true once shaderManagerGet
+// has been called.
+bool shaderManagerPoll(ShaderManager *manager, int program);
+
+// Finish building the program, waiting for the driver if needed, and return
+// it. Returns 0 if it failed to compile or link, after printing the info
+// log.
+GLuint shaderManagerGet(ShaderManager *manager, int program);
+
+// Start rebuilding a program from new sources. The current program stays in
+// use until shaderManagerSwap finds the rebuild finished; calling this again
+// before that drops the previous rebuild.
+void shaderManagerReload(ShaderManager *manager, int program,
+  const char *vsSource, const char *fsSource);
+
+// Meant for frame boundaries: if a rebuild of the program is finished, put it
+// in place of the old one and return true. A rebuild that fails to compile or
+// link is dropped with its log printed, keeping the last good program. Only
+// waits on the driver when it can't be polled (no parallel compile).
+bool shaderManagerSwap(ShaderManager *manager, int program);
+
+// Delete every program
+void shaderManagerDestroy(ShaderManager *manager);
+
+#endif
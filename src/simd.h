@@ -0,0 +1,100 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// One float per lane vectors for the CPU passes (texture_sampler,
+// mesh_soa). Build with -mavx (USE_AVX in CMake) to run 8 lanes at a time,
+// otherwise SSE2 runs 4, and plain floats 1 without either.
+//
+// vload and vstore take any address, vloadAligned and vstoreAligned one
+// aligned to SIMD_LANES floats. Masks from vless have every bit of a lane
+// set for true, in every build.
+#if defined(__AVX__)
+#  include <immintrin.h>
+#  define SIMD_LANES 8
+typedef __m256 vfloat;
+static inline vfloat vset1(float a) { return _mm256_set1_ps(a); }
+static inline vfloat vload(const float *p) { return _mm256_loadu_ps(p); }
+static inline void vstore(float *p, vfloat a) { _mm256_storeu_ps(p, a); }
+static inline vfloat vloadAligned(const float *p) { return _mm256_load_ps(p); }
+static inline void vstoreAligned(float *p, vfloat a) {
+  _mm256_store_ps(p, a);
+}
+static inline vfloat vadd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+static inline vfloat vsub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+static inline vfloat vmul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+static inline vfloat vdiv(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+// NaN in a gives b, so clamps also clean up bad values
+static inline vfloat vmax(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+static inline vfloat vmin(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+static inline vfloat vfloor(vfloat a) { return _mm256_floor_ps(a); }
+static inline vfloat vless(vfloat a, vfloat b) {
+  return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+}
+static inline vfloat vselect(vfloat mask, vfloat a, vfloat b) {
+  return _mm256_blendv_ps(b, a, mask);
+}
+static inline void vstoreInt(int *p, vfloat a) {
+  _mm256_storeu_si256((__m256i *) p, _mm256_cvttps_epi32(a));
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#  define SIMD_LANES 4
+typedef __m128 vfloat;
+static inline vfloat vset1(float a) { return _mm_set1_ps(a); }
+static inline vfloat vload(const float *p) { return _mm_loadu_ps(p); }
+static inline void vstore(float *p, vfloat a) { _mm_storeu_ps(p, a); }
+static inline vfloat vloadAligned(const float *p) { return _mm_load_ps(p); }
+static inline void vstoreAligned(float *p, vfloat a) { _mm_store_ps(p, a); }
+static inline vfloat vadd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+static inline vfloat vsub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+static inline vfloat vmul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+static inline vfloat vdiv(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+// NaN in a gives b, so clamps also clean up bad values
+static inline vfloat vmax(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+static inline vfloat vmin(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+static inline vfloat vfloor(vfloat a) {
+  // Truncate, then step down where that rounded up (negative fractions)
+  vfloat t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+  return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.f)));
+}
+static inline vfloat vless(vfloat a, vfloat b) { return _mm_cmplt_ps(a, b); }
+static inline vfloat vselect(vfloat mask, vfloat a, vfloat b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+static inline void vstoreInt(int *p, vfloat a) {
+  _mm_storeu_si128((__m128i *) p, _mm_cvttps_epi32(a));
+}
+#else
+#  define SIMD_LANES 1
+typedef float vfloat;
+static inline vfloat vset1(float a) { return a; }
+static inline vfloat vload(const float *p) { return *p; }
+static inline void vstore(float *p, vfloat a) { *p = a; }
+static inline vfloat vloadAligned(const float *p) { return *p; }
+static inline void vstoreAligned(float *p, vfloat a) { *p = a; }
+static inline vfloat vadd(vfloat a, vfloat b) { return a + b; }
+static inline vfloat vsub(vfloat a, vfloat b) { return a - b; }
+static inline vfloat vmul(vfloat a, vfloat b) { return a * b; }
+static inline vfloat vdiv(vfloat a, vfloat b) { return a / b; }
+static inline vfloat vmax(vfloat a, vfloat b) { return a > b ? a : b; }
+static inline vfloat vmin(vfloat a, vfloat b) { return a < b ? a : b; }
+static inline vfloat vfloor(vfloat a) { return floorf(a); }
+static inline vfloat vless(vfloat a, vfloat b) {
+  uint32_t bits = a < b ? 0xFFFFFFFFu : 0;
+  vfloat mask;
+  memcpy(&mask, &bits, sizeof(mask));
+  return mask;
+}
+static inline vfloat vselect(vfloat mask, vfloat a, vfloat b) {
+  uint32_t bits;
+  memcpy(&bits, &mask, sizeof(bits));
+  return bits ? a : b;
+}
+static inline void vstoreInt(int *p, vfloat a) { *p = (int) a; }
+#endif
+
+#endif
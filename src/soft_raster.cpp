@@ -0,0 +1,415 @@
+#include "soft_raster.h"
+#include "job_pool.h"
+#include "raster_setup.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#  define RASTER_SIMD 1
+#else
+#  define RASTER_SIMD 0
+#endif
+
+// Setup jobs per thread, so uneven jobs still spread out
+#define SETUP_JOBS_PER_THREAD 4
+
+// A vertex in clip space
+struct ClipVertex {
+  glm::vec4 pos;
+  float u, v;
+};
+
+// A triangle ready to rasterize
+struct SoftTriangle : RasterTriangle {
+  RasterPlane z; // Window depth
+  RasterPlane invW, uw, vw; // 1 / w and texture coordinates over w
+};
+
+struct SoftState {
+  JobPool pool;
+
+  int tilesX, tilesY;
+
+  // Scratch for the draw in progress, kept so steady state draws don't
+  // allocate
+  const SoftDraw *draw;
+  std::vector<ClipVertex> clip; // Per instance, per vertex
+  int transformJobs, setupJobs;
+  std::vector<std::vector<SoftTriangle> > triangles; // Per setup job
+  std::vector<std::vector<unsigned> > bins; // Per setup job, per tile
+};
+
+// Vertex shader for a range of instances
+static void transformJob(void *context, int index) {
+  SoftRasterizer *raster = (SoftRasterizer *) context;
+  SoftState *s = raster->state;
+  const SoftDraw *draw = s->draw;
+  size_t begin, end;
+  jobRange(draw->instanceCount, s->transformJobs, index, &begin, &end);
+
+  for(size_t i = begin; i < end; i++) {
+    unsigned instance = draw->visible ? draw->visible[i] : (unsigned) i;
+    glm::mat4 m = draw->viewProj * draw->instances[instance];
+    ClipVertex *out = &s->clip[i * draw->vertexCount];
+    for(size_t v = 0; v < draw->vertexCount; v++) {
+      const float *p = &draw->positions[3 * v];
+      out[v].pos = m * glm::vec4(p[0], p[1], p[2], 1.f);
+      out[v].u = draw->texCoords[2 * v];
+      out[v].v = draw->texCoords[2 * v + 1];
+    }
+  }
+}
+
+// Vertex access for rasterClip
+static inline const glm::vec4 &rasterPosition(const ClipVertex &v) {
+  return v.pos;
+}
+
+static inline ClipVertex rasterLerp(const ClipVertex &a, const ClipVertex &b,
+  float t) {
+  ClipVertex out;
+  out.pos = a.pos + (b.pos - a.pos) * t;
+  out.u = a.u + (b.u - a.u) * t;
+  out.v = a.v + (b.v - a.v) * t;
+  return out;
+}
+
+// Viewport transform, culling and edge setup of a clipped triangle. Returns
+// false if nothing of it can be drawn.
+static bool setupTriangle(SoftRasterizer *raster, const ClipVertex *v0,
+  const ClipVertex *v1, const ClipVertex *v2, SoftTriangle *tri) {
+  const ClipVertex *v[3] = {v0, v1, v2};
+  float x[3], y[3], z[3], invW[3], uw[3], vw[3];
+  for(int i = 0; i < 3; i++) {
+    rasterViewport(v[i]->pos, raster->width, raster->height, &x[i], &y[i],
+      &z[i], &invW[i]);
+    uw[i] = v[i]->u * invW[i];
+    vw[i] = v[i]->v * invW[i];
+  }
+
+  float invArea;
+  if(!rasterSetup(x, y, raster->width, raster->height, tri, &invArea)) {
+    return false;
+  }
+  tri->z = rasterPlane(tri, z, invArea);
+  tri->invW = rasterPlane(tri, invW, invArea);
+  tri->uw = rasterPlane(tri, uw, invArea);
+  tri->vw = rasterPlane(tri, vw, invArea);
+  return true;
+}
+
+// Set up a range of triangles (over every instance) and bin them by tile.
+// Each job writes only its own lists, and rasterization walks the jobs in
+// order, so triangles reach every pixel in submission order.
+static void setupJob(void *context, int index) {
+  SoftRasterizer *raster = (SoftRasterizer *) context;
+  SoftState *s = raster->state;
+  const SoftDraw *draw = s->draw;
+  std::vector<SoftTriangle> &triangles = s->triangles[index];
+  std::vector<unsigned> *bins = &s->bins[index * s->tilesX * s->tilesY];
+  triangles.clear();
+  for(int t = 0; t < s->tilesX * s->tilesY; t++) {
+    bins[t].clear();
+  }
+
+  size_t perInstance = draw->indexCount / 3;
+  size_t begin, end;
+  jobRange(draw->instanceCount * perInstance, s->setupJobs, index, &begin,
+    &end);
+
+  for(size_t n = begin; n < end; n++) {
+    const ClipVertex *verts = &s->clip[n / perInstance * draw->vertexCount];
+    const unsigned *ids = &draw->indices[n % perInstance * 3];
+    ClipVertex polygon[3] = {
+      verts[ids[0]], verts[ids[1]], verts[ids[2]]
+    };
+
+    if(rasterOutside(polygon[0].pos, polygon[1].pos, polygon[2].pos)) {
+      continue;
+    }
+
+    // Clip against near and far only when needed, a triangle becomes at
+    // most a pentagon
+    ClipVertex clipped[5], scratch[5];
+    const ClipVertex *poly = polygon;
+    int count = 3;
+    bool crosses = false;
+    for(int i = 0; i < 3; i++) {
+      crosses = crosses || polygon[i].pos.z < -polygon[i].pos.w ||
+        polygon[i].pos.z > polygon[i].pos.w;
+    }
+    if(crosses) {
+      count = rasterClip(polygon, 3, scratch, rasterNearPlane);
+      count = rasterClip(scratch, count, clipped, rasterFarPlane);
+      poly = clipped;
+    }
+
+    for(int i = 1; i + 1 < count; i++) {
+      SoftTriangle tri;
+      if(!setupTriangle(raster, &poly[0], &poly[i], &poly[i + 1], &tri)) {
+        continue;
+      }
+      unsigned id = (unsigned) triangles.size();
+      triangles.push_back(tri);
+      for(int ty = tri.minY / SOFT_TILE_SIZE;
+        ty <= tri.maxY / SOFT_TILE_SIZE; ty++) {
+        for(int tx = tri.minX / SOFT_TILE_SIZE;
+          tx <= tri.maxX / SOFT_TILE_SIZE; tx++) {
+          bins[ty * s->tilesX + tx].push_back(id);
+        }
+      }
+    }
+  }
+}
+
+#if !RASTER_SIMD
+// Same order of operations as the SSE path, so both round alike
+static float evalPlane(const RasterPlane &plane, float x, float y) {
+  return plane.dx * x + (plane.dy * y + plane.c);
+}
+#endif
+
+// Coverage and depth test of the 4 pixels at (x .. x + 3, y), limited to
+// columns [x0, x1]. Writes the depth of the pixels that pass, their
+// perspective correct texture coordinates and w, and returns a bit per
+// pixel that passed.
+static int shadeQuad(const SoftTriangle *tri, int x, int y, int x0, int x1,
+  float *depth, float *u, float *v, float *w) {
+  float py = y + .5f;
+#if RASTER_SIMD
+  __m128 lane = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+  __m128 column = _mm_add_ps(_mm_set1_ps((float) x), lane);
+  __m128 px = _mm_add_ps(column, _mm_set1_ps(.5f));
+  __m128 zero = _mm_setzero_ps();
+
+  __m128 inside = _mm_and_ps(_mm_cmpge_ps(column, _mm_set1_ps((float) x0)),
+    _mm_cmple_ps(column, _mm_set1_ps((float) x1)));
+  for(int e = 0; e < 3; e++) {
+    __m128 edge = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->a[e]), px),
+      _mm_set1_ps(tri->b[e] * py + tri->c[e]));
+    inside = _mm_and_ps(inside, (tri->topLeft & (1 << e)) ?
+      _mm_cmpge_ps(edge, zero) : _mm_cmpgt_ps(edge, zero));
+  }
+  if(_mm_movemask_ps(inside) == 0) {
+    return 0;
+  }
+
+  __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->z.dx), px),
+    _mm_set1_ps(tri->z.dy * py + tri->z.c));
+  __m128 stored = _mm_loadu_ps(depth);
+  inside = _mm_and_ps(inside, _mm_cmplt_ps(z, stored));
+  int mask = _mm_movemask_ps(inside);
+  if(mask == 0) {
+    return 0;
+  }
+  _mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(inside, z),
+    _mm_andnot_ps(inside, stored)));
+
+  // Interpolate over w linearly in screen space, then divide by 1 / w
+  __m128 invW = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->invW.dx), px),
+    _mm_set1_ps(tri->invW.dy * py + tri->invW.c));
+  __m128 uw = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->uw.dx), px),
+    _mm_set1_ps(tri->uw.dy * py + tri->uw.c));
+  __m128 vw = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->vw.dx), px),
+    _mm_set1_ps(tri->vw.dy * py + tri->vw.c));
+  __m128 rcp = _mm_div_ps(_mm_set1_ps(1.f), invW);
+  _mm_storeu_ps(u, _mm_mul_ps(uw, rcp));
+  _mm_storeu_ps(v, _mm_mul_ps(vw, rcp));
+  _mm_storeu_ps(w, rcp);
+  return mask;
+#else
+  int mask = 0;
+  for(int i = 0; i < 4; i++) {
+    int column = x + i;
+    float px = column + .5f;
+    if(column < x0 || column > x1) {
+      continue;
+    }
+    bool inside = true;
+    for(int e = 0; e < 3 && inside; e++) {
+      float edge = tri->a[e] * px + (tri->b[e] * py + tri->c[e]);
+      inside = (tri->topLeft & (1 << e)) ? edge >= 0.f : edge > 0.f;
+    }
+    float z = evalPlane(tri->z, px, py);
+    if(!inside || !(z < depth[i])) {
+      continue;
+    }
+    depth[i] = z;
+    w[i] = 1.f / evalPlane(tri->invW, px, py);
+    u[i] = evalPlane(tri->uw, px, py) * w[i];
+    v[i] = evalPlane(tri->vw, px, py) * w[i];
+    mask |= 1 << i;
+  }
+  return mask;
+#endif
+}
+
+static void rasterTriangle(SoftRasterizer *raster, const SoftTriangle *tri,
+  const SoftDraw *draw, int tileX, int tileY) {
+  int x0 = tri->minX > tileX ? tri->minX : tileX;
+  int y0 = tri->minY > tileY ? tri->minY : tileY;
+  int x1 = tri->maxX < tileX + SOFT_TILE_SIZE - 1 ?
+    tri->maxX : tileX + SOFT_TILE_SIZE - 1;
+  int y1 = tri->maxY < tileY + SOFT_TILE_SIZE - 1 ?
+    tri->maxY : tileY + SOFT_TILE_SIZE - 1;
+
+  float u[4], v[4], w[4], lod[4];
+  float dudx[4], dvdx[4], dudy[4], dvdy[4];
+  uint32_t color[4];
+  for(int y = y0; y <= y1; y++) {
+    uint32_t *colorRow = &raster->color[(size_t) y * raster->stride];
+    float *depthRow = &raster->depth[(size_t) y * raster->stride];
+    // Quads stay aligned to 4 columns, the rows are padded to whole tiles
+    for(int x = x0 & ~3; x <= x1; x += 4) {
+      int mask = shadeQuad(tri, x, y, x0, x1, &depthRow[x], u, v, w);
+      if(mask == 0) {
+        continue;
+      }
+      // Derivatives of u = (u / w) / (1 / w) along x and y
+      for(int i = 0; i < 4; i++) {
+        dudx[i] = (tri->uw.dx - u[i] * tri->invW.dx) * w[i];
+        dvdx[i] = (tri->vw.dx - v[i] * tri->invW.dx) * w[i];
+        dudy[i] = (tri->uw.dy - u[i] * tri->invW.dy) * w[i];
+        dvdy[i] = (tri->vw.dy - v[i] * tri->invW.dy) * w[i];
+      }
+      samplerLod(draw->texture, dudx, dvdx, dudy, dvdy, 4, lod);
+      samplerSample8(draw->texture, draw->sampler, u, v, lod, 4, color);
+      for(int i = 0; mask != 0; i++, mask >>= 1) {
+        if(mask & 1) {
+          colorRow[x + i] = color[i];
+        }
+      }
+    }
+  }
+}
+
+// Draw every triangle binned to a tile, in submission order
+static void rasterJob(void *context, int tile) {
+  SoftRasterizer *raster = (SoftRasterizer *) context;
+  SoftState *s = raster->state;
+  int tileX = tile % s->tilesX * SOFT_TILE_SIZE;
+  int tileY = tile / s->tilesX * SOFT_TILE_SIZE;
+  int numTiles = s->tilesX * s->tilesY;
+  for(int job = 0; job < s->setupJobs; job++) {
+    const std::vector<unsigned> &bin = s->bins[job * numTiles + tile];
+    const SoftTriangle *triangles = s->triangles[job].empty() ?
+      NULL : &s->triangles[job][0];
+    for(size_t i = 0; i < bin.size(); i++) {
+      rasterTriangle(raster, &triangles[bin[i]], s->draw, tileX, tileY);
+    }
+  }
+}
+
+void softRasterInit(SoftRasterizer *raster, int width, int height,
+  int threads) {
+  SoftState *s = new SoftState();
+  raster->state = s;
+  raster->width = width;
+  raster->height = height;
+  s->tilesX = (width + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+  s->tilesY = (height + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+  raster->stride = s->tilesX * SOFT_TILE_SIZE;
+  size_t pixels = (size_t) raster->stride * s->tilesY * SOFT_TILE_SIZE;
+  raster->color = (uint32_t *) malloc(pixels * sizeof(uint32_t));
+  raster->depth = (float *) malloc(pixels * sizeof(float));
+
+  jobPoolInit(&s->pool, threads);
+  s->draw = NULL;
+  s->transformJobs = 0;
+  s->setupJobs = s->pool.threads * SETUP_JOBS_PER_THREAD;
+  s->triangles.resize(s->setupJobs);
+  s->bins.resize(s->setupJobs * s->tilesX * s->tilesY);
+}
+
+void softRasterClear(SoftRasterizer *raster, float r, float g, float b,
+  float a) {
+  uint32_t color =
+    (uint32_t) (r * 255.f + .5f) | (uint32_t) (g * 255.f + .5f) << 8 |
+    (uint32_t) (b * 255.f + .5f) << 16 | (uint32_t) (a * 255.f + .5f) << 24;
+  size_t pixels = (size_t) raster->stride * raster->state->tilesY *
+    SOFT_TILE_SIZE;
+  for(size_t i = 0; i < pixels; i++) {
+    raster->color[i] = color;
+    raster->depth[i] = 1.f;
+  }
+}
+
+void softRasterDraw(SoftRasterizer *raster, const SoftDraw *draw) {
+  SoftState *s = raster->state;
+  if(draw->instanceCount == 0 || draw->indexCount < 3) {
+    return;
+  }
+  s->draw = draw;
+
+  // Vertex shader
+  s->clip.resize(draw->instanceCount * draw->vertexCount);
+  int threads = s->pool.threads;
+  s->transformJobs = draw->instanceCount < (size_t) threads * 4 ?
+    (int) draw->instanceCount : threads * 4;
+  jobPoolRun(&s->pool, transformJob, raster, s->transformJobs);
+
+  // Clip, set up and bin
+  jobPoolRun(&s->pool, setupJob, raster, s->setupJobs);
+
+  // Rasterize and shade, one tile per job
+  jobPoolRun(&s->pool, rasterJob, raster, s->tilesX * s->tilesY);
+  s->draw = NULL;
+}
+
+bool softRasterWriteBmp(const SoftRasterizer *raster, const char *path) {
+  FILE *fp = fopen(path, "wb");
+  if(fp == NULL) {
+    fprintf(stderr, "Can't write %s\n", path);
+    return false;
+  }
+  // Rows are padded to 4 bytes
+  int rowSize = (raster->width * 3 + 3) & ~3;
+  uint32_t dataSize = (uint32_t) rowSize * raster->height;
+  unsigned char header[54] = {'B', 'M'};
+  uint32_t fields[][2] = {
+    {2, 54 + dataSize}, // File size
+    {10, 54}, // Offset of the pixels
+    {14, 40}, // Info header size
+    {18, (uint32_t) raster->width},
+    {22, (uint32_t) raster->height},
+    {26, 1 | (24 << 16)}, // Planes, bits per pixel
+    {34, dataSize}
+  };
+  for(size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+    for(int b = 0; b < 4; b++) {
+      header[fields[i][0] + b] = (unsigned char) (fields[i][1] >> (8 * b));
+    }
+  }
+  bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+
+  // Both are stored bottom row first, bmp wants bgr
+  std::vector<unsigned char> row(rowSize, 0);
+  for(int y = 0; ok && y < raster->height; y++) {
+    const uint32_t *colorRow = &raster->color[(size_t) y * raster->stride];
+    for(int x = 0; x < raster->width; x++) {
+      row[3 * x] = (unsigned char) (colorRow[x] >> 16);
+      row[3 * x + 1] = (unsigned char) (colorRow[x] >> 8);
+      row[3 * x + 2] = (unsigned char) colorRow[x];
+    }
+    ok = fwrite(&row[0], rowSize, 1, fp) == 1;
+  }
+  return fclose(fp) == 0 && ok;
+}
+
+void softRasterDestroy(SoftRasterizer *raster) {
+  SoftState *s = raster->state;
+  if(s != NULL) {
+    jobPoolDestroy(&s->pool);
+    delete s;
+  }
+  free(raster->color);
+  free(raster->depth);
+  raster->color = NULL;
+  raster->depth = NULL;
+  raster->state = NULL;
+}
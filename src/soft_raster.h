@@ -0,0 +1,74 @@
+#ifndef SOFT_RASTER_H
+#define SOFT_RASTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#include "texture_sampler.h"
+
+// CPU stand-in for the GL pipeline render() drives, for hosts without a GPU.
+// Takes the same inputs as the instanced draw (positions, texture
+// coordinates, indices, the Camera block matrices and the placements of the
+// visible instances) and does what vertexShader.glsl and
+// fragmentShader.glsl do with them: clip space position
+// perspective * placement * instancePlacement * vertPos, color sampled from
+// the texture with perspective correct texture coordinates (see
+// texture_sampler.h, the level of detail comes from each pixel's exact
+// derivatives rather than differences across a 2x2 quad). Fixed function
+// state matches init(): depth test GL_LESS, back faces culled with counter
+// clockwise fronts. The texture is opaque so blending leaves the color
+// unchanged.
+//
+// Triangles are transformed and set up in parallel, binned into
+// SOFT_TILE_SIZE square screen tiles, then each tile is rasterized by one
+// thread, so no two threads touch the same pixels. Edge functions and
+// interpolation run 4 pixels at a time with SSE.
+
+#define SOFT_TILE_SIZE 64
+
+// One instanced draw
+struct SoftDraw {
+  const float *positions; // xyz per vertex
+  const float *texCoords; // uv per vertex
+  size_t vertexCount;
+  const unsigned *indices; // Triangles
+  size_t indexCount;
+  glm::mat4 viewProj; // Camera perspective * placement
+  const glm::mat4 *instances;
+  const unsigned *visible; // Instances to draw, NULL draws the first count
+  size_t instanceCount;
+  const MipChain *texture;
+  const Sampler *sampler;
+};
+
+struct SoftState;
+
+// Color and depth buffers, rows from bottom to top like the default
+// framebuffer. color holds RGBA8 (r in the lowest byte).
+struct SoftRasterizer {
+  int width, height;
+  int stride; // Pixels per row, padded to whole tiles
+  uint32_t *color;
+  float *depth;
+  SoftState *state; // Worker threads and per-draw scratch
+};
+
+// Create width x height buffers and threads - 1 workers (the calling thread
+// works too). threads 0 uses every hardware thread.
+void softRasterInit(SoftRasterizer *raster, int width, int height,
+  int threads);
+
+// Like glClear of both buffers, depth is cleared to 1
+void softRasterClear(SoftRasterizer *raster, float r, float g, float b,
+  float a);
+
+void softRasterDraw(SoftRasterizer *raster, const SoftDraw *draw);
+
+// Save the color buffer as a 24 bit bmp (the format imageLoad reads)
+bool softRasterWriteBmp(const SoftRasterizer *raster, const char *path);
+
+void softRasterDestroy(SoftRasterizer *raster);
+
+#endif
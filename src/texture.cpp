@@ -0,0 +1,34 @@
+#include "texture.h"
+
+#include "profiler.h"
+#include "alloc_track.h"
+
+GLuint textureCreate(const Image *image) {
+  ALLOC_TAG(ALLOC_TEXTURE);
+  GLuint texID;
+  // Generate texture buffer object
+  glGenTextures(1, &texID);
+  // Bind current texture unit to texture buffer object as a GL_TEXTURE_2D
+  glBindTexture(GL_TEXTURE_2D, texID);
+  // Load texture data into texID
+  // Base level is 0, number of channels is 3, and border is 0
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image->sizeX, image->sizeY,
+    0, GL_RGB, GL_UNSIGNED_BYTE, (GLubyte *) image->data);
+
+  // Generate image pyramid
+  ProfileZone zone;
+  profileBegin(&zone, "mipmap generation");
+  glGenerateMipmap(GL_TEXTURE_2D);
+  profileEnd(&zone);
+  // Set texture wrap modes for S and T directions
+  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  // Set filtering mode for magnification and minification
+  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+    GL_LINEAR_MIPMAP_LINEAR);
+
+  // Unbind from texture buffer object from current texture unit
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return texID;
+}
@@ -0,0 +1,12 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include "gl_include.h"
+#include "image.h"
+
+// Upload image as a mipmapped GL_TEXTURE_2D, trilinear filtered and clamped
+// to the edges, and return its name. Leaves no texture bound on the active
+// unit; the caller still owns image->data.
+GLuint textureCreate(const Image *image);
+
+#endif
@@ -0,0 +1,304 @@
+#include "texture_sampler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc_track.h"
+#include "simd.h"
+
+// Texel fetches stay scalar (no gathers before AVX2), the wrap, weight and
+// blend math is what gets vectorized, SIMD_LANES points at a time.
+
+// Where each lane of a batch samples from
+struct LevelBatch {
+  int level[SIMD_LANES];
+  float linear[SIMD_LANES]; // Mask, bilinear instead of nearest
+};
+
+void samplerDefault(Sampler *sampler) {
+  sampler->minFilter = SAMPLER_LINEAR_MIPMAP_LINEAR;
+  sampler->magFilter = SAMPLER_LINEAR;
+  sampler->wrapS = SAMPLER_CLAMP_TO_EDGE;
+  sampler->wrapT = SAMPLER_CLAMP_TO_EDGE;
+  sampler->lodBias = 0.f;
+}
+
+void mipChainInit(MipChain *chain, int width, int height,
+  const unsigned char *rgb) {
+  ALLOC_TAG(ALLOC_TEXTURE);
+  // Lay the levels out back to back
+  size_t total = 0;
+  int w = width, h = height;
+  chain->levels = 0;
+  while(chain->levels < MIP_MAX_LEVELS) {
+    MipLevel *level = &chain->level[chain->levels++];
+    level->width = w;
+    level->height = h;
+    level->offset = total;
+    total += (size_t) w * h;
+    if(w == 1 && h == 1) {
+      break;
+    }
+    w = w > 1 ? w / 2 : 1;
+    h = h > 1 ? h / 2 : 1;
+  }
+  chain->texels = (uint32_t *) malloc(total * sizeof(uint32_t));
+
+  for(size_t i = 0; i < (size_t) width * height; i++) {
+    chain->texels[i] = rgb[3 * i] | rgb[3 * i + 1] << 8 |
+      rgb[3 * i + 2] << 16 | 0xFF000000u;
+  }
+
+  // Average 2x2 blocks of the level above, odd edges reuse their last
+  // row or column
+  for(int l = 1; l < chain->levels; l++) {
+    const MipLevel *src = &chain->level[l - 1];
+    const MipLevel *dst = &chain->level[l];
+    const uint32_t *in = &chain->texels[src->offset];
+    uint32_t *out = &chain->texels[dst->offset];
+    for(int y = 0; y < dst->height; y++) {
+      int y0 = 2 * y < src->height ? 2 * y : src->height - 1;
+      int y1 = 2 * y + 1 < src->height ? 2 * y + 1 : src->height - 1;
+      for(int x = 0; x < dst->width; x++) {
+        int x0 = 2 * x < src->width ? 2 * x : src->width - 1;
+        int x1 = 2 * x + 1 < src->width ? 2 * x + 1 : src->width - 1;
+        uint32_t t[4] = {
+          in[y0 * src->width + x0], in[y0 * src->width + x1],
+          in[y1 * src->width + x0], in[y1 * src->width + x1]
+        };
+        uint32_t texel = 0;
+        for(int c = 0; c < 32; c += 8) {
+          uint32_t sum = (t[0] >> c & 0xFF) + (t[1] >> c & 0xFF) +
+            (t[2] >> c & 0xFF) + (t[3] >> c & 0xFF);
+          texel |= (sum + 2) / 4 << c;
+        }
+        out[y * dst->width + x] = texel;
+      }
+    }
+  }
+}
+
+void mipChainFree(MipChain *chain) {
+  free(chain->texels);
+  chain->texels = NULL;
+  chain->levels = 0;
+}
+
+void samplerLod(const MipChain *chain, const float *dudx, const float *dvdx,
+  const float *dudy, const float *dvdy, size_t count, float *lod) {
+  vfloat width = vset1((float) chain->level[0].width);
+  vfloat height = vset1((float) chain->level[0].height);
+  float rho2[SIMD_LANES];
+  for(size_t i = 0; i < count; i += SIMD_LANES) {
+    size_t n = count - i < SIMD_LANES ? count - i : SIMD_LANES;
+    float in[4][SIMD_LANES] = {{0}};
+    memcpy(in[0], dudx + i, n * sizeof(float));
+    memcpy(in[1], dvdx + i, n * sizeof(float));
+    memcpy(in[2], dudy + i, n * sizeof(float));
+    memcpy(in[3], dvdy + i, n * sizeof(float));
+
+    // Squared length of the footprint along x and along y, in texels
+    vfloat ux = vmul(vload(in[0]), width), vx = vmul(vload(in[1]), height);
+    vfloat uy = vmul(vload(in[2]), width), vy = vmul(vload(in[3]), height);
+    vfloat lengthX = vadd(vmul(ux, ux), vmul(vx, vx));
+    vfloat lengthY = vadd(vmul(uy, uy), vmul(vy, vy));
+    vstore(rho2, vmax(lengthX, lengthY));
+
+    // log2(rho) = log2(rho^2) / 2
+    for(size_t l = 0; l < n; l++) {
+      lod[i + l] = .5f * log2f(rho2[l]);
+    }
+  }
+}
+
+// Pick the level(s) for each lane from its lod, following the GL rules:
+// magnify at or below c, then the mipmap mode picks one level or two to
+// blend by the fraction.
+static void selectLevels(const MipChain *chain, const Sampler *sampler,
+  const float *lod, LevelBatch *first, LevelBatch *second, float *blend,
+  bool *trilinear) {
+  SamplerFilter min = sampler->minFilter;
+  float c = sampler->magFilter == SAMPLER_LINEAR &&
+    (min == SAMPLER_NEAREST_MIPMAP_NEAREST ||
+     min == SAMPLER_NEAREST_MIPMAP_LINEAR) ? .5f : 0.f;
+  int last = chain->levels - 1;
+  float allOnes;
+  uint32_t ones = 0xFFFFFFFFu;
+  memcpy(&allOnes, &ones, sizeof(allOnes));
+
+  *trilinear = false;
+  for(int l = 0; l < SIMD_LANES; l++) {
+    float lambda = (lod ? lod[l] : 0.f) + sampler->lodBias;
+    first->level[l] = second->level[l] = 0;
+    blend[l] = 0.f;
+
+    // NaN counts as magnification
+    SamplerFilter filter = lambda > c ? min : sampler->magFilter;
+    if(filter == SAMPLER_NEAREST_MIPMAP_NEAREST ||
+      filter == SAMPLER_LINEAR_MIPMAP_NEAREST) {
+      int d = lambda <= .5f ? 0 : (int) ceilf(lambda + .5f) - 1;
+      first->level[l] = d < last ? d : last;
+    } else if(filter == SAMPLER_NEAREST_MIPMAP_LINEAR ||
+      filter == SAMPLER_LINEAR_MIPMAP_LINEAR) {
+      if(lambda >= last) {
+        first->level[l] = last;
+      } else {
+        int d = (int) floorf(lambda);
+        first->level[l] = d;
+        second->level[l] = d + 1;
+        blend[l] = lambda - d;
+        *trilinear = *trilinear || blend[l] > 0.f;
+      }
+    }
+    bool linear = filter == SAMPLER_LINEAR ||
+      filter == SAMPLER_LINEAR_MIPMAP_NEAREST ||
+      filter == SAMPLER_LINEAR_MIPMAP_LINEAR;
+    first->linear[l] = second->linear[l] = linear ? allOnes : 0.f;
+  }
+}
+
+// Texel index i (a whole number) wrapped into [0, size)
+static vfloat wrapIndex(vfloat i, vfloat size, SamplerWrap wrap) {
+  if(wrap == SAMPLER_REPEAT) {
+    i = vsub(i, vmul(vfloor(vdiv(i, size)), size));
+  } else if(wrap == SAMPLER_MIRRORED_REPEAT) {
+    vfloat period = vadd(size, size);
+    vfloat m = vsub(i, vmul(vfloor(vdiv(i, period)), period));
+    i = vselect(vless(m, size), m, vsub(vsub(period, vset1(1.f)), m));
+  }
+  // Also catches rounding at the ends of the periods, and sends NaN to
+  // texel 0 instead of reading wild
+  return vmin(vmax(i, vset1(0.f)), vsub(size, vset1(1.f)));
+}
+
+// Nearest or bilinear sample of one level per lane, channels in 0..255
+static void sampleLevels(const MipChain *chain, const Sampler *sampler,
+  const LevelBatch *batch, const float *u, const float *v,
+  float out[4][SIMD_LANES]) {
+  float widths[SIMD_LANES], heights[SIMD_LANES];
+  for(int l = 0; l < SIMD_LANES; l++) {
+    widths[l] = (float) chain->level[batch->level[l]].width;
+    heights[l] = (float) chain->level[batch->level[l]].height;
+  }
+  vfloat width = vload(widths), height = vload(heights);
+  vfloat linear = vload(batch->linear);
+
+  // Texel space, bilinear samples around the texel centers
+  vfloat half = vselect(linear, vset1(.5f), vset1(0.f));
+  vfloat x = vsub(vmul(vload(u), width), half);
+  vfloat y = vsub(vmul(vload(v), height), half);
+  vfloat x0 = vfloor(x), y0 = vfloor(y);
+  vfloat zero = vset1(0.f);
+  vfloat wx = vselect(linear, vsub(x, x0), zero);
+  vfloat wy = vselect(linear, vsub(y, y0), zero);
+  vfloat one = vset1(1.f);
+  int ix[2][SIMD_LANES], iy[2][SIMD_LANES];
+  vstoreInt(ix[0], wrapIndex(x0, width, sampler->wrapS));
+  vstoreInt(ix[1], wrapIndex(vadd(x0, one), width, sampler->wrapS));
+  vstoreInt(iy[0], wrapIndex(y0, height, sampler->wrapT));
+  vstoreInt(iy[1], wrapIndex(vadd(y0, one), height, sampler->wrapT));
+
+  // Fetch the 2x2 footprint of every lane
+  float texel[4][4][SIMD_LANES];
+  for(int l = 0; l < SIMD_LANES; l++) {
+    const MipLevel *level = &chain->level[batch->level[l]];
+    const uint32_t *texels = &chain->texels[level->offset];
+    for(int corner = 0; corner < 4; corner++) {
+      uint32_t t = texels[iy[corner >> 1][l] * level->width +
+        ix[corner & 1][l]];
+      for(int c = 0; c < 4; c++) {
+        texel[corner][c][l] = (float) (t >> (8 * c) & 0xFF);
+      }
+    }
+  }
+
+  // Blend along x, then y
+  wx = vmax(vmin(wx, one), zero);
+  wy = vmax(vmin(wy, one), zero);
+  for(int c = 0; c < 4; c++) {
+    vfloat t00 = vload(texel[0][c]), t10 = vload(texel[1][c]);
+    vfloat t01 = vload(texel[2][c]), t11 = vload(texel[3][c]);
+    vfloat bottom = vadd(t00, vmul(vsub(t10, t00), wx));
+    vfloat top = vadd(t01, vmul(vsub(t11, t01), wx));
+    vstore(out[c], vadd(bottom, vmul(vsub(top, bottom), wy)));
+  }
+}
+
+// Sample up to SIMD_LANES points, channels in 0..255
+static void sampleBatch(const MipChain *chain, const Sampler *sampler,
+  const float *u, const float *v, const float *lod,
+  float out[4][SIMD_LANES]) {
+  LevelBatch first, second;
+  float blend[SIMD_LANES];
+  bool trilinear;
+  selectLevels(chain, sampler, lod, &first, &second, blend, &trilinear);
+
+  sampleLevels(chain, sampler, &first, u, v, out);
+  if(!trilinear) {
+    return;
+  }
+  float next[4][SIMD_LANES];
+  sampleLevels(chain, sampler, &second, u, v, next);
+  vfloat weight = vload(blend);
+  for(int c = 0; c < 4; c++) {
+    vfloat a = vload(out[c]);
+    vstore(out[c], vadd(a, vmul(vsub(vload(next[c]), a), weight)));
+  }
+}
+
+// Run sampleBatch over count points, padding the last batch
+template <typename Store>
+static void sampleAll(const MipChain *chain, const Sampler *sampler,
+  const float *u, const float *v, const float *lod, size_t count,
+  Store store) {
+  for(size_t i = 0; i < count; i += SIMD_LANES) {
+    size_t n = count - i < SIMD_LANES ? count - i : SIMD_LANES;
+    float bu[SIMD_LANES] = {0}, bv[SIMD_LANES] = {0};
+    float blod[SIMD_LANES] = {0};
+    memcpy(bu, u + i, n * sizeof(float));
+    memcpy(bv, v + i, n * sizeof(float));
+    if(lod != NULL) {
+      memcpy(blod, lod + i, n * sizeof(float));
+    }
+    float out[4][SIMD_LANES];
+    sampleBatch(chain, sampler, bu, bv, lod ? blod : NULL, out);
+    for(size_t l = 0; l < n; l++) {
+      store(i + l, out, l);
+    }
+  }
+}
+
+struct StoreFloat {
+  float *rgba;
+  void operator()(size_t i, float out[4][SIMD_LANES], size_t l) const {
+    for(int c = 0; c < 4; c++) {
+      rgba[4 * i + c] = out[c][l] * (1.f / 255.f);
+    }
+  }
+};
+
+struct StoreRGBA8 {
+  uint32_t *rgba;
+  void operator()(size_t i, float out[4][SIMD_LANES], size_t l) const {
+    uint32_t color = 0;
+    for(int c = 0; c < 4; c++) {
+      color |= (uint32_t) (out[c][l] + .5f) << (8 * c);
+    }
+    rgba[i] = color;
+  }
+};
+
+void samplerSample(const MipChain *chain, const Sampler *sampler,
+  const float *u, const float *v, const float *lod, size_t count,
+  float *rgba) {
+  StoreFloat store = {rgba};
+  sampleAll(chain, sampler, u, v, lod, count, store);
+}
+
+void samplerSample8(const MipChain *chain, const Sampler *sampler,
+  const float *u, const float *v, const float *lod, size_t count,
+  uint32_t *rgba) {
+  StoreRGBA8 store = {rgba};
+  sampleAll(chain, sampler, u, v, lod, count, store);
+}
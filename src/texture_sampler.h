@@ -0,0 +1,78 @@
+#ifndef TEXTURE_SAMPLER_H
+#define TEXTURE_SAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CPU texture sampling that follows the GL rules for the filter and wrap
+// modes init() sets up (and the rest of them), for software rendering,
+// baking and checking GPU output. Points are sampled in batches: the
+// coordinate math runs 8 points at a time with AVX (USE_AVX), 4 with SSE2.
+
+// Enough levels for a 65536 texel wide texture
+#define MIP_MAX_LEVELS 17
+
+enum SamplerFilter {
+  SAMPLER_NEAREST,
+  SAMPLER_LINEAR,
+  // Minification only
+  SAMPLER_NEAREST_MIPMAP_NEAREST,
+  SAMPLER_LINEAR_MIPMAP_NEAREST,
+  SAMPLER_NEAREST_MIPMAP_LINEAR,
+  SAMPLER_LINEAR_MIPMAP_LINEAR
+};
+
+enum SamplerWrap {
+  SAMPLER_CLAMP_TO_EDGE,
+  SAMPLER_REPEAT,
+  SAMPLER_MIRRORED_REPEAT
+};
+
+struct Sampler {
+  SamplerFilter minFilter, magFilter;
+  SamplerWrap wrapS, wrapT;
+  float lodBias;
+};
+
+struct MipLevel {
+  int width, height;
+  size_t offset; // Of the level's first texel in MipChain::texels
+};
+
+// A texture and its mipmaps, every level RGBA8 (r in the lowest byte) with
+// rows from bottom to top like glTexImage2D takes them
+struct MipChain {
+  int levels;
+  MipLevel level[MIP_MAX_LEVELS];
+  uint32_t *texels;
+};
+
+// The sampler state init() gives the GL texture: GL_LINEAR magnification,
+// GL_LINEAR_MIPMAP_LINEAR minification, GL_CLAMP_TO_EDGE both ways
+void samplerDefault(Sampler *sampler);
+
+// Build the chain down to 1x1 from width x height RGB8 pixels (the data of
+// an Image), each level a 2x2 box filter of the one above like
+// glGenerateMipmap
+void mipChainInit(MipChain *chain, int width, int height,
+  const unsigned char *rgb);
+
+void mipChainFree(MipChain *chain);
+
+// Level of detail of count points from the derivatives of their texture
+// coordinates along screen x and y (before the sampler's bias)
+void samplerLod(const MipChain *chain, const float *dudx, const float *dvdx,
+  const float *dudy, const float *dvdy, size_t count, float *lod);
+
+// Sample count points at (u[i], v[i]). lod may be NULL for 0 everywhere.
+// Writes 4 floats per point (r, g, b, a in 0..1) to rgba.
+void samplerSample(const MipChain *chain, const Sampler *sampler,
+  const float *u, const float *v, const float *lod, size_t count,
+  float *rgba);
+
+// Same, writing RGBA8 (r in the lowest byte)
+void samplerSample8(const MipChain *chain, const Sampler *sampler,
+  const float *u, const float *v, const float *lod, size_t count,
+  uint32_t *rgba);
+
+#endif
@@ -145,8 +145,10 @@ void LoadMtl(std::map<std::string, int> &material_map, // [output]
 #include <map>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #include "tiny_obj_loader.h"
+#include "arena.h"
 
 namespace tinyobj {
 
@@ -173,6 +175,33 @@ static inline bool operator<(const vertex_index &a, const vertex_index &b) {
   return false;
 }
 
+// The vertex cache is only needed until its group is flattened into a
+// shape; its nodes come from an arena released in one go at the end of
+// LoadObj instead of a malloc and free per vertex
+#define TINYOBJ_ARENA_BLOCK_SIZE (16 * 1024)
+
+typedef std::map<vertex_index, unsigned int, std::less<vertex_index>,
+                 ArenaAllocator<std::pair<const vertex_index, unsigned int> > >
+    vertex_cache_t;
+
+// Faces of the current group, flat: face i is
+// indices[offsets[i] .. offsets[i + 1]). Clearing keeps the capacity, so
+// after the first group faces are parsed without allocating.
+struct face_group {
+  std::vector<vertex_index> indices;
+  std::vector<size_t> offsets; // One per face plus the end, starts at 0
+
+  face_group() : offsets(1, 0) {}
+  bool empty() const { return offsets.size() == 1; }
+  size_t size() const { return offsets.size() - 1; }
+  void clear() {
+    indices.clear();
+    offsets.resize(1);
+  }
+  // Close the face made of the indices pushed since the last one
+  void endFace() { offsets.push_back(indices.size()); }
+};
+
 struct obj_shape {
   std::vector<float> v;
   std::vector<float> vn;
@@ -414,13 +443,13 @@ static vertex_index parseTriple(const char *&token, int vsize, int vnsize,
 }
 
 static unsigned int
-updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
+updateVertex(vertex_cache_t &vertexCache,
              std::vector<float> &positions, std::vector<float> &normals,
              std::vector<float> &texcoords,
              const std::vector<float> &in_positions,
              const std::vector<float> &in_normals,
              const std::vector<float> &in_texcoords, const vertex_index &i) {
-  const std::map<vertex_index, unsigned int>::iterator it = vertexCache.find(i);
+  const vertex_cache_t::iterator it = vertexCache.find(i);
 
   if (it != vertexCache.end()) {
     // found cache
@@ -474,11 +503,11 @@ static void InitMaterial(material_t &material) {
 }
 
 static bool exportFaceGroupToShape(
-    shape_t &shape, std::map<vertex_index, unsigned int> vertexCache,
+    shape_t &shape, vertex_cache_t &vertexCache,
     const std::vector<float> &in_positions,
     const std::vector<float> &in_normals,
     const std::vector<float> &in_texcoords,
-    const std::vector<std::vector<vertex_index> > &faceGroup,
+    const face_group &faceGroup,
     const int material_id, const std::string &name, bool clearCache) {
   if (faceGroup.empty()) {
     return false;
@@ -486,14 +515,17 @@ static bool exportFaceGroupToShape(
 
   // Flatten vertices and indices
   for (size_t i = 0; i < faceGroup.size(); i++) {
-    const std::vector<vertex_index> &face = faceGroup[i];
+    size_t npolys = faceGroup.offsets[i + 1] - faceGroup.offsets[i];
+    if (npolys < 3) {
+      continue; // Points and lines have no triangles
+    }
+    // Only now is indices known to be non empty
+    const vertex_index *face = &faceGroup.indices[faceGroup.offsets[i]];
 
     vertex_index i0 = face[0];
     vertex_index i1(-1);
     vertex_index i2 = face[1];
 
-    size_t npolys = face.size();
-
     // Polygon -> triangle fan conversion
     for (size_t k = 2; k < npolys; k++) {
       i1 = i2;
@@ -807,34 +839,33 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
              std::istream &inStream, MaterialReader &readMatFn) {
   std::stringstream errss;
 
+  // Before everything allocating from it
+  ArenaScope scratch(TINYOBJ_ARENA_BLOCK_SIZE);
+  ArenaAllocator<vertex_index> alloc(&scratch.arena);
+
   std::vector<float> v;
   std::vector<float> vn;
   std::vector<float> vt;
-  std::vector<std::vector<vertex_index> > faceGroup;
+  face_group faceGroup;
   std::string name;
 
   // material
   std::map<std::string, int> material_map;
-  std::map<vertex_index, unsigned int> vertexCache;
+  vertex_cache_t vertexCache(std::less<vertex_index>(), alloc);
   int material = -1;
 
   shape_t shape;
 
-  int maxchars = 8192;             // Alloc enough size.
-  std::vector<char> buf(static_cast<size_t>(maxchars)); // Alloc enough size.
+  // Reused for every line, so it only allocates to grow to the longest
+  // one (and lines of any length load, big n-gons included)
+  std::string linebuf;
   while (inStream.peek() != -1) {
-    inStream.getline(&buf[0], maxchars);
-
-    std::string linebuf(&buf[0]);
+    std::getline(inStream, linebuf);
 
-    // Trim newline '\r\n' or '\n'
-    if (linebuf.size() > 0) {
-      if (linebuf[linebuf.size() - 1] == '\n')
-        linebuf.erase(linebuf.size() - 1);
-    }
+    // Trim newline '\r\n' ('\n' is dropped by getline)
     if (linebuf.size() > 0) {
       if (linebuf[linebuf.size() - 1] == '\r')
-        linebuf.erase(linebuf.size() - 1);
+        linebuf.resize(linebuf.size() - 1);
     }
 
     // Skip if empty line.
@@ -890,16 +921,14 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
       token += 2;
       token += strspn(token, " \t");
 
-      std::vector<vertex_index> face;
       while (!isNewLine(token[0])) {
         vertex_index vi =
             parseTriple(token, static_cast<int>(v.size() / 3), static_cast<int>(vn.size() / 3), static_cast<int>(vt.size() / 2));
-        face.push_back(vi);
+        faceGroup.indices.push_back(vi);
         size_t n = strspn(token, " \t\r");
         token += n;
       }
-
-      faceGroup.push_back(face);
+      faceGroup.endFace();
 
       continue;
     }
@@ -919,7 +948,8 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
       bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
                                         faceGroup, material, name, true);
       if (ret) {
-          shapes.push_back(shape);
+          shapes.push_back(shape_t());
+          std::swap(shapes.back(), shape);
       }
       shape = shape_t();
       faceGroup.clear();
@@ -963,7 +993,8 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
       bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
                                         faceGroup, material, name, true);
       if (ret) {
-        shapes.push_back(shape);
+        shapes.push_back(shape_t());
+        std::swap(shapes.back(), shape);
       }
 
       shape = shape_t();
@@ -997,7 +1028,8 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
       bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
                                         faceGroup, material, name, true);
       if (ret) {
-        shapes.push_back(shape);
+        shapes.push_back(shape_t());
+        std::swap(shapes.back(), shape);
       }
 
       // material = -1;
@@ -1023,7 +1055,8 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
   bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt, faceGroup,
                                     material, name, true);
   if (ret) {
-    shapes.push_back(shape);
+    shapes.push_back(shape_t());
+    std::swap(shapes.back(), shape);
   }
   faceGroup.clear(); // for safety
 
@@ -0,0 +1,88 @@
+// Generates meshes and images far larger than the shipped resources, to test
+// loading and rendering at production scale (see tools/synthetic_assets.h).
+//
+// usage: asset_gen obj FILE [-sphere | -grid] [-triangles N] [-quads]
+//                           [-groups N] [-materials N] [-negative]
+//        asset_gen bmp FILE WIDTH HEIGHT [-bpp 8|24|32]
+//
+// OBJ files have positions, texture coordinates and normals. -quads writes
+// quads (and n-gon caps on the sphere) for the loader to triangulate,
+// -groups splits the faces over that many "g" sections, -materials cycles
+// that many materials over the groups (written to a .mtl next to FILE) and
+// -negative uses relative indices. e.g.
+//
+//   asset_gen obj big_sphere.obj -triangles 8000000 -groups 64 -materials 8
+//   asset_gen bmp big.bmp 16384 16384
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "synthetic_assets.h"
+
+static int usage() {
+  fprintf(stderr,
+    "usage: asset_gen obj FILE [-sphere | -grid] [-triangles N] [-quads]\n"
+    "                          [-groups N] [-materials N] [-negative]\n"
+    "       asset_gen bmp FILE WIDTH HEIGHT [-bpp 8|24|32]\n");
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  if(argc < 3) {
+    return usage();
+  }
+  const char *path = argv[2];
+
+  if(strcmp(argv[1], "obj") == 0) {
+    SyntheticObj params;
+    syntheticObjDefault(&params);
+    for(int i = 3; i < argc; i++) {
+      if(strcmp(argv[i], "-sphere") == 0) {
+        params.shape = SYNTHETIC_SPHERE;
+      } else if(strcmp(argv[i], "-grid") == 0) {
+        params.shape = SYNTHETIC_GRID;
+      } else if(strcmp(argv[i], "-triangles") == 0 && i + 1 < argc) {
+        params.triangles = (size_t) strtoull(argv[++i], NULL, 10);
+      } else if(strcmp(argv[i], "-quads") == 0) {
+        params.quads = true;
+      } else if(strcmp(argv[i], "-groups") == 0 && i + 1 < argc) {
+        params.groups = atoi(argv[++i]);
+        if(params.groups < 1) {
+          params.groups = 1;
+        }
+      } else if(strcmp(argv[i], "-materials") == 0 && i + 1 < argc) {
+        params.materials = atoi(argv[++i]);
+        if(params.materials < 0) {
+          params.materials = 0;
+        }
+      } else if(strcmp(argv[i], "-negative") == 0) {
+        params.negativeIndices = true;
+      } else {
+        return usage();
+      }
+    }
+    if(!writeSyntheticObj(path, &params)) {
+      return 1;
+    }
+  } else if(strcmp(argv[1], "bmp") == 0 && argc >= 5) {
+    int width = atoi(argv[3]);
+    int height = atoi(argv[4]);
+    int bitsPerPixel = 24;
+    for(int i = 5; i < argc; i++) {
+      if(strcmp(argv[i], "-bpp") == 0 && i + 1 < argc) {
+        bitsPerPixel = atoi(argv[++i]);
+      } else {
+        return usage();
+      }
+    }
+    if(!writeSyntheticBmp(path, width, height, bitsPerPixel)) {
+      return 1;
+    }
+  } else {
+    return usage();
+  }
+
+  printf("Wrote %s\n", path);
+  return 0;
+}
@@ -0,0 +1,192 @@
+// Packs assets into one archive for the renderer to map at startup (see
+// src/asset_archive.h for the layout).
+//
+// usage: asset_pack [-lz4] ARCHIVE NAME...
+//
+// Each NAME is a path relative to the directory ARCHIVE goes in, and is
+// stored under that name, e.g.
+//
+//   asset_pack ../resources/assets.pak world.bmp cube.obj vertexShader.glsl
+//
+// With -lz4 (needs USE_LZ4) entries are compressed when that makes them
+// smaller.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "asset_archive.h"
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+// An input file and where it goes
+struct Input {
+  std::string name;
+  std::vector<char> data;
+  ArchiveEntry entry;
+};
+
+static bool byName(const Input &a, const Input &b) {
+  return a.name < b.name;
+}
+
+static bool readFile(const std::string &path, std::vector<char> *data) {
+  FILE *fp = fopen(path.c_str(), "rb");
+  if(fp == NULL) {
+    return false;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  rewind(fp);
+  data->resize(size > 0 ? size : 0);
+  bool ok = size >= 0 &&
+    (size == 0 || fread(&(*data)[0], size, 1, fp) == 1);
+  fclose(fp);
+  return ok;
+}
+
+// Replace the data with its LZ4 block if that is smaller
+static void compress(Input *input) {
+#ifdef USE_LZ4
+  int size = (int) input->data.size();
+  if(size == 0) {
+    return;
+  }
+  std::vector<char> packed(LZ4_compressBound(size));
+  int packedSize = LZ4_compress_HC(&input->data[0], &packed[0], size,
+    (int) packed.size(), LZ4HC_CLEVEL_MAX);
+  if(packedSize > 0 && packedSize < size) {
+    packed.resize(packedSize);
+    input->data.swap(packed);
+    input->entry.flags |= ARCHIVE_LZ4;
+  }
+#else
+  (void) input;
+#endif
+}
+
+static size_t alignUp(size_t offset) {
+  return (offset + ARCHIVE_ALIGN - 1) / ARCHIVE_ALIGN * ARCHIVE_ALIGN;
+}
+
+int main(int argc, char **argv) {
+  bool lz4 = false;
+  int first = 1;
+  if(first < argc && strcmp(argv[first], "-lz4") == 0) {
+    lz4 = true;
+    first++;
+  }
+  if(argc - first < 2) {
+    fprintf(stderr, "usage: asset_pack [-lz4] ARCHIVE NAME...\n");
+    return 1;
+  }
+#ifndef USE_LZ4
+  if(lz4) {
+    fprintf(stderr, "Built without USE_LZ4, storing uncompressed\n");
+    lz4 = false;
+  }
+#endif
+
+  std::string archivePath = argv[first];
+  std::string root;
+  size_t slash = archivePath.find_last_of("/\\");
+  if(slash != std::string::npos) {
+    root = archivePath.substr(0, slash + 1);
+  }
+
+  std::vector<Input> inputs(argc - first - 1);
+  for(size_t i = 0; i < inputs.size(); i++) {
+    Input *input = &inputs[i];
+    input->name = argv[first + 1 + i];
+    if(input->name.size() >= ARCHIVE_NAME_MAX) {
+      fprintf(stderr, "Name too long: %s\n", input->name.c_str());
+      return 1;
+    }
+    if(!readFile(root + input->name, &input->data)) {
+      fprintf(stderr, "Can't read %s\n", (root + input->name).c_str());
+      return 1;
+    }
+    memset(&input->entry, 0, sizeof(input->entry));
+    strcpy(input->entry.name, input->name.c_str());
+    input->entry.size = input->data.size();
+    if(lz4) {
+      compress(input);
+    }
+    input->entry.storedSize = input->data.size();
+  }
+
+  // The reader binary searches the table of contents
+  std::sort(inputs.begin(), inputs.end(), byName);
+  for(size_t i = 1; i < inputs.size(); i++) {
+    if(inputs[i].name == inputs[i - 1].name) {
+      fprintf(stderr, "%s given twice\n", inputs[i].name.c_str());
+      return 1;
+    }
+  }
+
+  // Lay the data out after the table, each entry on its own page
+  size_t offset = sizeof(ArchiveHeader) + inputs.size() * sizeof(ArchiveEntry);
+  for(size_t i = 0; i < inputs.size(); i++) {
+    offset = alignUp(offset);
+    inputs[i].entry.offset = offset;
+    offset += inputs[i].data.size();
+  }
+
+  // Written next to the archive and renamed over it so a running renderer
+  // never maps a half written file
+  std::string tmpPath = archivePath + ".tmp";
+  FILE *fp = fopen(tmpPath.c_str(), "wb");
+  if(fp == NULL) {
+    fprintf(stderr, "Can't write %s\n", tmpPath.c_str());
+    return 1;
+  }
+  ArchiveHeader header;
+  header.magic = ARCHIVE_MAGIC;
+  header.version = ARCHIVE_VERSION;
+  header.count = (uint32_t) inputs.size();
+  header.pad = 0;
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+  for(size_t i = 0; ok && i < inputs.size(); i++) {
+    ok = fwrite(&inputs[i].entry, sizeof(ArchiveEntry), 1, fp) == 1;
+  }
+  size_t written = sizeof(ArchiveHeader) +
+    inputs.size() * sizeof(ArchiveEntry);
+  static const char zeros[ARCHIVE_ALIGN] = {0};
+  for(size_t i = 0; ok && i < inputs.size(); i++) {
+    size_t padding = inputs[i].entry.offset - written;
+    ok = padding == 0 || fwrite(zeros, padding, 1, fp) == 1;
+    if(ok && !inputs[i].data.empty()) {
+      ok = fwrite(&inputs[i].data[0], inputs[i].data.size(), 1, fp) == 1;
+    }
+    written = inputs[i].entry.offset + inputs[i].data.size();
+  }
+  ok = fclose(fp) == 0 && ok;
+#ifdef _WIN32
+  // rename does not replace an existing file there
+  remove(archivePath.c_str());
+#endif
+  if(!ok || rename(tmpPath.c_str(), archivePath.c_str()) != 0) {
+    fprintf(stderr, "Error writing %s\n", archivePath.c_str());
+    remove(tmpPath.c_str());
+    return 1;
+  }
+
+  for(size_t i = 0; i < inputs.size(); i++) {
+    const ArchiveEntry *entry = &inputs[i].entry;
+    printf("%-32s %10llu bytes", entry->name, (unsigned long long) entry->size);
+    if(entry->flags & ARCHIVE_LZ4) {
+      printf(" -> %llu (lz4)", (unsigned long long) entry->storedSize);
+    }
+    printf("\n");
+  }
+  printf("Wrote %s, %llu bytes\n", archivePath.c_str(),
+    (unsigned long long) written);
+  return 0;
+}
@@ -0,0 +1,145 @@
+// Regenerates src/glee_error_docs.hpp, the offline copy of the OpenGL
+// reference page error descriptions that glee.hpp reports on failure.
+//
+// usage: glee_docgen [page ...] > src/glee_error_docs.hpp
+//
+// With no arguments every page already in the table is fetched again.
+// Requires a network connection; see GLEE_NETWORKING in glee.hpp.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// The documentation types only exist with the wrappers enabled, and the
+// network fetch is the whole point of this tool
+#define GLEE_OVERWRITE_GL_FUNCTIONS
+#define GLEE_NETWORKING
+#include "glee.hpp"
+
+// Write s as a C string literal
+static void printLiteral(const std::string &s) {
+  putchar('"');
+  for(size_t i = 0; i < s.length(); i++) {
+    if(s[i] == '\n') {
+      printf("\\n");
+      continue;
+    }
+    if(s[i] == '"' || s[i] == '\\') {
+      putchar('\\');
+    }
+    putchar(s[i]);
+  }
+  putchar('"');
+}
+
+// Write one OpenGLErrorDoc field as one literal piece per description,
+// separated by '\n'
+static void printField(const std::vector<std::string> &strings, bool last) {
+  printf("                ");
+  if(strings.empty()) {
+    printf("\"\"");
+  }
+  for(size_t i = 0; i < strings.size(); i++) {
+    if(i > 0) {
+      printf("\n                ");
+    }
+    printLiteral(i + 1 < strings.size() ? strings[i] + "\n" : strings[i]);
+  }
+  printf(last ? "\n" : ",\n");
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> pages;
+  std::vector<glee_api::OpenGLAdditionalErrorInfo> docs;
+
+  // Pages to fetch
+  for(int i = 1; i < argc; i++) {
+    pages.push_back(argv[i]);
+  }
+  if(pages.empty()) {
+    for(int i = 0; i < glee_api::ErrorDocCount(); i++) {
+      pages.push_back(glee_api::ErrorDocs()[i].functionName);
+    }
+  }
+  std::sort(pages.begin(), pages.end());
+  pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+  for(size_t i = 0; i < pages.size(); i++) {
+    glee_api::OpenGLAdditionalErrorInfo info =
+      glee_api::RequestOpenGLAPIErrorInfoForFunction(pages[i]);
+    if(info.url.empty()) {
+      fprintf(stderr, "Skipping %s, no reference page found.\n",
+        pages[i].c_str());
+      continue;
+    }
+    docs.push_back(info);
+  }
+
+  printf("////////////////////////////////////////////////////////////////////////////////\n");
+  printf("///\n");
+  printf("///  glee_error_docs.hpp\n");
+  printf("///  (Automatically generated by glee_docgen)\n");
+  printf("///\n");
+  printf("///  Offline copy of the Errors section of the OpenGL reference pages,\n");
+  printf("/// included inside glee_api by glee.hpp. Do not edit by hand; regenerate\n");
+  printf("/// it with\n");
+  printf("///\n");
+  printf("///      glee_docgen > src/glee_error_docs.hpp\n");
+  printf("///\n");
+  printf("/// which fetches every page listed below again, or pass page names to\n");
+  printf("/// fetch a different set.\n");
+  printf("///\n\n");
+
+  printf("    /// The number of pages in ErrorDocs().\n");
+  printf("    static int\n");
+  printf("    ErrorDocCount()\n");
+  printf("    {\n");
+  printf("        return %d;\n", (int) docs.size());
+  printf("    }\n\n");
+
+  printf("    /// Every documented page, sorted by name.\n");
+  printf("    static const OpenGLErrorDoc *\n");
+  printf("    ErrorDocs()\n");
+  printf("    {\n");
+  printf("        static const OpenGLErrorDoc __docs[] = {\n");
+  for(size_t i = 0; i < docs.size(); i++) {
+    const glee_api::OpenGLAdditionalErrorInfo &doc = docs[i];
+    printf("            {\n");
+    printf("                ");
+    printLiteral(doc.functionName);
+    printf(",\n                ");
+    printLiteral(doc.url);
+    printf(",\n");
+    printField(doc.invalidEnum(), false);
+    printField(doc.invalidValue(), false);
+    printField(doc.invalidOperation(), false);
+    printField(doc.invalidFramebufferOperation(), false);
+    printField(doc.outOfMemory(), false);
+    printField(doc.errorNotes, true);
+    printf(i + 1 < docs.size() ? "            },\n" : "            }\n");
+  }
+  printf("        };\n");
+  printf("        return __docs;\n");
+  printf("    }\n\n");
+
+  printf("    /// The index in ErrorDocs() of the page whose name hashes to `hash`, or\n");
+  printf("    /// -1 if there is none. Callers still have to compare the name.\n");
+  printf("    static int\n");
+  printf("    ErrorDocIndex(unsigned hash)\n");
+  printf("    {\n");
+  printf("        switch (hash) {\n");
+  for(size_t i = 0; i < docs.size(); i++) {
+    printf("            case ErrorDocHash(");
+    printLiteral(docs[i].functionName);
+    printf("): return %d;\n", (int) i);
+  }
+  printf("            default: return -1;\n");
+  printf("        }\n");
+  printf("    }\n");
+
+  return 0;
+}
@@ -0,0 +1,819 @@
+// Re-issues a GL call trace recorded with GLEE_TRACE_CALLS (see glee.hpp)
+// in a hidden window and reports how long each frame took on the GPU.
+//
+// usage: glee_replay [trace file]
+//
+// Object names (buffers, textures, programs, ...) and uniform locations are
+// remapped to whatever the driver hands out during the replay. Calls the
+// replayer does not know are skipped: each such function is reported when the
+// trace first names it, and counted at the end.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+// Must match TraceRecordKind in glee.hpp
+#define TRACE_FUNCTION_NAME 0
+#define TRACE_CALL 1
+#define TRACE_FRAME_END 2
+#define TRACE_BUFFER_DATA 3
+
+// One recorded call
+struct Call {
+  unsigned short function;
+  const char *args;
+  unsigned short argBytes;
+  const char *payload;
+  uint32_t payloadBytes;
+};
+
+// Reads the arguments of a call in order. Pointers were stored as 64 bits.
+struct ArgReader {
+  const char *p;
+
+  template <typename T> T get() {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+  }
+
+  uint64_t ptr() {
+    return get<uint64_t>();
+  }
+};
+
+typedef std::map<GLuint, GLuint> NameMap;
+
+// Traced names to replayed names
+NameMap buffers, textures, vertexArrays, framebuffers, renderbuffers,
+  samplers, queries, shaders, programs;
+std::map<uint64_t, GLsync> syncs;
+
+// A buffer range the replay has mapped
+struct Mapping {
+  char *data;
+  GLintptr offset;
+  GLsizeiptr length;
+};
+
+// Traced buffer bound to each target, and the mapped ranges by traced buffer
+std::map<GLenum, GLuint> boundBuffers;
+std::map<GLuint, Mapping> mappings;
+// (replayed program, traced location) to replayed location
+std::map<std::pair<GLuint, GLint>, GLint> uniformLocations;
+// (replayed program, traced block index) to replayed block index
+std::map<std::pair<GLuint, GLuint>, GLuint> uniformBlocks;
+GLuint currentProgram = 0;
+
+typedef void (*Handler)(const Call &call, ArgReader &args);
+
+static GLuint mapName(NameMap &names, GLuint name) {
+  NameMap::iterator found = names.find(name);
+  return found == names.end() ? name : found->second;
+}
+
+static GLint mapLocation(GLint location) {
+  std::map<std::pair<GLuint, GLint>, GLint>::iterator found =
+    uniformLocations.find(std::make_pair(currentProgram, location));
+  return found == uniformLocations.end() ? location : found->second;
+}
+
+// The payload pointer, or the traced pointer as a buffer offset when no
+// client memory was captured
+static const void *payloadOr(const Call &call, uint64_t traced) {
+  return call.payloadBytes > 0 ? (const void *)call.payload :
+    (const void *)(uintptr_t)traced;
+}
+
+// glGen*/glDelete* for the common object types
+
+typedef void (GLAPIENTRY *GenFunc)(GLsizei, GLuint *);
+typedef void (GLAPIENTRY *DeleteFunc)(GLsizei, const GLuint *);
+
+static void genNames(const Call &call, ArgReader &args, GenFunc gen,
+  NameMap &names) {
+  GLsizei n = args.get<GLsizei>();
+  std::vector<GLuint> traced(n), replayed(n);
+  memcpy(&traced[0], call.payload, n * sizeof(GLuint));
+  gen(n, &replayed[0]);
+  for(GLsizei i = 0; i < n; i++) {
+    names[traced[i]] = replayed[i];
+  }
+}
+
+static void deleteNames(const Call &call, ArgReader &args, DeleteFunc del,
+  NameMap &names) {
+  GLsizei n = args.get<GLsizei>();
+  std::vector<GLuint> replayed(n);
+  for(GLsizei i = 0; i < n; i++) {
+    GLuint traced;
+    memcpy(&traced, call.payload + i * sizeof(GLuint), sizeof(GLuint));
+    replayed[i] = mapName(names, traced);
+    names.erase(traced);
+  }
+  del(n, &replayed[0]);
+}
+
+#define GEN_DELETE(Type, names) \
+  static void replayGen##Type(const Call &c, ArgReader &a) { \
+    genNames(c, a, glGen##Type, names); \
+  } \
+  static void replayDelete##Type(const Call &c, ArgReader &a) { \
+    deleteNames(c, a, glDelete##Type, names); \
+  }
+
+GEN_DELETE(Textures, textures)
+GEN_DELETE(VertexArrays, vertexArrays)
+GEN_DELETE(Framebuffers, framebuffers)
+GEN_DELETE(Renderbuffers, renderbuffers)
+GEN_DELETE(Samplers, samplers)
+GEN_DELETE(Queries, queries)
+
+// Buffers
+
+static void replayGenBuffers(const Call &c, ArgReader &a) {
+  genNames(c, a, glGenBuffers, buffers);
+}
+
+// Deleting a buffer also unmaps it
+static void replayDeleteBuffers(const Call &c, ArgReader &a) {
+  ArgReader count = a;
+  GLsizei n = count.get<GLsizei>();
+  for(GLsizei i = 0; i < n; i++) {
+    GLuint traced;
+    memcpy(&traced, c.payload + i * sizeof(GLuint), sizeof(GLuint));
+    mappings.erase(traced);
+  }
+  deleteNames(c, a, glDeleteBuffers, buffers);
+}
+
+static void replayBindBuffer(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLuint traced = a.get<GLuint>();
+  boundBuffers[target] = traced;
+  glBindBuffer(target, mapName(buffers, traced));
+}
+
+// Binding an indexed target also binds its generic one
+static void replayBindBufferBase(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLuint index = a.get<GLuint>();
+  GLuint traced = a.get<GLuint>();
+  boundBuffers[target] = traced;
+  glBindBufferBase(target, index, mapName(buffers, traced));
+}
+
+static void replayBindBufferRange(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLuint index = a.get<GLuint>();
+  GLuint traced = a.get<GLuint>();
+  boundBuffers[target] = traced;
+  GLintptr offset = a.get<GLintptr>();
+  glBindBufferRange(target, index, mapName(buffers, traced), offset,
+    a.get<GLsizeiptr>());
+}
+
+static void replayBufferData(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLsizeiptr size = a.get<GLsizeiptr>();
+  a.ptr();
+  glBufferData(target, size, c.payloadBytes > 0 ? c.payload : NULL,
+    a.get<GLenum>());
+}
+
+static void replayBufferStorage(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLsizeiptr size = a.get<GLsizeiptr>();
+  a.ptr();
+  glBufferStorage(target, size, c.payloadBytes > 0 ? c.payload : NULL,
+    a.get<GLbitfield>());
+}
+
+static void replayBufferSubData(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLintptr offset = a.get<GLintptr>();
+  GLsizeiptr size = a.get<GLsizeiptr>();
+  glBufferSubData(target, offset, size, c.payload);
+}
+
+// The data the app wrote through its mapping follows as buffer data
+// records, which are copied through this one
+static void replayMapBufferRange(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLintptr offset = a.get<GLintptr>();
+  GLsizeiptr length = a.get<GLsizeiptr>();
+  Mapping mapping;
+  mapping.data = (char *)glMapBufferRange(target, offset, length,
+    a.get<GLbitfield>());
+  mapping.offset = offset;
+  mapping.length = length;
+  if(mapping.data != NULL) {
+    mappings[boundBuffers[target]] = mapping;
+  }
+}
+
+static void replayFlushMappedBufferRange(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLintptr offset = a.get<GLintptr>();
+  glFlushMappedBufferRange(target, offset, a.get<GLsizeiptr>());
+}
+
+static void replayUnmapBuffer(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  mappings.erase(boundBuffers[target]);
+  glUnmapBuffer(target);
+}
+
+// Data the app wrote through a mapped pointer. It goes through the replay's
+// own mapping when the range is mapped, as it did in the app, and is
+// uploaded otherwise.
+static void replayBufferWrite(GLuint traced, GLintptr offset,
+  const char *data, size_t size) {
+  std::map<GLuint, Mapping>::iterator found = mappings.find(traced);
+  if(found != mappings.end() && offset >= found->second.offset &&
+    offset + (GLsizeiptr)size <= found->second.offset + found->second.length) {
+    memcpy(found->second.data + (offset - found->second.offset), data, size);
+    return;
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, mapName(buffers, traced));
+  glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,
+    mapName(buffers, boundBuffers[GL_COPY_WRITE_BUFFER]));
+}
+
+// Textures
+
+static void replayBindTexture(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  glBindTexture(target, mapName(textures, a.get<GLuint>()));
+}
+
+static void replayActiveTexture(const Call &c, ArgReader &a) {
+  glActiveTexture(a.get<GLenum>());
+}
+
+static void replayTexImage2D(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLint level = a.get<GLint>();
+  GLint internalFormat = a.get<GLint>();
+  GLsizei width = a.get<GLsizei>();
+  GLsizei height = a.get<GLsizei>();
+  GLint border = a.get<GLint>();
+  GLenum format = a.get<GLenum>();
+  GLenum type = a.get<GLenum>();
+  glTexImage2D(target, level, internalFormat, width, height, border, format,
+    type, payloadOr(c, a.ptr()));
+}
+
+static void replayTexParameteri(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLenum pname = a.get<GLenum>();
+  glTexParameteri(target, pname, a.get<GLint>());
+}
+
+static void replayTexParameterf(const Call &c, ArgReader &a) {
+  GLenum target = a.get<GLenum>();
+  GLenum pname = a.get<GLenum>();
+  glTexParameterf(target, pname, a.get<GLfloat>());
+}
+
+static void replayGenerateMipmap(const Call &c, ArgReader &a) {
+  glGenerateMipmap(a.get<GLenum>());
+}
+
+static void replayPixelStorei(const Call &c, ArgReader &a) {
+  GLenum pname = a.get<GLenum>();
+  glPixelStorei(pname, a.get<GLint>());
+}
+
+// Vertex arrays
+
+static void replayBindVertexArray(const Call &c, ArgReader &a) {
+  glBindVertexArray(mapName(vertexArrays, a.get<GLuint>()));
+}
+
+static void replayEnableVertexAttribArray(const Call &c, ArgReader &a) {
+  glEnableVertexAttribArray(a.get<GLuint>());
+}
+
+static void replayDisableVertexAttribArray(const Call &c, ArgReader &a) {
+  glDisableVertexAttribArray(a.get<GLuint>());
+}
+
+static void replayVertexAttribPointer(const Call &c, ArgReader &a) {
+  GLuint index = a.get<GLuint>();
+  GLint size = a.get<GLint>();
+  GLenum type = a.get<GLenum>();
+  GLboolean normalized = a.get<GLboolean>();
+  GLsizei stride = a.get<GLsizei>();
+  glVertexAttribPointer(index, size, type, normalized, stride,
+    (const void *)(uintptr_t)a.ptr());
+}
+
+static void replayVertexAttribDivisor(const Call &c, ArgReader &a) {
+  GLuint index = a.get<GLuint>();
+  glVertexAttribDivisor(index, a.get<GLuint>());
+}
+
+// Shaders and programs
+
+static void replayCreateShader(const Call &c, ArgReader &a) {
+  GLenum type = a.get<GLenum>();
+  shaders[a.get<GLuint>()] = glCreateShader(type);
+}
+
+static void replayShaderSource(const Call &c, ArgReader &a) {
+  GLuint shader = mapName(shaders, a.get<GLuint>());
+  GLsizei count = a.get<GLsizei>();
+  std::vector<const GLchar *> strings;
+  const char *source = c.payload;
+  for(GLsizei i = 0; i < count; i++) {
+    strings.push_back(source);
+    source += strlen(source) + 1;
+  }
+  glShaderSource(shader, count, count > 0 ? &strings[0] : NULL, NULL);
+}
+
+static void replayCompileShader(const Call &c, ArgReader &a) {
+  glCompileShader(mapName(shaders, a.get<GLuint>()));
+}
+
+static void replayDeleteShader(const Call &c, ArgReader &a) {
+  GLuint traced = a.get<GLuint>();
+  glDeleteShader(mapName(shaders, traced));
+  shaders.erase(traced);
+}
+
+static void replayCreateProgram(const Call &c, ArgReader &a) {
+  programs[a.get<GLuint>()] = glCreateProgram();
+}
+
+static void replayAttachShader(const Call &c, ArgReader &a) {
+  GLuint program = mapName(programs, a.get<GLuint>());
+  glAttachShader(program, mapName(shaders, a.get<GLuint>()));
+}
+
+static void replayDetachShader(const Call &c, ArgReader &a) {
+  GLuint program = mapName(programs, a.get<GLuint>());
+  glDetachShader(program, mapName(shaders, a.get<GLuint>()));
+}
+
+static void replayProgramParameteri(const Call &c, ArgReader &a) {
+  GLuint program = mapName(programs, a.get<GLuint>());
+  GLenum pname = a.get<GLenum>();
+  glProgramParameteri(program, pname, a.get<GLint>());
+}
+
+// The binary is only valid for the driver that made it. If the replay runs
+// elsewhere the driver rejects it and the program stays unlinked, just as
+// the app would then have fallen back to compiling.
+static void replayProgramBinary(const Call &c, ArgReader &a) {
+  GLuint program = mapName(programs, a.get<GLuint>());
+  GLenum format = a.get<GLenum>();
+  a.ptr();
+  glProgramBinary(program, format, c.payload, a.get<GLsizei>());
+}
+
+static void replayLinkProgram(const Call &c, ArgReader &a) {
+  glLinkProgram(mapName(programs, a.get<GLuint>()));
+}
+
+static void replayUseProgram(const Call &c, ArgReader &a) {
+  currentProgram = mapName(programs, a.get<GLuint>());
+  glUseProgram(currentProgram);
+}
+
+static void replayDeleteProgram(const Call &c, ArgReader &a) {
+  GLuint traced = a.get<GLuint>();
+  glDeleteProgram(mapName(programs, traced));
+  programs.erase(traced);
+}
+
+static void replayGetUniformLocation(const Call &c, ArgReader &a) {
+  GLuint program = mapName(programs, a.get<GLuint>());
+  a.ptr();
+  GLint traced = a.get<GLint>();
+  uniformLocations[std::make_pair(program, traced)] =
+    glGetUniformLocation(program, c.payload);
+}
+
+// Attribute locations are not remapped, glVertexAttribPointer and friends
+// use the traced ones; the query is made for its cost
+static void replayGetAttribLocation(const Call &c, ArgReader &a) {
+  GLuint program = mapName(programs, a.get<GLuint>());
+  glGetAttribLocation(program, c.payload);
+}
+
+static void replayGetUniformBlockIndex(const Call &c, ArgReader &a) {
+  GLuint program = mapName(programs, a.get<GLuint>());
+  a.ptr();
+  GLuint traced = a.get<GLuint>();
+  uniformBlocks[std::make_pair(program, traced)] =
+    glGetUniformBlockIndex(program, c.payload);
+}
+
+static void replayUniformBlockBinding(const Call &c, ArgReader &a) {
+  GLuint program = mapName(programs, a.get<GLuint>());
+  GLuint block = a.get<GLuint>();
+  std::map<std::pair<GLuint, GLuint>, GLuint>::iterator found =
+    uniformBlocks.find(std::make_pair(program, block));
+  if(found != uniformBlocks.end()) {
+    block = found->second;
+  }
+  glUniformBlockBinding(program, block, a.get<GLuint>());
+}
+
+// Uniforms
+
+static void replayUniform1i(const Call &c, ArgReader &a) {
+  GLint location = mapLocation(a.get<GLint>());
+  glUniform1i(location, a.get<GLint>());
+}
+
+static void replayUniform1f(const Call &c, ArgReader &a) {
+  GLint location = mapLocation(a.get<GLint>());
+  glUniform1f(location, a.get<GLfloat>());
+}
+
+static void replayUniform3f(const Call &c, ArgReader &a) {
+  GLint location = mapLocation(a.get<GLint>());
+  GLfloat x = a.get<GLfloat>();
+  GLfloat y = a.get<GLfloat>();
+  glUniform3f(location, x, y, a.get<GLfloat>());
+}
+
+static void replayUniform4f(const Call &c, ArgReader &a) {
+  GLint location = mapLocation(a.get<GLint>());
+  GLfloat x = a.get<GLfloat>();
+  GLfloat y = a.get<GLfloat>();
+  GLfloat z = a.get<GLfloat>();
+  glUniform4f(location, x, y, z, a.get<GLfloat>());
+}
+
+#define UNIFORM_V(Suffix, Type) \
+  static void replayUniform##Suffix(const Call &c, ArgReader &a) { \
+    GLint location = mapLocation(a.get<GLint>()); \
+    GLsizei count = a.get<GLsizei>(); \
+    glUniform##Suffix(location, count, (const Type *)c.payload); \
+  }
+
+UNIFORM_V(1fv, GLfloat)
+UNIFORM_V(2fv, GLfloat)
+UNIFORM_V(3fv, GLfloat)
+UNIFORM_V(4fv, GLfloat)
+UNIFORM_V(1iv, GLint)
+
+#define UNIFORM_MATRIX(Suffix) \
+  static void replayUniformMatrix##Suffix(const Call &c, ArgReader &a) { \
+    GLint location = mapLocation(a.get<GLint>()); \
+    GLsizei count = a.get<GLsizei>(); \
+    GLboolean transpose = a.get<GLboolean>(); \
+    glUniformMatrix##Suffix(location, count, transpose, \
+      (const GLfloat *)c.payload); \
+  }
+
+UNIFORM_MATRIX(3fv)
+UNIFORM_MATRIX(4fv)
+
+// Fixed function state
+
+static void replayViewport(const Call &c, ArgReader &a) {
+  GLint x = a.get<GLint>();
+  GLint y = a.get<GLint>();
+  GLsizei width = a.get<GLsizei>();
+  glViewport(x, y, width, a.get<GLsizei>());
+}
+
+static void replayClear(const Call &c, ArgReader &a) {
+  glClear(a.get<GLbitfield>());
+}
+
+static void replayClearColor(const Call &c, ArgReader &a) {
+  GLfloat r = a.get<GLfloat>();
+  GLfloat g = a.get<GLfloat>();
+  GLfloat b = a.get<GLfloat>();
+  glClearColor(r, g, b, a.get<GLfloat>());
+}
+
+static void replayEnable(const Call &c, ArgReader &a) {
+  glEnable(a.get<GLenum>());
+}
+
+static void replayDisable(const Call &c, ArgReader &a) {
+  glDisable(a.get<GLenum>());
+}
+
+static void replayDepthFunc(const Call &c, ArgReader &a) {
+  glDepthFunc(a.get<GLenum>());
+}
+
+static void replayCullFace(const Call &c, ArgReader &a) {
+  glCullFace(a.get<GLenum>());
+}
+
+static void replayFrontFace(const Call &c, ArgReader &a) {
+  glFrontFace(a.get<GLenum>());
+}
+
+static void replayBlendFunc(const Call &c, ArgReader &a) {
+  GLenum src = a.get<GLenum>();
+  glBlendFunc(src, a.get<GLenum>());
+}
+
+// Draws
+
+static void replayDrawArrays(const Call &c, ArgReader &a) {
+  GLenum mode = a.get<GLenum>();
+  GLint first = a.get<GLint>();
+  glDrawArrays(mode, first, a.get<GLsizei>());
+}
+
+static void replayDrawElements(const Call &c, ArgReader &a) {
+  GLenum mode = a.get<GLenum>();
+  GLsizei count = a.get<GLsizei>();
+  GLenum type = a.get<GLenum>();
+  glDrawElements(mode, count, type, (const void *)(uintptr_t)a.ptr());
+}
+
+static void replayDrawElementsInstancedBaseVertex(const Call &c,
+  ArgReader &a) {
+  GLenum mode = a.get<GLenum>();
+  GLsizei count = a.get<GLsizei>();
+  GLenum type = a.get<GLenum>();
+  const void *indices = (const void *)(uintptr_t)a.ptr();
+  GLsizei instanceCount = a.get<GLsizei>();
+  glDrawElementsInstancedBaseVertex(mode, count, type, indices,
+    instanceCount, a.get<GLint>());
+}
+
+static void replayMultiDrawElementsBaseVertex(const Call &c, ArgReader &a) {
+  GLenum mode = a.get<GLenum>();
+  a.ptr();
+  GLenum type = a.get<GLenum>();
+  a.ptr();
+  GLsizei drawCount = a.get<GLsizei>();
+  if(drawCount <= 0) {
+    return;
+  }
+  // Payload is the counts, the index offsets, then the base vertices
+  std::vector<GLsizei> counts(drawCount);
+  std::vector<uint64_t> offsets(drawCount);
+  std::vector<GLint> baseVertices(drawCount);
+  std::vector<const void *> indices(drawCount);
+  const char *p = c.payload;
+  memcpy(&counts[0], p, drawCount * sizeof(GLsizei));
+  p += drawCount * sizeof(GLsizei);
+  memcpy(&offsets[0], p, drawCount * sizeof(uint64_t));
+  p += drawCount * sizeof(uint64_t);
+  memcpy(&baseVertices[0], p, drawCount * sizeof(GLint));
+  for(GLsizei i = 0; i < drawCount; i++) {
+    indices[i] = (const void *)(uintptr_t)offsets[i];
+  }
+  glMultiDrawElementsBaseVertex(mode, &counts[0], type, &indices[0],
+    drawCount, &baseVertices[0]);
+}
+
+static void replayMultiDrawElementsIndirect(const Call &c, ArgReader &a) {
+  GLenum mode = a.get<GLenum>();
+  GLenum type = a.get<GLenum>();
+  const void *indirect = (const void *)(uintptr_t)a.ptr();
+  GLsizei drawCount = a.get<GLsizei>();
+  glMultiDrawElementsIndirect(mode, type, indirect, drawCount,
+    a.get<GLsizei>());
+}
+
+// Syncs
+
+static void replayFenceSync(const Call &c, ArgReader &a) {
+  GLenum condition = a.get<GLenum>();
+  GLbitfield flags = a.get<GLbitfield>();
+  syncs[a.ptr()] = glFenceSync(condition, flags);
+}
+
+static void replayClientWaitSync(const Call &c, ArgReader &a) {
+  GLsync sync = syncs[a.ptr()];
+  GLbitfield flags = a.get<GLbitfield>();
+  glClientWaitSync(sync, flags, a.get<GLuint64>());
+}
+
+static void replayDeleteSync(const Call &c, ArgReader &a) {
+  uint64_t traced = a.ptr();
+  glDeleteSync(syncs[traced]);
+  syncs.erase(traced);
+}
+
+static void replayFinish(const Call &c, ArgReader &a) {
+  glFinish();
+}
+
+#define HANDLER(name) handlers["gl" #name] = replay##name
+
+static std::map<std::string, Handler> makeHandlers() {
+  std::map<std::string, Handler> handlers;
+  HANDLER(GenBuffers); HANDLER(DeleteBuffers);
+  HANDLER(GenTextures); HANDLER(DeleteTextures);
+  HANDLER(GenVertexArrays); HANDLER(DeleteVertexArrays);
+  HANDLER(GenFramebuffers); HANDLER(DeleteFramebuffers);
+  HANDLER(GenRenderbuffers); HANDLER(DeleteRenderbuffers);
+  HANDLER(GenSamplers); HANDLER(DeleteSamplers);
+  HANDLER(GenQueries); HANDLER(DeleteQueries);
+  HANDLER(BindBuffer); HANDLER(BindBufferBase); HANDLER(BindBufferRange);
+  HANDLER(BufferData); HANDLER(BufferStorage); HANDLER(BufferSubData);
+  HANDLER(MapBufferRange); HANDLER(FlushMappedBufferRange);
+  HANDLER(UnmapBuffer);
+  HANDLER(BindTexture); HANDLER(ActiveTexture); HANDLER(TexImage2D);
+  HANDLER(TexParameteri); HANDLER(TexParameterf); HANDLER(GenerateMipmap);
+  HANDLER(PixelStorei);
+  HANDLER(BindVertexArray); HANDLER(EnableVertexAttribArray);
+  HANDLER(DisableVertexAttribArray); HANDLER(VertexAttribPointer);
+  HANDLER(VertexAttribDivisor);
+  HANDLER(CreateShader); HANDLER(ShaderSource); HANDLER(CompileShader);
+  HANDLER(DeleteShader); HANDLER(CreateProgram); HANDLER(AttachShader);
+  HANDLER(DetachShader); HANDLER(ProgramParameteri); HANDLER(ProgramBinary);
+  HANDLER(LinkProgram); HANDLER(UseProgram); HANDLER(DeleteProgram);
+  HANDLER(GetUniformLocation); HANDLER(GetAttribLocation);
+  HANDLER(GetUniformBlockIndex); HANDLER(UniformBlockBinding);
+  HANDLER(Uniform1i); HANDLER(Uniform1f); HANDLER(Uniform3f);
+  HANDLER(Uniform4f); HANDLER(Uniform1fv); HANDLER(Uniform2fv);
+  HANDLER(Uniform3fv); HANDLER(Uniform4fv); HANDLER(Uniform1iv);
+  HANDLER(UniformMatrix3fv); HANDLER(UniformMatrix4fv);
+  HANDLER(Viewport); HANDLER(Clear); HANDLER(ClearColor); HANDLER(Enable);
+  HANDLER(Disable); HANDLER(DepthFunc); HANDLER(CullFace);
+  HANDLER(FrontFace); HANDLER(BlendFunc);
+  HANDLER(DrawArrays); HANDLER(DrawElements);
+  HANDLER(DrawElementsInstancedBaseVertex);
+  HANDLER(MultiDrawElementsBaseVertex); HANDLER(MultiDrawElementsIndirect);
+  HANDLER(FenceSync); HANDLER(ClientWaitSync); HANDLER(DeleteSync);
+  HANDLER(Finish);
+  return handlers;
+}
+
+// Read the whole trace into memory so file access isn't timed
+static std::vector<char> readTrace(const char *path) {
+  std::vector<char> data;
+  FILE *file = fopen(path, "rb");
+  if(!file) {
+    fprintf(stderr, "Unable to open trace %s\n", path);
+    exit(1);
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data.resize(size);
+  if(size > 0 && fread(&data[0], 1, size, file) != (size_t)size) {
+    fprintf(stderr, "Unable to read trace %s\n", path);
+    exit(1);
+  }
+  fclose(file);
+  if(data.size() < 8 || memcmp(&data[0], "GLEETRC1", 8) != 0) {
+    fprintf(stderr, "%s is not a GLEE trace\n", path);
+    exit(1);
+  }
+  return data;
+}
+
+int main(int argc, char **argv) {
+  const char *path = argc > 1 ? argv[1] : "glee_trace.bin";
+  std::vector<char> trace = readTrace(path);
+
+  // Hidden window for the context
+  if(!glfwInit()) {
+    fprintf(stderr, "Unable to initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  GLFWwindow *window = glfwCreateWindow(640, 480, "glee_replay", NULL, NULL);
+  if(!window) {
+    fprintf(stderr, "Unable to create a window\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(window);
+  glewExperimental = true;
+  if(glewInit() != GLEW_OK) {
+    fprintf(stderr, "Unable to initialize GLEW\n");
+    return 1;
+  }
+  glGetError();
+
+  std::map<std::string, Handler> handlers = makeHandlers();
+  std::vector<std::string> names;
+  std::vector<Handler> dispatch;
+  std::map<std::string, unsigned> skipped;
+  std::vector<double> frameTimes;
+  unsigned long calls = 0;
+
+  const char *p = &trace[8];
+  const char *end = &trace[0] + trace.size();
+  double frameStart = glfwGetTime();
+  while(p < end) {
+    unsigned char kind = *p++;
+    if(kind == TRACE_FUNCTION_NAME) {
+      unsigned short id, length;
+      memcpy(&id, p, 2);
+      memcpy(&length, p + 2, 2);
+      std::string name(p + 4, length);
+      p += 4 + length;
+      if(id >= names.size()) {
+        names.resize(id + 1);
+        dispatch.resize(id + 1);
+      }
+      names[id] = name;
+      std::map<std::string, Handler>::iterator found = handlers.find(name);
+      dispatch[id] = found == handlers.end() ? NULL : found->second;
+      if(!dispatch[id]) {
+        fprintf(stderr, "No handler for %s, its calls are skipped\n",
+          name.c_str());
+      }
+    }
+    else if(kind == TRACE_CALL) {
+      Call call;
+      memcpy(&call.function, p, 2);
+      memcpy(&call.argBytes, p + 2, 2);
+      memcpy(&call.payloadBytes, p + 4, 4);
+      call.args = p + 8;
+      call.payload = call.args + call.argBytes;
+      p = call.payload + call.payloadBytes;
+      if(call.function >= dispatch.size() || p > end) {
+        fprintf(stderr, "Corrupt trace at byte %ld\n",
+          (long)(call.args - &trace[0]));
+        break;
+      }
+      if(!dispatch[call.function]) {
+        skipped[names[call.function]]++;
+        continue;
+      }
+      ArgReader args = { call.args };
+      dispatch[call.function](call, args);
+      calls++;
+    }
+    else if(kind == TRACE_BUFFER_DATA) {
+      uint32_t buffer, size;
+      uint64_t offset;
+      memcpy(&buffer, p, 4);
+      memcpy(&offset, p + 4, 8);
+      memcpy(&size, p + 12, 4);
+      const char *data = p + 16;
+      p = data + size;
+      if(p > end) {
+        fprintf(stderr, "Corrupt trace at byte %ld\n",
+          (long)(data - 16 - &trace[0]));
+        break;
+      }
+      replayBufferWrite(buffer, (GLintptr)offset, data, size);
+    }
+    else if(kind == TRACE_FRAME_END) {
+      glFinish();
+      double now = glfwGetTime();
+      frameTimes.push_back(now - frameStart);
+      frameStart = now;
+    }
+    else {
+      fprintf(stderr, "Unknown record %d at byte %ld\n", kind,
+        (long)(p - 1 - &trace[0]));
+      break;
+    }
+  }
+  glFinish();
+
+  printf("%lu calls replayed in %u frames\n", calls,
+    (unsigned)frameTimes.size());
+  // The first frame also holds loading, report it separately
+  if(!frameTimes.empty()) {
+    printf("first frame: %.3f ms\n", frameTimes[0] * 1e3);
+  }
+  if(frameTimes.size() > 1) {
+    double total = 0, fastest = frameTimes[1], slowest = frameTimes[1];
+    for(size_t i = 1; i < frameTimes.size(); i++) {
+      total += frameTimes[i];
+      fastest = frameTimes[i] < fastest ? frameTimes[i] : fastest;
+      slowest = frameTimes[i] > slowest ? frameTimes[i] : slowest;
+    }
+    printf("other frames: min %.3f ms, avg %.3f ms, max %.3f ms\n",
+      fastest * 1e3, total / (frameTimes.size() - 1) * 1e3, slowest * 1e3);
+  }
+  for(std::map<std::string, unsigned>::iterator i = skipped.begin();
+    i != skipped.end(); i++) {
+    fprintf(stderr, "skipped %s x%u\n", i->first.c_str(), i->second);
+  }
+  if(glGetError() != GL_NO_ERROR) {
+    printf("GL errors were raised during the replay\n");
+  }
+
+  glfwDestroyWindow(window);
+  glfwTerminate();
+  return 0;
+}
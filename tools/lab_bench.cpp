@@ -0,0 +1,617 @@
+// Benchmarks of the loaders, mesh processing and rendering code lab-01 runs,
+// for tracking performance across commits.
+//
+// usage: lab_bench [-resources DIR] [-data DIR] [-filter TEXT]
+//                  [-time SECONDS] [-json FILE]
+//
+// Each benchmark repeats one operation until -time seconds (.5 by default)
+// have passed and reports the mean time per operation, the bytes it
+// processes per second and the heap allocations it makes. -filter runs only
+// the benchmarks whose name contains TEXT, -json also writes the results to
+// FILE. Synthetic inputs (bmps of several sizes, large OBJs, see
+// synthetic_assets.h) are written to the -data directory (bench_data) the
+// first time. The upload benchmarks need a GL 3.3 context, made in a hidden
+// window, and are skipped without one.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#  include <direct.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "gl_include.h"
+#include <GLFW/glfw3.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "alloc_track.h"
+#include "arena.h"
+#include "image.h"
+#include "mesh_load.h"
+#include "mesh_pool.h"
+#include "mesh_soa.h"
+#include "soft_raster.h"
+
+#include "synthetic_assets.h"
+
+// Heap allocations so far. With glibc every allocation, operator new
+// included, goes through the malloc replacements below; elsewhere only
+// operator new is counted. TRACK_ALLOCS builds already replace them in
+// lab_core, the counts come from its tracker instead.
+#ifdef ALLOC_TRACKING
+static void allocsSoFar(uint64_t *count, uint64_t *bytes) {
+  allocTotals(count, bytes);
+}
+#else
+static std::atomic<uint64_t> allocCount(0);
+static std::atomic<uint64_t> allocBytes(0);
+
+static void allocsSoFar(uint64_t *count, uint64_t *bytes) {
+  *count = allocCount;
+  *bytes = allocBytes;
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+
+void *malloc(size_t size) {
+  allocCount++;
+  allocBytes += size;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  allocCount++;
+  allocBytes += count * size;
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+  allocCount++;
+  allocBytes += size;
+  return __libc_realloc(p, size);
+}
+}
+#else
+void *operator new(size_t size) {
+  allocCount++;
+  allocBytes += size;
+  void *p = malloc(size > 0 ? size : 1);
+  if(p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  free(p);
+}
+#endif
+#endif
+
+// Synthetic inputs
+#define BENCH_IMAGE_SIZES {256, 1024, 4096}
+#define BENCH_GRID_TRIANGLES 131072
+// Sphere exercising the rest of the parser: quads and n-gons to triangulate,
+// groups, materials and negative indices
+#define BENCH_SPHERE_TRIANGLES 500000
+#define BENCH_SPHERE_GROUPS 64
+#define BENCH_SPHERE_MATERIALS 8
+// Corners of the one n-gon in long_face.obj, whose vertex list outgrows the
+// arena blocks and gets one of its own (12 bytes each, not a multiple of
+// the arena's alignment)
+#define BENCH_LONG_FACE 1367
+
+// Software rendered frames
+#define BENCH_FRAME_WIDTH 640
+#define BENCH_FRAME_HEIGHT 480
+#define BENCH_FRAME_SIDE 10 // Instances per side of the grid drawn
+
+struct BenchResult {
+  std::string name;
+  uint64_t iterations;
+  double nsPerOp;
+  double bytesPerSecond; // 0 when the operation has no natural size
+  double allocsPerOp;
+  double allocBytesPerOp;
+};
+
+// One operation, returns false if it failed
+typedef bool (*BenchFunc)(void *context);
+
+std::vector<BenchResult> results;
+double minTime = .5;
+const char *filter = NULL;
+
+static double now() {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Time op until minTime has passed, doubling the operations between clock
+// reads. bytes is what one operation processes.
+static void runBench(const std::string &name, double bytes, BenchFunc op,
+  void *context) {
+  if(filter != NULL && name.find(filter) == std::string::npos) {
+    return;
+  }
+  // Warm up caches and lazily created state
+  if(!op(context)) {
+    printf("%-36s failed\n", name.c_str());
+    return;
+  }
+
+  uint64_t iterations = 0;
+  uint64_t batch = 1;
+  uint64_t allocs, allocated;
+  allocsSoFar(&allocs, &allocated);
+  double start = now();
+  double elapsed = 0.;
+  while(elapsed < minTime) {
+    for(uint64_t i = 0; i < batch; i++) {
+      op(context);
+    }
+    iterations += batch;
+    batch *= 2;
+    elapsed = now() - start;
+  }
+
+  BenchResult result;
+  result.name = name;
+  result.iterations = iterations;
+  result.nsPerOp = elapsed * 1e9 / iterations;
+  result.bytesPerSecond = bytes * iterations / elapsed;
+  uint64_t allocsAfter, allocatedAfter;
+  allocsSoFar(&allocsAfter, &allocatedAfter);
+  result.allocsPerOp = (double) (allocsAfter - allocs) / iterations;
+  result.allocBytesPerOp = (double) (allocatedAfter - allocated) / iterations;
+  results.push_back(result);
+
+  printf("%-36s %10llu %14.0f %10.1f %12.1f %14.0f\n", name.c_str(),
+    (unsigned long long) iterations, result.nsPerOp,
+    result.bytesPerSecond / 1e6, result.allocsPerOp, result.allocBytesPerOp);
+}
+
+static bool writeJson(const char *path) {
+  FILE *fp = fopen(path, "w");
+  if(fp == NULL) {
+    fprintf(stderr, "Can't write %s\n", path);
+    return false;
+  }
+  fprintf(fp, "{\n  \"benchmarks\": [\n");
+  for(size_t i = 0; i < results.size(); i++) {
+    const BenchResult &r = results[i];
+    fprintf(fp, "    {\"name\": \"%s\", \"iterations\": %llu, "
+      "\"ns_per_op\": %.1f, \"bytes_per_second\": %.1f, "
+      "\"allocs_per_op\": %.2f, \"alloc_bytes_per_op\": %.1f}%s\n",
+      r.name.c_str(), (unsigned long long) r.iterations, r.nsPerOp,
+      r.bytesPerSecond, r.allocsPerOp, r.allocBytesPerOp,
+      i + 1 < results.size() ? "," : "");
+  }
+  fprintf(fp, "  ]\n}\n");
+  return fclose(fp) == 0;
+}
+
+static long fileSize(const std::string &path) {
+  struct stat info;
+  return stat(path.c_str(), &info) == 0 ? (long) info.st_size : -1;
+}
+
+static void makeDirectory(const std::string &path) {
+#ifdef _WIN32
+  _mkdir(path.c_str());
+#else
+  mkdir(path.c_str(), 0755);
+#endif
+}
+
+// A square whose corners are repeated around one long face, then split into
+// two triangles
+static bool writeLongFaceObj(const std::string &path) {
+  FILE *fp = fopen(path.c_str(), "w");
+  if(fp == NULL) {
+    fprintf(stderr, "Can't write %s\n", path.c_str());
+    return false;
+  }
+  fprintf(fp, "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf");
+  for(int i = 0; i < BENCH_LONG_FACE; i++) {
+    fprintf(fp, " %d", i % 4 + 1);
+  }
+  fprintf(fp, "\nf 1 2 3\nf 1 3 4\n");
+  return fclose(fp) == 0;
+}
+
+// An allocation too big for the current block followed by small aligned
+// ones, the pattern of a long face's corners and the vertex cache. Fails if
+// any of them is misaligned or lands past the end of its block.
+static bool arenaOp(void *) {
+  Arena arena;
+  arenaInit(&arena, 1024);
+  bool ok = arenaAlloc(&arena, BENCH_LONG_FACE * 12, 4) != NULL &&
+    arena.cursor <= arena.end;
+  for(int i = 0; ok && i < 64; i++) {
+    char *p = (char *) arenaAlloc(&arena, 48, 8);
+    ok = p != NULL && ((uintptr_t) p & 7) == 0 && arena.cursor <= arena.end;
+  }
+  arenaDestroy(&arena);
+  return ok;
+}
+
+struct ImageBench {
+  std::string path;
+};
+
+static bool imageOp(void *context) {
+  ImageBench *bench = (ImageBench *) context;
+  Image image;
+  if(!imageLoad(NULL, bench->path.c_str(), &image)) {
+    return false;
+  }
+  free(image.data);
+  return true;
+}
+
+struct ObjBench {
+  std::string path;
+  std::vector<tinyobj::shape_t> shapes;
+  std::vector<tinyobj::material_t> materials;
+  std::string err;
+};
+
+static bool objOp(void *context) {
+  ObjBench *bench = (ObjBench *) context;
+  bench->materials.clear();
+  bench->err.clear();
+  return loadObj(NULL, bench->path.c_str(), bench->shapes, bench->materials,
+    bench->err) && !bench->shapes.empty();
+}
+
+// The first shape of a mesh, with texture coordinates made up if it has
+// none (every pass below wants them)
+struct MeshData {
+  std::string name;
+  std::vector<float> positions;
+  std::vector<float> texCoords;
+  std::vector<unsigned> indices;
+};
+
+static bool loadMesh(const std::string &name, const std::string &path,
+  MeshData *mesh) {
+  ObjBench obj;
+  obj.path = path;
+  if(!objOp(&obj)) {
+    fprintf(stderr, "%s", obj.err.c_str());
+    return false;
+  }
+  const tinyobj::mesh_t &shape = obj.shapes[0].mesh;
+  mesh->name = name;
+  mesh->positions = shape.positions;
+  mesh->texCoords = shape.texcoords;
+  mesh->indices = shape.indices;
+  if(mesh->texCoords.size() / 2 != mesh->positions.size() / 3) {
+    mesh->texCoords.assign(mesh->positions.size() / 3 * 2, 0.f);
+  }
+  resizeMesh(mesh->positions);
+  return true;
+}
+
+static bool resizeOp(void *context) {
+  // Already normalized, so every run does the same work
+  resizeMesh(((MeshData *) context)->positions);
+  return true;
+}
+
+// The same mesh as aligned structure of arrays
+static bool soaFromMesh(const MeshData *mesh, MeshSoA *soa) {
+  return meshSoAFromInterleaved(soa, &mesh->positions[0], NULL,
+    &mesh->texCoords[0], mesh->positions.size() / 3, &mesh->indices[0],
+    mesh->indices.size());
+}
+
+static bool soaBoundsOp(void *context) {
+  float min[3], max[3];
+  meshSoABounds((const MeshSoA *) context, min, max);
+  return min[0] <= max[0];
+}
+
+static bool soaResizeOp(void *context) {
+  meshSoAResize((MeshSoA *) context);
+  return true;
+}
+
+struct InterleaveBench {
+  const MeshSoA *mesh;
+  std::vector<float> positions;
+};
+
+static bool interleaveOp(void *context) {
+  InterleaveBench *bench = (InterleaveBench *) context;
+  meshSoAInterleave(bench->mesh, MESH_SOA_POSITIONS, &bench->positions[0]);
+  return true;
+}
+
+struct UploadBench {
+  MeshPool pool;
+  const MeshData *mesh;
+  MeshSoA soa;
+};
+
+static bool uploadOp(void *context) {
+  UploadBench *bench = (UploadBench *) context;
+  meshPoolClear(&bench->pool);
+  int id = meshPoolAdd(&bench->pool, bench->mesh->positions,
+    bench->mesh->texCoords, bench->mesh->indices);
+  // Count the copy the driver may still be doing
+  glFinish();
+  return id >= 0;
+}
+
+static bool uploadSoAOp(void *context) {
+  UploadBench *bench = (UploadBench *) context;
+  meshPoolClear(&bench->pool);
+  int id = meshPoolAddSoA(&bench->pool, &bench->soa);
+  glFinish();
+  return id >= 0;
+}
+
+struct FrameBench {
+  SoftRasterizer raster;
+  SoftDraw draw;
+};
+
+static bool frameOp(void *context) {
+  FrameBench *bench = (FrameBench *) context;
+  softRasterClear(&bench->raster, .25f, .75f, 1.f, 0.f);
+  softRasterDraw(&bench->raster, &bench->draw);
+  return true;
+}
+
+// A hidden window's GL context for the upload benchmarks
+static GLFWwindow *createContext() {
+  if(!glfwInit()) {
+    return NULL;
+  }
+  glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  GLFWwindow *window = glfwCreateWindow(64, 64, "lab_bench", NULL, NULL);
+  if(window == NULL) {
+    glfwTerminate();
+    return NULL;
+  }
+  glfwMakeContextCurrent(window);
+  glewExperimental = true;
+  if(glewInit() != GLEW_OK) {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return NULL;
+  }
+  glGetError();
+  return window;
+}
+
+int main(int argc, char **argv) {
+  std::string resources = "../resources";
+  std::string data = "bench_data";
+  const char *jsonPath = NULL;
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "-resources") == 0 && i + 1 < argc) {
+      resources = argv[++i];
+    } else if(strcmp(argv[i], "-data") == 0 && i + 1 < argc) {
+      data = argv[++i];
+    } else if(strcmp(argv[i], "-filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if(strcmp(argv[i], "-time") == 0 && i + 1 < argc) {
+      minTime = atof(argv[++i]);
+    } else if(strcmp(argv[i], "-json") == 0 && i + 1 < argc) {
+      jsonPath = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [-resources DIR] [-data DIR] "
+        "[-filter TEXT] [-time SECONDS] [-json FILE]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // Synthetic inputs, kept between runs
+  makeDirectory(data);
+  const int imageSizes[] = BENCH_IMAGE_SIZES;
+  std::vector<std::string> images(1, resources + "/world.bmp");
+  for(size_t i = 0; i < sizeof(imageSizes) / sizeof(imageSizes[0]); i++) {
+    char name[64];
+    snprintf(name, sizeof(name), "/gradient_%d.bmp", imageSizes[i]);
+    std::string path = data + name;
+    if(fileSize(path) < 0 &&
+      !writeSyntheticBmp(path.c_str(), imageSizes[i], imageSizes[i], 24)) {
+      return 1;
+    }
+    images.push_back(path);
+  }
+  SyntheticObj grid;
+  syntheticObjDefault(&grid);
+  grid.shape = SYNTHETIC_GRID;
+  grid.triangles = BENCH_GRID_TRIANGLES;
+  char objName[64];
+  snprintf(objName, sizeof(objName), "/grid_%d.obj", BENCH_GRID_TRIANGLES);
+  std::string gridPath = data + objName;
+  if(fileSize(gridPath) < 0 && !writeSyntheticObj(gridPath.c_str(), &grid)) {
+    return 1;
+  }
+  SyntheticObj mixed;
+  syntheticObjDefault(&mixed);
+  mixed.triangles = BENCH_SPHERE_TRIANGLES;
+  mixed.quads = true;
+  mixed.groups = BENCH_SPHERE_GROUPS;
+  mixed.materials = BENCH_SPHERE_MATERIALS;
+  mixed.negativeIndices = true;
+  snprintf(objName, sizeof(objName), "/sphere_mixed_%d.obj",
+    BENCH_SPHERE_TRIANGLES);
+  std::string mixedPath = data + objName;
+  if(fileSize(mixedPath) < 0 &&
+    !writeSyntheticObj(mixedPath.c_str(), &mixed)) {
+    return 1;
+  }
+  std::string longFacePath = data + "/long_face.obj";
+  if(fileSize(longFacePath) < 0 && !writeLongFaceObj(longFacePath)) {
+    return 1;
+  }
+
+  printf("%-36s %10s %14s %10s %12s %14s\n", "benchmark", "iterations",
+    "ns/op", "MB/s", "allocs/op", "alloc bytes/op");
+
+  // Image loading
+  for(size_t i = 0; i < images.size(); i++) {
+    ImageBench bench;
+    bench.path = images[i];
+    std::string name = "imageLoad/" +
+      images[i].substr(images[i].find_last_of('/') + 1);
+    runBench(name, (double) fileSize(images[i]), imageOp, &bench);
+  }
+
+  // OBJ parsing
+  const char *objNames[] = {"cube.obj", "sphere.obj", "bunny.obj"};
+  std::vector<std::string> objs;
+  for(size_t i = 0; i < sizeof(objNames) / sizeof(objNames[0]); i++) {
+    objs.push_back(resources + "/" + objNames[i]);
+  }
+  objs.push_back(gridPath);
+  objs.push_back(mixedPath);
+  objs.push_back(longFacePath);
+  std::vector<MeshData> meshes;
+  for(size_t i = 0; i < objs.size(); i++) {
+    ObjBench bench;
+    bench.path = objs[i];
+    std::string file = objs[i].substr(objs[i].find_last_of('/') + 1);
+    runBench("LoadObj/" + file, (double) fileSize(objs[i]), objOp, &bench);
+
+    // Keep the larger single shape meshes for the passes below
+    MeshData mesh;
+    if(i > 0 && objs[i] != mixedPath && objs[i] != longFacePath &&
+      loadMesh(file, objs[i], &mesh)) {
+      meshes.push_back(mesh);
+    }
+  }
+
+  // The allocator LoadObj parses out of
+  runBench("arena/oversized", 0., arenaOp, NULL);
+
+  // Mesh processing
+  for(size_t i = 0; i < meshes.size(); i++) {
+    double bytes = (double) (meshes[i].positions.size() * sizeof(float));
+    runBench("resizeMesh/" + meshes[i].name, bytes, resizeOp, &meshes[i]);
+
+    // The same passes over the structure of arrays copy
+    MeshSoA soa = MeshSoA();
+    if(!soaFromMesh(&meshes[i], &soa)) {
+      continue;
+    }
+    runBench("meshSoABounds/" + meshes[i].name, bytes, soaBoundsOp, &soa);
+    runBench("meshSoAResize/" + meshes[i].name, bytes, soaResizeOp, &soa);
+    InterleaveBench interleave;
+    interleave.mesh = &soa;
+    interleave.positions.resize(meshes[i].positions.size());
+    runBench("meshSoAInterleave/" + meshes[i].name, bytes, interleaveOp,
+      &interleave);
+    meshSoAFree(&soa);
+  }
+
+  // Software rendered frame: a grid of the sphere seen from the front
+  std::string spherePath = resources + "/sphere.obj";
+  Image image;
+  MeshData sphere;
+  if(loadMesh("sphere.obj", spherePath, &sphere) &&
+    imageLoad(NULL, (resources + "/world.bmp").c_str(), &image)) {
+    MipChain texture;
+    mipChainInit(&texture, image.sizeX, image.sizeY,
+      (const unsigned char *) image.data);
+    free(image.data);
+    Sampler sampler;
+    samplerDefault(&sampler);
+
+    std::vector<glm::mat4> instances;
+    for(int y = 0; y < BENCH_FRAME_SIDE; y++) {
+      for(int x = 0; x < BENCH_FRAME_SIDE; x++) {
+        instances.push_back(glm::translate(glm::mat4(1.f), glm::vec3(
+          (x - (BENCH_FRAME_SIDE - 1) / 2.f) * 2.5f,
+          (y - (BENCH_FRAME_SIDE - 1) / 2.f) * 2.5f, 0.f)));
+      }
+    }
+
+    FrameBench bench;
+    softRasterInit(&bench.raster, BENCH_FRAME_WIDTH, BENCH_FRAME_HEIGHT, 0);
+    bench.draw.positions = &sphere.positions[0];
+    bench.draw.texCoords = &sphere.texCoords[0];
+    bench.draw.vertexCount = sphere.positions.size() / 3;
+    bench.draw.indices = &sphere.indices[0];
+    bench.draw.indexCount = sphere.indices.size();
+    bench.draw.viewProj = glm::perspective(70.f,
+      BENCH_FRAME_WIDTH / (float) BENCH_FRAME_HEIGHT, .1f, 100.f) *
+      glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.f, -20.f));
+    bench.draw.instances = &instances[0];
+    bench.draw.visible = NULL;
+    bench.draw.instanceCount = instances.size();
+    bench.draw.texture = &texture;
+    bench.draw.sampler = &sampler;
+    char name[64];
+    snprintf(name, sizeof(name), "softFrame/sphere_x%d",
+      BENCH_FRAME_SIDE * BENCH_FRAME_SIDE);
+    // Bytes are the color and depth buffers
+    runBench(name, BENCH_FRAME_WIDTH * BENCH_FRAME_HEIGHT * 8., frameOp,
+      &bench);
+    softRasterDestroy(&bench.raster);
+    mipChainFree(&texture);
+  }
+
+  // Uploads to the GPU, sendMesh's path
+  GLFWwindow *window = createContext();
+  if(window == NULL) {
+    printf("No GL 3.3 context, skipping the upload benchmarks\n");
+  }
+  for(size_t i = 0; window != NULL && i < meshes.size(); i++) {
+    UploadBench bench;
+    bench.mesh = &meshes[i];
+    bench.soa = MeshSoA();
+    meshPoolInit(&bench.pool, meshes[i].positions.size() / 3,
+      meshes[i].indices.size());
+    double bytes = (double) ((meshes[i].positions.size() +
+      meshes[i].texCoords.size()) * sizeof(float) +
+      meshes[i].indices.size() * sizeof(unsigned));
+    runBench("sendMesh/" + meshes[i].name, bytes, uploadOp, &bench);
+    // Interleaved into the mapped buffers
+    if(soaFromMesh(&meshes[i], &bench.soa)) {
+      runBench("sendMeshSoA/" + meshes[i].name, bytes, uploadSoAOp, &bench);
+    }
+    meshSoAFree(&bench.soa);
+    meshPoolDestroy(&bench.pool);
+  }
+  if(window != NULL) {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+  }
+
+  if(jsonPath != NULL && !writeJson(jsonPath)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,313 @@
+#include "synthetic_assets.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+// Output buffer per file, writing millions of short lines
+#define SYNTHETIC_BUFFER_SIZE (1 << 20)
+
+void syntheticObjDefault(SyntheticObj *params) {
+  params->shape = SYNTHETIC_SPHERE;
+  params->triangles = 2000000;
+  params->quads = false;
+  params->groups = 1;
+  params->materials = 0;
+  params->negativeIndices = false;
+}
+
+// Where the faces go, with the group and material sections between them
+struct ObjWriter {
+  FILE *fp;
+  const SyntheticObj *params;
+  size_t vertexCount;
+  size_t faceCount; // Faces in the whole mesh
+  size_t facesWritten;
+  int group;
+};
+
+static void writeVertex(FILE *fp, float x, float y, float z, float u,
+  float v, float nx, float ny, float nz) {
+  fprintf(fp, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", x, y, z,
+    u, v, nx, ny, nz);
+}
+
+// Face over vertices ids[0 .. count - 1] (0 based), counter clockwise seen
+// from the front
+static void writeFace(ObjWriter *writer, const size_t *ids, int count) {
+  const SyntheticObj *params = writer->params;
+  // Start the next group once its share of the faces begins (groups left
+  // with no faces of their own are written empty)
+  while(writer->group < params->groups && writer->facesWritten ==
+    writer->faceCount * writer->group / params->groups) {
+    fprintf(writer->fp, "g group%d\n", writer->group);
+    if(params->materials > 0) {
+      fprintf(writer->fp, "usemtl material%d\n",
+        writer->group % params->materials);
+    }
+    writer->group++;
+  }
+
+  fputc('f', writer->fp);
+  for(int i = 0; i < count; i++) {
+    // Every vertex is written before the faces, so the last one is -1
+    long long index = params->negativeIndices ?
+      (long long) ids[i] - (long long) writer->vertexCount :
+      (long long) ids[i] + 1;
+    fprintf(writer->fp, " %lld/%lld/%lld", index, index, index);
+  }
+  fputc('\n', writer->fp);
+  writer->facesWritten++;
+}
+
+static void writeGrid(ObjWriter *writer) {
+  const SyntheticObj *params = writer->params;
+  // 2 triangles per cell
+  int side = (int) (sqrt(params->triangles / 2.) + .5);
+  if(side < 1) {
+    side = 1;
+  }
+  writer->vertexCount = (size_t) (side + 1) * (side + 1);
+  writer->faceCount = (size_t) side * side * (params->quads ? 1 : 2);
+
+  for(int y = 0; y <= side; y++) {
+    for(int x = 0; x <= side; x++) {
+      float u = (float) x / side, v = (float) y / side;
+      writeVertex(writer->fp, u * 2.f - 1.f, v * 2.f - 1.f, 0.f, u, v, 0.f,
+        0.f, 1.f);
+    }
+  }
+  for(int y = 0; y < side; y++) {
+    for(int x = 0; x < side; x++) {
+      size_t a = (size_t) y * (side + 1) + x;
+      size_t b = a + 1, c = a + side + 1, d = c + 1;
+      if(params->quads) {
+        size_t quad[4] = {a, b, d, c};
+        writeFace(writer, quad, 4);
+      } else {
+        size_t first[3] = {a, b, d};
+        size_t second[3] = {a, d, c};
+        writeFace(writer, first, 3);
+        writeFace(writer, second, 3);
+      }
+    }
+  }
+}
+
+static void writeSphere(ObjWriter *writer) {
+  const SyntheticObj *params = writer->params;
+  // rings latitude bands of 2 * rings segments, about 4 * rings^2 triangles
+  int rings = (int) (sqrt(params->triangles / 4.) + .5);
+  if(rings < 2) {
+    rings = 2;
+  }
+  int segments = 2 * rings;
+  int columns = segments + 1; // The seam is doubled for the texture
+  size_t ringVertices = (size_t) (rings - 1) * columns;
+  // Triangle fans around a vertex at each pole, or one n-gon per cap
+  writer->vertexCount = ringVertices + (params->quads ? 0 : 2);
+  writer->faceCount = (size_t) segments * (rings - 2) *
+    (params->quads ? 1 : 2) + (params->quads ? 2 : 2 * segments);
+
+  const float pi = 3.14159265f;
+  for(int i = 1; i < rings; i++) {
+    float theta = pi * i / rings;
+    for(int j = 0; j <= segments; j++) {
+      float phi = 2.f * pi * j / segments;
+      float x = sinf(theta) * sinf(phi);
+      float y = cosf(theta);
+      float z = sinf(theta) * cosf(phi);
+      writeVertex(writer->fp, x, y, z, (float) j / segments,
+        1.f - (float) i / rings, x, y, z);
+    }
+  }
+  size_t north = ringVertices, south = ringVertices + 1;
+  if(!params->quads) {
+    writeVertex(writer->fp, 0.f, 1.f, 0.f, .5f, 1.f, 0.f, 1.f, 0.f);
+    writeVertex(writer->fp, 0.f, -1.f, 0.f, .5f, 0.f, 0.f, -1.f, 0.f);
+  }
+
+  // Rings run down from the north pole, segments around toward +x
+  size_t lastRing = (size_t) (rings - 2) * columns;
+  if(params->quads) {
+    std::vector<size_t> cap(segments);
+    for(int j = 0; j < segments; j++) {
+      cap[j] = j;
+    }
+    writeFace(writer, &cap[0], segments);
+  } else {
+    for(int j = 0; j < segments; j++) {
+      size_t fan[3] = {(size_t) j, (size_t) j + 1, north};
+      writeFace(writer, fan, 3);
+    }
+  }
+  for(int i = 0; i + 1 < rings - 1; i++) {
+    for(int j = 0; j < segments; j++) {
+      size_t upper = (size_t) i * columns + j;
+      size_t lower = upper + columns;
+      if(params->quads) {
+        size_t quad[4] = {lower, lower + 1, upper + 1, upper};
+        writeFace(writer, quad, 4);
+      } else {
+        size_t first[3] = {lower, lower + 1, upper + 1};
+        size_t second[3] = {lower, upper + 1, upper};
+        writeFace(writer, first, 3);
+        writeFace(writer, second, 3);
+      }
+    }
+  }
+  if(params->quads) {
+    std::vector<size_t> cap(segments);
+    for(int j = 0; j < segments; j++) {
+      cap[j] = lastRing + segments - 1 - j;
+    }
+    writeFace(writer, &cap[0], segments);
+  } else {
+    for(int j = 0; j < segments; j++) {
+      size_t fan[3] = {south, lastRing + j + 1, lastRing + j};
+      writeFace(writer, fan, 3);
+    }
+  }
+}
+
+static bool writeMtl(const std::string &path, int materials) {
+  FILE *fp = fopen(path.c_str(), "w");
+  if(fp == NULL) {
+    fprintf(stderr, "Can't write %s\n", path.c_str());
+    return false;
+  }
+  for(int i = 0; i < materials; i++) {
+    // Spread the diffuse colors around the hue circle
+    float hue = 6.2831853f * i / materials;
+    fprintf(fp, "newmtl material%d\nKa 0 0 0\nKd %.3f %.3f %.3f\n"
+      "Ks 0 0 0\nd 1\n\n", i, .5f + .5f * cosf(hue),
+      .5f + .5f * cosf(hue - 2.0943951f), .5f + .5f * cosf(hue + 2.0943951f));
+  }
+  return fclose(fp) == 0;
+}
+
+bool writeSyntheticObj(const char *path, const SyntheticObj *params) {
+  std::string objPath(path);
+  size_t slash = objPath.find_last_of("/\\");
+  size_t dot = objPath.find_last_of('.');
+  std::string base = dot == std::string::npos ||
+    (slash != std::string::npos && dot < slash) ? objPath :
+    objPath.substr(0, dot);
+  std::string mtlPath = base + ".mtl";
+  if(params->materials > 0 && !writeMtl(mtlPath, params->materials)) {
+    return false;
+  }
+
+  FILE *fp = fopen(path, "w");
+  if(fp == NULL) {
+    fprintf(stderr, "Can't write %s\n", path);
+    return false;
+  }
+  setvbuf(fp, NULL, _IOFBF, SYNTHETIC_BUFFER_SIZE);
+  fprintf(fp, "# Synthetic %s, about %lu triangles\n",
+    params->shape == SYNTHETIC_SPHERE ? "sphere" : "grid",
+    (unsigned long) params->triangles);
+  if(params->materials > 0) {
+    fprintf(fp, "mtllib %s\n", mtlPath.substr(slash == std::string::npos ?
+      0 : slash + 1).c_str());
+  }
+
+  ObjWriter writer;
+  writer.fp = fp;
+  writer.params = params;
+  writer.vertexCount = 0;
+  writer.faceCount = 0;
+  writer.facesWritten = 0;
+  writer.group = 0;
+  if(params->shape == SYNTHETIC_SPHERE) {
+    writeSphere(&writer);
+  } else {
+    writeGrid(&writer);
+  }
+
+  bool ok = !ferror(fp);
+  if(fclose(fp) != 0 || !ok) {
+    fprintf(stderr, "Error writing %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+bool writeSyntheticBmp(const char *path, int width, int height,
+  int bitsPerPixel) {
+  if(width < 1 || height < 1 ||
+    (bitsPerPixel != 8 && bitsPerPixel != 24 && bitsPerPixel != 32)) {
+    fprintf(stderr, "Can't make a %dx%d bmp with %d bits per pixel\n", width,
+      height, bitsPerPixel);
+    return false;
+  }
+  // Rows are padded to 4 bytes
+  uint64_t rowSize = ((uint64_t) width * bitsPerPixel / 8 + 3) & ~3ull;
+  uint64_t dataSize = rowSize * height;
+  uint32_t paletteSize = bitsPerPixel == 8 ? 256 * 4 : 0;
+  uint32_t offset = 54 + paletteSize;
+  if(offset + dataSize > 0xFFFFFFFFull) {
+    fprintf(stderr, "A %dx%d bmp is over the format's 4 GB\n", width,
+      height);
+    return false;
+  }
+
+  FILE *fp = fopen(path, "wb");
+  if(fp == NULL) {
+    fprintf(stderr, "Can't write %s\n", path);
+    return false;
+  }
+  unsigned char header[54] = {'B', 'M'};
+  uint32_t fields[][2] = {
+    {2, (uint32_t) (offset + dataSize)}, // File size
+    {10, offset}, // Offset of the pixels
+    {14, 40}, // Info header size
+    {18, (uint32_t) width},
+    {22, (uint32_t) height},
+    {26, 1 | ((uint32_t) bitsPerPixel << 16)}, // Planes, bits per pixel
+    {34, (uint32_t) dataSize},
+    {46, bitsPerPixel == 8 ? 256u : 0u} // Palette entries
+  };
+  for(size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+    for(int b = 0; b < 4; b++) {
+      header[fields[i][0] + b] = (unsigned char) (fields[i][1] >> (8 * b));
+    }
+  }
+  bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+  for(uint32_t i = 0; ok && i < paletteSize / 4; i++) {
+    unsigned char entry[4] = {(unsigned char) i, (unsigned char) i,
+      (unsigned char) i, 0};
+    ok = fwrite(entry, sizeof(entry), 1, fp) == 1;
+  }
+
+  // Bottom row first, bgr(a)
+  std::vector<unsigned char> row((size_t) rowSize, 0);
+  for(int y = 0; ok && y < height; y++) {
+    for(int x = 0; x < width; x++) {
+      unsigned char r = (unsigned char) ((uint64_t) x * 255 / width);
+      unsigned char g = (unsigned char) ((uint64_t) y * 255 / height);
+      unsigned char b = (unsigned char) ((x ^ y) & 255);
+      if(bitsPerPixel == 8) {
+        row[x] = (unsigned char) ((r + g + b) / 3);
+      } else {
+        unsigned char *pixel = &row[(size_t) x * (bitsPerPixel / 8)];
+        pixel[0] = b;
+        pixel[1] = g;
+        pixel[2] = r;
+        if(bitsPerPixel == 32) {
+          pixel[3] = 255;
+        }
+      }
+    }
+    ok = fwrite(&row[0], row.size(), 1, fp) == 1;
+  }
+  if(fclose(fp) != 0 || !ok) {
+    fprintf(stderr, "Error writing %s\n", path);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,38 @@
+#ifndef SYNTHETIC_ASSETS_H
+#define SYNTHETIC_ASSETS_H
+
+#include <stddef.h>
+
+// Generated meshes and images of any size, for testing the loaders and the
+// renderer at scales the shipped resources don't reach. Used by asset_gen
+// and lab_bench.
+
+enum SyntheticShape {
+  SYNTHETIC_SPHERE, // Latitude/longitude sphere of radius 1
+  SYNTHETIC_GRID // Flat square in the xy plane, -1 .. 1
+};
+
+struct SyntheticObj {
+  SyntheticShape shape;
+  size_t triangles; // Roughly how many the mesh triangulates to
+  bool quads; // Faces as quads (and the sphere's caps as n-gons)
+  int groups; // "g" sections the faces are split over, at least 1
+  int materials; // usemtl names cycled over the groups, 0 for none
+  bool negativeIndices; // Refer to vertices relative to the last one
+};
+
+// 2 million triangles in one group, no materials
+void syntheticObjDefault(SyntheticObj *params);
+
+// Write the mesh with positions, texture coordinates and normals to path.
+// With materials a .mtl file of the same name (extension replaced) is
+// written next to it and named by mtllib. Returns false, printing why, if a
+// file can't be written.
+bool writeSyntheticObj(const char *path, const SyntheticObj *params);
+
+// Write a width x height uncompressed bmp with a color gradient. bitsPerPixel
+// is 8 (gray palette), 24 (what imageLoad reads) or 32.
+bool writeSyntheticBmp(const char *path, int width, int height,
+  int bitsPerPixel);
+
+#endif